@@ -50,6 +50,10 @@ namespace srcstats
     return a < b ? b : a;
   }
 
+  /// @brief The cache line size: the objects written by different threads are aligned to it, 
+  /// so they do not share cache lines (no false sharing).
+  constexpr size_t cache_line_size = 64;
+
   /// @brief Local character type.
   using Character = char;
 
@@ -82,6 +86,20 @@ namespace srcstats
     };
   }
 
+  /// @brief Check if the character is removed by normalization: ASCII codes below 32 (SPACE) except for TAB and LF.
+  [[nodiscard]] constexpr bool is_control(Character ch) noexcept
+  {
+    using namespace characters;
+    return static_cast<unsigned char>(ch) < static_cast<unsigned char>(space) && ch != TAB && ch != LF;
+  }
+
+  /// @brief Check if the character is whitespace for line trimming: ASCII codes up to 32 (SPACE) 
+  /// (the bytes of UTF-8 sequences are not whitespace).
+  [[nodiscard]] constexpr bool is_whitespace(Character ch) noexcept
+  {
+    return static_cast<unsigned char>(ch) <= static_cast<unsigned char>(characters::space);
+  }
+
 }
 
 #endif//SRCSTATS_BASIC_HPP_INCLUDED
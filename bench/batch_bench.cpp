@@ -0,0 +1,160 @@
+/******************************************************************************
+MIT License
+
+Copyright (c) 2024 Dmitry R. Kuvshinov
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+******************************************************************************/
+
+/// @file   batch_bench.cpp
+/// @brief  Analysis time of small files already in memory: one by one (analyze and accumulate each file) 
+/// against batches (see File_type_dispatcher::add_to_batch), optionally with the files cut to a size.
+/// Build with bench/build_bench.sh batch_bench (add -DSRCSTATS_STATIC_LANGUAGES to measure the static dispatch, 
+/// see bench/static_languages_bench.sh) and run:
+///   batch_bench [directory [cut size]]
+/// @author D.R.Kuvshinov kuvshinovdr at yandex.ru
+#include "../file_type.hpp"
+#include "../langs/languages.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+
+
+namespace srcstats
+{
+
+  /// @brief How many files are analyzed.
+  constexpr size_t max_file_count = 20'000;
+
+
+  /// @brief A source file in memory.
+  struct Source_file
+  {
+    File_type type;
+    File_data data;
+  };
+
+
+  /// @brief Make a dispatcher recognizing the supported languages.
+  [[nodiscard]] File_type_dispatcher make_dispatcher()
+  {
+    File_type_dispatcher dispatcher;
+    for (auto const lang: Languages::analyzers())
+      lang->register_file_types(dispatcher);
+    return dispatcher;
+  }
+
+
+  /// @brief Read the recognized files of the tree which may be batched, cut them to cut_size bytes.
+  [[nodiscard]] std::vector<Source_file> read_sources(fs::path const& root, size_t cut_size)
+  {
+    auto const dispatcher = make_dispatcher();
+    std::vector<Source_file> files;
+    for (auto const& entry: fs::recursive_directory_iterator(root, fs::directory_options::skip_permission_denied))
+    {
+      if (files.size() == max_file_count)
+        break;
+
+      auto const type = dispatcher.find(entry.path());
+      if (!type || !entry.is_regular_file() || entry.file_size() > File_batch::max_file_size)
+        continue;
+
+      auto data = File_type_dispatcher::read(entry.path());
+      data.resize(std::min(data.size(), cut_size));
+      files.push_back({ type, std::move(data) });
+    }
+
+    return files;
+  }
+
+
+  /// @brief Run the analysis several times with a new dispatcher each time, return the best time per file in us.
+  [[nodiscard]] double measure(size_t file_count, std::function<void(File_type_dispatcher&)> const& analyze)
+  {
+    using Clock = std::chrono::steady_clock;
+    auto best = std::chrono::duration<double>::max();
+    for (int repeat = 0; repeat < 15; ++repeat)
+    {
+      auto dispatcher  = make_dispatcher();
+      auto const start = Clock::now();
+      analyze(dispatcher);
+      best = std::min(best, std::chrono::duration<double>(Clock::now() - start));
+    }
+
+    return best.count() / static_cast<double>(file_count) * 1e6;
+  }
+
+}
+
+
+int main(int argc, char* argv[])
+{
+  using namespace srcstats;
+  try
+  {
+    auto const files = read_sources(argc > 1 ? argv[1] : "/usr/include", 
+                                    argc > 2 ? std::stoul(argv[2]) : File_batch::max_file_size);
+    if (files.empty())
+    {
+      std::cerr << "No source files up to " << File_batch::max_file_size << " bytes found\n";
+      return 1;
+    }
+
+    auto const one_by_one = measure(files.size(), [&files](File_type_dispatcher& dispatcher)
+      {
+        for (auto const& file: files)
+          dispatcher.accumulate(file.type, File_type_dispatcher::analyze(file.type, String_view(file.data)));
+      });
+
+    auto const batches = measure(files.size(), [&files](File_type_dispatcher& dispatcher)
+      {
+        for (auto const& file: files)
+        {
+          dispatcher.add_to_batch(file.type, [&file](File_batch& batch)
+            {
+              return batch.add(file.data.size(), [&file](Character* out, size_t size)
+                {
+                  std::copy_n(file.data.data(), size, out);
+                  return size;
+                }) == file.data.size();
+            });
+        }
+
+        dispatcher.flush();
+      });
+
+#ifdef SRCSTATS_STATIC_LANGUAGES
+    std::cout << "Static languages, ";
+#else
+    std::cout << "Lang_interface, ";
+#endif
+    std::cout << files.size() << " files, us per file: one by one " << one_by_one << ", batches " << batches << '\n';
+  }
+  catch (std::exception const& e)
+  {
+    std::cerr << e.what() << '\n';
+    return 1;
+  }
+
+  return 0;
+}
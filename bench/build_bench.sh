@@ -0,0 +1,18 @@
+#!/bin/sh
+# Builds a benchmark of bench/ against the sources of srcstats and prints the path of the executable.
+# Usage: bench/build_bench.sh <name> [compiler options] (CXX defaults to g++), for example
+#   $(bench/build_bench.sh walk_bench) /tmp/walk_tree
+#   $(bench/build_bench.sh batch_bench -DSRCSTATS_STATIC_LANGUAGES) /usr/include
+
+set -e
+cd "$(dirname "$0")/.."
+
+NAME=$1
+shift
+CXX=${CXX:-g++}
+OUT=${TMPDIR:-/tmp}/srcstats_bench
+mkdir -p "$OUT"
+
+SOURCES=$(ls *.cpp langs/*/*.cpp | grep -v '^srcstats\.cpp$')
+$CXX -std=c++23 -O2 -pthread "$@" -o "$OUT/$NAME" "bench/$NAME.cpp" $SOURCES >&2
+echo "$OUT/$NAME"
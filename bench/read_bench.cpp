@@ -0,0 +1,146 @@
+/******************************************************************************
+MIT License
+
+Copyright (c) 2024 Dmitry R. Kuvshinov
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+******************************************************************************/
+
+/// @file   read_bench.cpp
+/// @brief  Reading time of the files of a tree: read_file_to_memory one file after another against
+/// Io_uring_reader keeping up to 128 files in flight (one thread, the files are listed in advance).
+/// Build with bench/build_bench.sh read_bench and run (Linux 5.6 or newer, --cold drops the page cache and needs root):
+///   read_bench [--cold] /usr/include
+/// @author D.R.Kuvshinov kuvshinovdr at yandex.ru
+#include "../io_uring_reader.hpp"
+
+#include <chrono>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <vector>
+
+#include <unistd.h>
+
+
+namespace srcstats
+{
+
+  constexpr unsigned io_uring_depth = 128;
+
+
+  /// @brief List the regular files of the tree.
+  [[nodiscard]] std::vector<fs::path> list_files(fs::path const& root)
+  {
+    std::vector<fs::path> files;
+    for (auto const& entry: fs::recursive_directory_iterator(root, fs::directory_options::skip_permission_denied))
+      if (entry.is_regular_file())
+        files.push_back(entry.path());
+    return files;
+  }
+
+
+  /// @brief Write the dirty pages and drop the page cache (needs root).
+  void drop_caches()
+  {
+    ::sync();
+    std::ofstream("/proc/sys/vm/drop_caches") << "3\n";
+  }
+
+
+  /// @brief Read the files one after another.
+  [[nodiscard]] uintmax_t read_one_by_one(std::vector<fs::path> const& files)
+  {
+    uintmax_t bytes = 0;
+    for (auto const& file: files)
+      bytes += read_file_to_memory(file).size();
+    return bytes;
+  }
+
+
+  /// @brief Read the files with io_uring keeping the ring full.
+  [[nodiscard]] uintmax_t read_io_uring(std::vector<fs::path> const& files)
+  {
+    Io_uring_reader reader(io_uring_depth);
+    uintmax_t bytes = 0;
+    auto const on_done = [&bytes](unsigned, Io_uring_reader::Result result)
+      {
+        if (!result)
+          std::rethrow_exception(result.error());
+        bytes += result->size();
+      };
+
+    for (auto next = files.begin(); next != files.end() || reader.in_flight() != 0;)
+    {
+      while (next != files.end() && !reader.full())
+        reader.start(*next++);
+      reader.wait(on_done);
+    }
+
+    return bytes;
+  }
+
+
+  /// @brief Run the reading several times (dropping the page cache before each run if cold), print the best time.
+  void measure(std::string_view name, bool cold, std::function<uintmax_t()> const& read)
+  {
+    using Clock = std::chrono::steady_clock;
+    auto best = std::chrono::duration<double>::max();
+    uintmax_t bytes = 0;
+    for (int repeat = 0; repeat < 3; ++repeat)
+    {
+      if (cold)
+        drop_caches();
+
+      auto const start = Clock::now();
+      bytes = read();
+      best = std::min(best, std::chrono::duration<double>(Clock::now() - start));
+    }
+
+    std::cout << name << ": " << best.count() << "s (" << bytes << " bytes)\n";
+  }
+
+}
+
+
+int main(int argc, char* argv[])
+{
+  using namespace srcstats;
+  try
+  {
+    bool const cold = argc == 3 && argv[1] == "--cold"sv;
+    if (argc != 2 + cold || !io_uring_supported())
+    {
+      std::cerr << "Usage: read_bench [--cold] directory (io_uring is required)\n";
+      return 1;
+    }
+
+    auto const files = list_files(argv[1 + cold]);
+    std::cout << files.size() << " files, " << (cold ? "cold" : "warm") << " page cache\n";
+    measure("read_file_to_memory"sv, cold, [&files] { return read_one_by_one(files); });
+    measure("io_uring"sv,            cold, [&files] { return read_io_uring(files); });
+  }
+  catch (std::exception const& e)
+  {
+    std::cerr << e.what() << '\n';
+    return 1;
+  }
+
+  return 0;
+}
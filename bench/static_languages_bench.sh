@@ -0,0 +1,16 @@
+#!/bin/sh
+# Compares the analysis of small files through Lang_interface with SRCSTATS_STATIC_LANGUAGES:
+# builds bench/batch_bench.cpp both ways (see bench/build_bench.sh) and runs the builds interleaved three times each.
+# Usage: bench/static_languages_bench.sh [directory [cut size]] (CXX defaults to g++)
+
+set -e
+cd "$(dirname "$0")/.."
+
+STATIC=$(bench/build_bench.sh batch_bench -DSRCSTATS_STATIC_LANGUAGES)_static
+mv "${STATIC%_static}" "$STATIC"
+VIRTUAL=$(bench/build_bench.sh batch_bench)
+
+for run in 1 2 3; do
+  "$VIRTUAL" "$@"
+  "$STATIC" "$@"
+done
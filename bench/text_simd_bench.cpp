@@ -0,0 +1,227 @@
+/******************************************************************************
+MIT License
+
+Copyright (c) 2024 Dmitry R. Kuvshinov
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+******************************************************************************/
+
+/// @file   text_simd_bench.cpp
+/// @brief  Throughput of the text kernels (normalization, line splitting, trimming, decommenting) 
+/// at each instruction set level on the C++ headers of a directory with LF, CR LF and mixed line endings.
+/// Build with bench/build_bench.sh text_simd_bench and run (the directory defaults to /usr/include):
+///   text_simd_bench [directory]
+/// @author D.R.Kuvshinov kuvshinovdr at yandex.ru
+#include "../file.hpp"
+#include "../text_simd.hpp"
+#include "../langs/cpp/cpp_decomment.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+
+
+namespace srcstats
+{
+
+  /// @brief How many bytes of headers are concatenated.
+  constexpr size_t text_size = size_t(64) << 20;
+
+  /// @brief Concatenate the .h and .hpp files found in the directory up to text_size bytes (LF line endings), 
+  /// throw if there are none.
+  [[nodiscard]] String read_headers(fs::path const& directory)
+  {
+    String text;
+    for (auto const& entry: fs::recursive_directory_iterator(directory, fs::directory_options::skip_permission_denied))
+    {
+      if (text.size() >= text_size)
+        break;
+
+      auto const extension = entry.path().extension();
+      if (!entry.is_regular_file() || (extension != ".h" && extension != ".hpp"))
+        continue;
+
+      auto const file_data = read_file_to_memory(entry.path());
+      text.append(file_data.data(), file_data.size());
+    }
+
+    if (text.empty())
+      throw std::runtime_error("no .h or .hpp files found in " + directory.string());
+
+    text.resize(static_cast<size_t>(normalize_to(text, text.data()) - text.data()));
+    return text;
+  }
+
+  /// @brief Replace LF with CR LF (every LF if mixed is false, every other one otherwise).
+  [[nodiscard]] String to_crlf(String_view text, bool mixed = false)
+  {
+    String result;
+    result.reserve(text.size() + text.size() / 16);
+    bool odd = false;
+    for (auto const ch: text)
+    {
+      if (ch == characters::LF && (!mixed || (odd = !odd)))
+        result += '\r';
+      result += ch;
+    }
+
+    return result;
+  }
+
+  /// @brief Indent each line by 4 to 32 spaces by the brace depth, append trailing spaces to every third line 
+  /// and an indented blank line after every fifth one (heavily indented code for the trimming).
+  [[nodiscard]] String to_indented(String_view text)
+  {
+    String result;
+    result.reserve(text.size() * 3);
+    size_t depth = 0, line = 0;
+    for (size_t begin = 0; begin < text.size(); ++line)
+    {
+      auto end = text.find(characters::LF, begin);
+      if (end == String_view::npos)
+        end = text.size();
+
+      auto const content = text.substr(begin, end - begin);
+      auto const indent  = 4 * (1 + std::min<size_t>(depth, 7));
+      result.append(indent, ' ').append(content);
+      if (line % 3 == 0)
+        result.append("   ");
+      result += characters::LF;
+      if (line % 5 == 0)
+        result.append(indent, ' ') += characters::LF;
+
+      depth += std::ranges::count(content, '{');
+      depth -= std::min(depth, static_cast<size_t>(std::ranges::count(content, '}')));
+      begin = end + 1;
+    }
+
+    return result;
+  }
+
+  /// @brief Run the function several times, return the best throughput in GB/s.
+  [[nodiscard]] double measure(size_t bytes, std::function<void()> const& run)
+  {
+    using Clock = std::chrono::steady_clock;
+    auto best = std::chrono::duration<double>::max();
+    for (int repeat = 0; repeat < 5; ++repeat)
+    {
+      auto const start = Clock::now();
+      run();
+      best = std::min(best, std::chrono::duration<double>(Clock::now() - start));
+    }
+
+    return static_cast<double>(bytes) / best.count() / 1e9;
+  }
+
+  /// @brief A kernel run on a text at the given level.
+  struct Kernel
+  {
+    std::string                     name;
+    String const*                   text;
+    std::function<void(Simd_level)> run;
+  };
+
+}
+
+
+int main(int argc, char* argv[])
+{
+  using namespace srcstats;
+  try
+  {
+    auto const lf   = read_headers(argc > 1 ? argv[1] : "/usr/include");
+    auto const crlf     = to_crlf(lf);
+    auto const mixed    = to_crlf(lf, true);
+    auto const indented = to_indented(lf);
+    String padded(lf);
+    padded.append(2, characters::NUL);
+    String out(std::max(crlf.size(), indented.size()), characters::NUL);
+    volatile size_t sink = 0;
+
+    std::vector<Kernel> kernels;
+    std::pair<std::string_view, String const*> const line_endings[]
+    {
+      { "LF", &lf }, { "CR LF", &crlf }, { "mixed", &mixed },
+    };
+
+    for (auto const& [ending, text]: line_endings)
+    {
+      kernels.push_back({ "find_control (" + std::string(ending) + ')', text, [&, text](Simd_level level)
+        {
+          // Find every control character, so the CR of each CR LF is a hit.
+          size_t count = 0;
+          for (auto pos = find_control(*text, level); pos != NPOS; ++count)
+          {
+            auto const next = find_control(String_view(*text).substr(pos + 1), level);
+            pos = next == NPOS ? NPOS : pos + 1 + next;
+          }
+          sink = count;
+        } });
+      kernels.push_back({ "copy_without_control (" + std::string(ending) + ')', text, [&, text](Simd_level level)
+        { sink = static_cast<size_t>(copy_without_control(*text, out.data(), level) - out.data()); } });
+    }
+
+    kernels.insert(kernels.end(),
+    {
+      { "accumulate_lines", &lf, [&](Simd_level level)
+        { Statistics_accumulator lines; sink = accumulate_lines(lf, lines, nullptr, 0, level) + lines.count(); } },
+      { "copy_trimmed_lines", &lf, [&](Simd_level level) 
+        { sink = static_cast<size_t>(copy_trimmed_lines(lf, out.data(), level) - out.data()); } },
+      { "copy_trimmed_lines (indented)", &indented, [&](Simd_level level) 
+        { sink = static_cast<size_t>(copy_trimmed_lines(indented, out.data(), level) - out.data()); } },
+      { "Decomment_lexer (C++)", &lf, [&](Simd_level level)
+        { sink = static_cast<size_t>(
+            Decomment_lexer<cpp_lexer_rules>(padded.data(), lf.size(), level).to(out.data()) - out.data()); } },
+      { "Cpp_decomment_stream (16KiB)", &lf, [&](Simd_level level)
+        { 
+          Cpp_decomment_stream stream(level);
+          auto end = out.data();
+          for (size_t at = 0; at < lf.size(); at += analysis_block_size)
+            end = stream(String_view(lf).substr(at, analysis_block_size), end);
+          sink = static_cast<size_t>(stream.finish(end) - out.data());
+        } },
+    });
+
+    std::cout << "Text: " << lf.size() << " bytes, GB/s\n" << std::setw(33) << std::left << "";
+    auto const levels = static_cast<int>(simd_level()) + 1;
+    for (int level = 0; level < levels; ++level)
+      std::cout << std::setw(10) << simd_level_name(static_cast<Simd_level>(level));
+    std::cout << '\n';
+
+    for (auto const& kernel: kernels)
+    {
+      std::cout << std::setw(33) << kernel.name << std::fixed << std::setprecision(2);
+      for (int level = 0; level < levels; ++level)
+        std::cout << std::setw(10) 
+                  << measure(kernel.text->size(), [&] { kernel.run(static_cast<Simd_level>(level)); });
+      std::cout << '\n';
+    }
+  }
+  catch (std::exception const& e)
+  {
+    std::cerr << e.what() << '\n';
+    return 1;
+  }
+
+  return 0;
+}
@@ -0,0 +1,162 @@
+/******************************************************************************
+MIT License
+
+Copyright (c) 2024 Dmitry R. Kuvshinov
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+******************************************************************************/
+
+/// @file   walk_bench.cpp
+/// @brief  Directory traversal time: the native walker (list_directory relative to open descriptors)
+/// against std::filesystem::directory_iterator as the default walk uses them (one thread, files are not opened).
+/// Build with bench/build_bench.sh walk_bench and run (Linux only):
+///   walk_bench --make-tree /tmp/walk_tree   # 2000 directories of 100 empty .txt files
+///   walk_bench /tmp/walk_tree
+/// @author D.R.Kuvshinov kuvshinovdr at yandex.ru
+#include "../native_walk.hpp"
+
+#include <chrono>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <string>
+
+
+namespace srcstats
+{
+
+  /// @brief Files and directories met by a walk.
+  struct Walk_counts
+  {
+    size_t files       = 0;
+    size_t directories = 0;
+  };
+
+
+  /// @brief Walk the tree with std::filesystem::directory_iterator.
+  void walk_filesystem(fs::path const& path, Walk_counts& counts)
+  {
+    for (fs::directory_iterator it(path), end; it != end; ++it)
+    {
+      if (it->is_regular_file())
+      {
+        ++counts.files;
+      }
+      else if (it->is_directory())
+      {
+        ++counts.directories;
+        walk_filesystem(it->path(), counts);
+      }
+    }
+  }
+
+
+  /// @brief Walk the tree with list_directory, opening subdirectories relative to their parents.
+  void walk_native(Directory_handle_sptr const& dir, Walk_counts& counts)
+  {
+    std::vector<String> subdirectories;
+    list_directory(*dir, {
+        [&counts](String_view, uintmax_t) { ++counts.files; },
+        [&subdirectories](String_view name) { subdirectories.emplace_back(name); }
+      });
+
+    for (auto const& name: subdirectories)
+    {
+      ++counts.directories;
+      walk_native(std::make_shared<Directory_handle const>(dir, name), counts);
+    }
+  }
+
+
+  /// @brief Run the walk several times, print the best time.
+  void measure(std::string_view name, std::function<Walk_counts()> const& walk)
+  {
+    using Clock = std::chrono::steady_clock;
+    auto best = std::chrono::duration<double>::max();
+    Walk_counts counts;
+    for (int repeat = 0; repeat < 5; ++repeat)
+    {
+      auto const start = Clock::now();
+      counts = walk();
+      best = std::min(best, std::chrono::duration<double>(Clock::now() - start));
+    }
+
+    std::cout << name << ": " << best.count() << "s (" 
+              << counts.files << " files, " << counts.directories << " directories)\n";
+  }
+
+
+  /// @brief Create the synthetic tree: 20 directories of 100 directories of 100 empty files.
+  void make_tree(fs::path const& root)
+  {
+    for (int outer = 0; outer < 20; ++outer)
+    {
+      for (int inner = 0; inner < 100; ++inner)
+      {
+        auto const dir = root / ("d" + std::to_string(outer)) / ("d" + std::to_string(inner));
+        fs::create_directories(dir);
+        for (int file = 0; file < 100; ++file)
+          std::ofstream(dir / ("f" + std::to_string(file) + ".txt"));
+      }
+    }
+  }
+
+}
+
+
+int main(int argc, char* argv[])
+{
+  using namespace srcstats;
+  try
+  {
+    if (argc == 3 && argv[1] == "--make-tree"sv)
+    {
+      make_tree(argv[2]);
+      return 0;
+    }
+
+    if (argc != 2 || !native_walk_supported())
+    {
+      std::cerr << "Usage: walk_bench [--make-tree] directory (Linux only)\n";
+      return 1;
+    }
+
+    fs::path const root = argv[1];
+    measure("std::filesystem"sv, [&root]
+      {
+        Walk_counts counts;
+        walk_filesystem(root, counts);
+        return counts;
+      });
+
+    measure("native walk"sv, [&root]
+      {
+        Walk_counts counts;
+        walk_native(std::make_shared<Directory_handle const>(root), counts);
+        return counts;
+      });
+  }
+  catch (std::exception const& e)
+  {
+    std::cerr << e.what() << '\n';
+    return 1;
+  }
+
+  return 0;
+}
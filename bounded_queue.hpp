@@ -0,0 +1,165 @@
+/******************************************************************************
+MIT License
+
+Copyright (c) 2024 Dmitry R. Kuvshinov
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+******************************************************************************/
+
+/// @file   bounded_queue.hpp
+/// @brief  A blocking queue of limited capacity connecting pipeline stages.
+/// @author D.R.Kuvshinov kuvshinovdr at yandex.ru
+#ifndef SRCSTATS_BOUNDED_QUEUE_HPP_INCLUDED
+#define SRCSTATS_BOUNDED_QUEUE_HPP_INCLUDED
+
+#include "basic.hpp"
+
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <optional>
+
+
+namespace srcstats
+{
+
+  /// @brief Queue usage counters: they show whether the producers or the consumers are the bottleneck.
+  struct Queue_counters
+  {
+    size_t    pushed      = 0; ///< how many items have been pushed
+    size_t    max_depth   = 0; ///< the maximal count of items waiting in the queue
+    uintmax_t depth_sum   = 0; ///< sum of the queue depths seen by push (for the average)
+    size_t    full_waits  = 0; ///< how many times a producer waited because the queue was full
+    size_t    empty_waits = 0; ///< how many times a consumer waited because the queue was empty
+
+    /// @brief Compute the average queue depth seen by the producers.
+    [[nodiscard]] constexpr double average_depth() const noexcept
+    {
+      return pushed == 0 ? 0.0 : static_cast<double>(depth_sum) / pushed;
+    }
+  };
+
+
+  /// @brief         A multiple producer multiple consumer blocking queue.
+  /// The queue is closed when all its producers have called close().
+  /// @tparam T      item type
+  template <typename T>
+  class Bounded_queue
+  {
+  public:
+    /// @brief           Create an empty queue.
+    /// @param capacity  how many items may wait in the queue (at least one)
+    /// @param producers how many producers are to call close()
+    explicit Bounded_queue(size_t capacity, size_t producers = 1)
+      : _capacity(capacity != 0 ? capacity : 1), _producers(producers) {}
+
+    /// @brief Get the maximal count of waiting items.
+    [[nodiscard]] size_t capacity() const noexcept
+    {
+      return _capacity;
+    }
+
+    /// @brief Put an item, wait while the queue is full.
+    void push(T item)
+    {
+      std::unique_lock lock(_mutex);
+      if (_items.size() == _capacity)
+      {
+        ++_counters.full_waits;
+        _not_full.wait(lock, [this] { return _items.size() < _capacity; });
+      }
+
+      _items.push_back(std::move(item));
+      auto const depth = _items.size();
+      ++_counters.pushed;
+      _counters.depth_sum += depth;
+      _counters.max_depth  = max(_counters.max_depth, depth);
+
+      lock.unlock();
+      _not_empty.notify_one();
+    }
+
+    /// @brief  Take an item, wait while the queue is empty and not closed.
+    /// @return the item or nothing if the queue is closed and empty
+    [[nodiscard]] std::optional<T> pop()
+    {
+      std::unique_lock lock(_mutex);
+      if (_items.empty() && _producers != 0)
+      {
+        ++_counters.empty_waits;
+        _not_empty.wait(lock, [this] { return !_items.empty() || _producers == 0; });
+      }
+
+      if (_items.empty())
+        return std::nullopt;
+
+      std::optional<T> result(std::move(_items.front()));
+      _items.pop_front();
+
+      lock.unlock();
+      _not_full.notify_one();
+      return result;
+    }
+
+    /// @brief  Take an item if there is one, do not wait.
+    /// @return the item or nothing if the queue is empty at the moment
+    [[nodiscard]] std::optional<T> try_pop()
+    {
+      std::unique_lock lock(_mutex);
+      if (_items.empty())
+        return std::nullopt;
+
+      std::optional<T> result(std::move(_items.front()));
+      _items.pop_front();
+
+      lock.unlock();
+      _not_full.notify_one();
+      return result;
+    }
+
+    /// @brief Called by a producer which is not going to push anymore.
+    void close()
+    {
+      std::unique_lock lock(_mutex);
+      if (_producers != 0 && --_producers == 0)
+      {
+        lock.unlock();
+        _not_empty.notify_all();
+      }
+    }
+
+    /// @brief Get a copy of the usage counters.
+    [[nodiscard]] Queue_counters counters() const
+    {
+      std::scoped_lock lock(_mutex);
+      return _counters;
+    }
+
+  private:
+    mutable std::mutex      _mutex;
+    std::condition_variable _not_full, _not_empty;
+    std::deque<T>           _items;
+    size_t                  _capacity;
+    size_t                  _producers;
+    Queue_counters          _counters;
+  };
+
+}
+
+#endif//SRCSTATS_BOUNDED_QUEUE_HPP_INCLUDED
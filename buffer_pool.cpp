@@ -0,0 +1,105 @@
+/******************************************************************************
+MIT License
+
+Copyright (c) 2024 Dmitry R. Kuvshinov
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+******************************************************************************/
+/// @file   buffer_pool.cpp
+/// @brief  Reusable file contents buffers, buffer_pool.hpp implementation.
+/// @author D.R.Kuvshinov kuvshinovdr at yandex.ru
+
+#include "buffer_pool.hpp"
+
+#include <bit>
+
+
+namespace srcstats
+{
+
+  namespace
+  {
+
+    /// @brief Get the smallest size class able to store size bytes (may be out of range).
+    [[nodiscard]] constexpr unsigned size_class(size_t size) noexcept
+    {
+      return size <= Buffer_pool::minimal_capacity ? 0 
+           : static_cast<unsigned>(std::bit_width((size - 1) / Buffer_pool::minimal_capacity));
+    }
+
+    /// @brief Get the largest size class whose buffers fit into the capacity (may be out of range).
+    [[nodiscard]] constexpr unsigned capacity_class(size_t capacity) noexcept
+    {
+      return static_cast<unsigned>(std::bit_width(capacity / Buffer_pool::minimal_capacity)) - 1;
+    }
+
+  }
+
+
+  Buffer_pool::Buffer Buffer_pool::borrow(size_t size)
+  {
+    auto const index = size_class(size);
+    if (index < size_classes && !_free[index].empty())
+    {
+      ++_hits;
+      auto data = std::move(_free[index].back());
+      _free[index].pop_back();
+      return Buffer(this, std::move(data));
+    }
+
+    ++_misses;
+    String data;
+    data.reserve(index < size_classes ? minimal_capacity << index : size);
+    return Buffer(this, std::move(data));
+  }
+
+
+  Buffer_pool_counters Buffer_pool::counters() const noexcept
+  {
+    Buffer_pool_counters result { .hits = _hits, .misses = _misses };
+    for (auto& buffers: _free)
+    {
+      result.kept += buffers.size();
+      for (auto& buffer: buffers)
+        result.kept_bytes += buffer.capacity();
+    }
+
+    return result;
+  }
+
+
+  void Buffer_pool::_give_back(String data) noexcept
+  {
+    // A buffer could grow while it was borrowed, so it is classified by its current capacity.
+    auto const index = capacity_class(data.capacity());
+    if (index >= size_classes)
+      return;
+
+    data.clear();
+    try
+    {
+      _free[index].push_back(std::move(data));
+    }
+    catch (...)
+    {
+      // The buffer is just freed.
+    }
+  }
+
+}
@@ -0,0 +1,152 @@
+/******************************************************************************
+MIT License
+
+Copyright (c) 2024 Dmitry R. Kuvshinov
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+******************************************************************************/
+/// @file   buffer_pool.hpp
+/// @brief  Reusable file contents buffers sorted by size classes.
+/// @author D.R.Kuvshinov kuvshinovdr at yandex.ru
+#ifndef SRCSTATS_BUFFER_POOL_HPP_INCLUDED
+#define SRCSTATS_BUFFER_POOL_HPP_INCLUDED
+
+#include "basic.hpp"
+
+#include <array>
+#include <utility>
+#include <vector>
+
+
+namespace srcstats
+{
+
+  /// @brief Buffer pool usage counters.
+  struct Buffer_pool_counters
+  {
+    size_t    hits       = 0; ///< how many buffers have been reused
+    size_t    misses     = 0; ///< how many buffers have been allocated
+    size_t    kept       = 0; ///< how many buffers are kept by the pool
+    uintmax_t kept_bytes = 0; ///< the total capacity of the kept buffers
+
+    /// @brief Add the counters of another pool.
+    constexpr Buffer_pool_counters& operator()(Buffer_pool_counters const& other) noexcept
+    {
+      hits       += other.hits;
+      misses     += other.misses;
+      kept       += other.kept;
+      kept_bytes += other.kept_bytes;
+      return *this;
+    }
+  };
+
+
+  /// @brief Reusable buffers for file contents, so files are read without allocating and zero-filling memory.
+  /// A buffer is borrowed for one file and returned to the pool when the Buffer object is destroyed.
+  /// Buffers are grouped by size classes (powers of two), all returned buffers are kept,
+  /// so the pool stays at its high-water mark. The pool is to be used by one thread (e.g. one worker).
+  class Buffer_pool
+  {
+  public:
+    /// @brief The capacity of the smallest size class.
+    static constexpr size_t minimal_capacity = size_t(4) << 10;
+
+    /// @brief How many size classes are there, larger buffers are not kept.
+    static constexpr unsigned size_classes = 14;
+
+    /// @brief A borrowed buffer, it is returned to its pool by the destructor.
+    class Buffer
+    {
+    public:
+      Buffer(Buffer&& other) noexcept
+        : _pool(std::exchange(other._pool, nullptr)), _data(std::move(other._data)) {}
+
+      Buffer& operator=(Buffer&& other) noexcept
+      {
+        if (this != &other)
+        {
+          _release();
+          _pool = std::exchange(other._pool, nullptr);
+          _data = std::move(other._data);
+        }
+
+        return *this;
+      }
+
+      ~Buffer()
+      {
+        _release();
+      }
+
+      /// @brief Access the buffer contents.
+      [[nodiscard]] String& operator*() noexcept
+      {
+        return _data;
+      }
+
+      /// @brief Access the buffer contents.
+      [[nodiscard]] String* operator->() noexcept
+      {
+        return &_data;
+      }
+
+    private:
+      friend class Buffer_pool;
+
+      Buffer_pool* _pool;
+      String       _data;
+
+      Buffer(Buffer_pool* pool, String data) noexcept
+        : _pool(pool), _data(std::move(data)) {}
+
+      void _release() noexcept
+      {
+        if (_pool)
+          _pool->_give_back(std::move(_data));
+        _pool = nullptr;
+      }
+    };
+
+    Buffer_pool() = default;
+    Buffer_pool(Buffer_pool const&)            = delete;
+    Buffer_pool& operator=(Buffer_pool const&) = delete;
+
+    /// @brief A pool may be moved only while none of its buffers is borrowed.
+    Buffer_pool(Buffer_pool&&)                 = default;
+    Buffer_pool& operator=(Buffer_pool&&)      = default;
+
+    /// @brief      Borrow an empty buffer which can store at least the given count of bytes without reallocation.
+    /// The pool must outlive the buffer.
+    /// @param size the required capacity
+    [[nodiscard]] Buffer borrow(size_t size);
+
+    /// @brief Get the usage counters.
+    [[nodiscard]] Buffer_pool_counters counters() const noexcept;
+
+  private:
+    std::array<std::vector<String>, size_classes> _free;
+    size_t                                        _hits   = 0;
+    size_t                                        _misses = 0;
+
+    void _give_back(String data) noexcept;
+  };
+
+}
+
+#endif//SRCSTATS_BUFFER_POOL_HPP_INCLUDED
@@ -0,0 +1,243 @@
+/******************************************************************************
+MIT License
+
+Copyright (c) 2024 Dmitry R. Kuvshinov
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+******************************************************************************/
+
+/// @file   detect.cpp
+/// @brief  Content based language detection implementation.
+/// @author D.R.Kuvshinov kuvshinovdr at yandex.ru
+
+#include "detect.hpp"
+#include "sniff.hpp"
+#include "utf8.hpp"
+
+#include <algorithm>
+
+
+namespace srcstats
+{
+
+  using namespace characters;
+
+  namespace
+  {
+
+    /// @brief Characters separating the words of shebangs and modelines.
+    constexpr auto blanks = " \t\r"sv;
+
+
+    /// @brief Remove blanks from both ends.
+    [[nodiscard]] String_view trim(String_view text) noexcept
+    {
+      text.remove_prefix(min(text.find_first_not_of(blanks), text.size()));
+      text.remove_suffix(text.size() - min(text.find_last_not_of(blanks) + 1, text.size()));
+      return text;
+    }
+
+
+    /// @brief Get the prefix of the text consisting of the given count of lines.
+    [[nodiscard]] String_view first_lines(String_view text, size_t count) noexcept
+    {
+      size_t end = 0;
+      for (; count != 0 && end < text.size(); --count)
+        end = min(text.find(LF, end), text.size()) + 1;
+      return text.substr(0, end);
+    }
+
+
+    /// @brief Compare ignoring the case of ASCII letters, lower is expected in lower case.
+    [[nodiscard]] bool equals_ignoring_case(String_view text, std::string_view lower) noexcept
+    {
+      return std::ranges::equal(text, lower, [](Character a, char b)
+        {
+          return (a >= 'A' && a <= 'Z' ? static_cast<char>(a - 'A' + 'a') : a) == b;
+        });
+    }
+
+
+    /// @brief Check if the language signature lists the name (ignoring the case).
+    [[nodiscard]] bool is_named(Content_signature const& signature, String_view name) noexcept
+    {
+      return std::ranges::any_of(signature.names, 
+               [name](std::string_view known) { return equals_ignoring_case(name, known); });
+    }
+
+
+    /// @brief Count the occurrences of the token in the text.
+    [[nodiscard]] size_t count_occurrences(String_view text, std::string_view token) noexcept
+    {
+      size_t count = 0;
+      for (auto pos = text.find(token); pos != NPOS; pos = text.find(token, pos + token.size()))
+        ++count;
+      return count;
+    }
+
+
+    /// @brief Get the Emacs mode of the line: -*- mode -*- or -*- var: value; mode: mode -*-.
+    [[nodiscard]] String_view emacs_mode(String_view line) noexcept
+    {
+      auto const open  = line.find("-*-"sv);
+      auto const close = open == NPOS ? NPOS : line.find("-*-"sv, open + 3);
+      if (close == NPOS)
+        return {};
+
+      auto const vars = line.substr(open + 3, close - open - 3);
+      if (vars.find(':') == NPOS)
+        return trim(vars);
+
+      for (size_t from = 0; from < vars.size();)
+      {
+        auto const to    = min(vars.find(';', from), vars.size());
+        auto const var   = vars.substr(from, to - from);
+        auto const colon = var.find(':');
+        if (colon != NPOS && equals_ignoring_case(trim(var.substr(0, colon)), "mode"sv))
+          return trim(var.substr(colon + 1));
+        from = to + 1;
+      }
+
+      return {};
+    }
+
+
+    /// @brief Get the file type of the Vim modeline of the line: vim: set ft=type: or vi: filetype=type.
+    [[nodiscard]] String_view vim_file_type(String_view line) noexcept
+    {
+      for (auto const marker: { "vim:"sv, "vi:"sv, "ex:"sv })
+      {
+        auto const pos = line.find(marker);
+        if (pos == NPOS || (pos != 0 && blanks.find(line[pos - 1]) == NPOS))
+          continue;
+
+        auto const options = line.substr(pos + marker.size());
+        for (size_t from = 0; from < options.size();)
+        {
+          auto const to     = min(options.find_first_of(" \t\r:"sv, from), options.size());
+          auto const option = options.substr(from, to - from);
+          for (auto const key: { "ft="sv, "filetype="sv })
+            if (option.starts_with(key))
+              return option.substr(key.size());
+          from = to + 1;
+        }
+      }
+
+      return {};
+    }
+
+  }
+
+
+  String_view shebang_interpreter(String_view head) noexcept
+  {
+    if (!head.starts_with("#!"sv))
+      return {};
+
+    auto const line = first_lines(head, 1).substr(2);
+    bool       env  = false;
+    for (size_t from = line.find_first_not_of(" \t\r\n"sv); from < line.size();)
+    {
+      auto const to   = min(line.find_first_of(" \t\r\n"sv, from), line.size());
+      auto const word = line.substr(from, to - from);
+      auto const name = word.substr(word.rfind(slash) + 1);
+      from = line.find_first_not_of(" \t\r\n"sv, to);
+
+      // env runs the command following its options and variable assignments.
+      if (!env && name == "env"sv)
+        env = true;
+      else if (!env || (!word.starts_with('-') && word.find('=') == NPOS))
+        return name;
+    }
+
+    return {};
+  }
+
+
+  String_view modeline_mode(String_view head) noexcept
+  {
+    auto const emacs_lines = first_lines(head, 2);
+    for (size_t from = 0; from < emacs_lines.size();)
+    {
+      auto const to = min(emacs_lines.find(LF, from), emacs_lines.size());
+      if (auto const mode = emacs_mode(emacs_lines.substr(from, to - from)); !mode.empty())
+        return mode;
+      from = to + 1;
+    }
+
+    auto const vim_lines = first_lines(head, 5);
+    for (size_t from = 0; from < vim_lines.size();)
+    {
+      auto const to = min(vim_lines.find(LF, from), vim_lines.size());
+      if (auto const type = vim_file_type(vim_lines.substr(from, to - from)); !type.empty())
+        return type;
+      from = to + 1;
+    }
+
+    return {};
+  }
+
+
+  Detected_type detect_language(String_view head, std::span<Lang_interface const* const> langs) noexcept
+  {
+    std::array<Character, Utf16_transcoder::max_output_size(sniff_size)> text;
+    head = decode_head(head.substr(0, sniff_size), text.data());
+    if (head.find(NUL) != NPOS)
+      return {};
+
+    // A named language is trusted: a script of another language is not detected by its keywords.
+    for (auto const& [name, confidence]: { std::pair{ shebang_interpreter(head), shebang_confidence },
+                                          std::pair{ modeline_mode(head),       modeline_confidence } })
+    {
+      if (name.empty())
+        continue;
+
+      for (auto const lang: langs)
+        if (auto const signature = lang->content_signature(); is_named(signature, name))
+          return { lang, signature.subtype, confidence };
+      return {};
+    }
+
+    Detected_type best;
+    size_t        best_count = 0, second_count = 0;
+    for (auto const lang: langs)
+    {
+      auto const signature = lang->content_signature();
+      size_t     count     = 0;
+      for (auto const keyword: signature.keywords)
+        count += count_occurrences(head, keyword);
+
+      if (count > best_count)
+      {
+        second_count = best_count;
+        best_count   = count;
+        best         = { lang, signature.subtype };
+      }
+      else
+      {
+        second_count = max(second_count, count);
+      }
+    }
+
+    if (best_count != 0)
+      best.confidence = static_cast<double>(best_count - second_count) / (static_cast<double>(best_count) + keyword_prior);
+    return best;
+  }
+
+}
@@ -0,0 +1,87 @@
+/******************************************************************************
+MIT License
+
+Copyright (c) 2024 Dmitry R. Kuvshinov
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+******************************************************************************/
+
+/// @file   detect.hpp
+/// @brief  Detect the language of a file without a known extension by its contents.
+/// @author D.R.Kuvshinov kuvshinovdr at yandex.ru
+#ifndef SRCSTATS_DETECT_HPP_INCLUDED
+#define SRCSTATS_DETECT_HPP_INCLUDED
+
+#include "basic.hpp"
+#include "langs/lang_interface.hpp"
+
+#include <span>
+
+
+namespace srcstats
+{
+
+  /// @brief The confidence of the language named by the shebang interpreter.
+  constexpr double shebang_confidence   = 1.0;
+
+  /// @brief The confidence of the language named by an Emacs or Vim modeline.
+  constexpr double modeline_confidence  = 0.9;
+
+  /// @brief Files detected with at least this confidence are analyzed.
+  constexpr double accepted_confidence  = 0.5;
+
+  /// @brief Files detected with at least this confidence make their directory prefer the language 
+  /// (the weaker detections of the same language in the directory are accepted too).
+  constexpr double directory_confidence = 0.75;
+
+  /// @brief The keyword confidence is (best - second) / (best + keyword_prior) where best and second are
+  /// the counts of the keywords of the two best matching languages, so a few keywords are not enough.
+  constexpr double keyword_prior        = 4.0;
+
+
+  /// @brief The language detected by the file contents.
+  struct Detected_type
+  {
+    Lang_interface const* lang       = nullptr;
+    int                   subtype    = 0;
+    double                confidence = 0.0;   // from 0 (not detected) to 1 (named by the shebang)
+  };
+
+
+  /// @brief      Get the interpreter name of the shebang line (#!/usr/bin/env -S dotnet-script gives dotnet-script).
+  /// @param head the first bytes of the file
+  /// @return     the name without the directory or empty if there is no shebang
+  [[nodiscard]] String_view shebang_interpreter(String_view head) noexcept;
+
+  /// @brief      Get the mode of an Emacs modeline (-*- C++ -*-, -*- mode: c++ -*-) in the first two lines 
+  /// or the file type of a Vim modeline (vim: set ft=cpp:) in the first five lines.
+  /// @param head the first bytes of the file
+  /// @return     the mode as written or empty if there is no modeline
+  [[nodiscard]] String_view modeline_mode(String_view head) noexcept;
+
+  /// @brief       Detect the language of a text by the shebang, a modeline or the keywords (see Content_signature).
+  /// Texts containing NUL characters are not detected (UTF-16 heads with a byte order mark are transcoded first).
+  /// @param head  the first bytes of the file
+  /// @param langs the candidate languages
+  /// @return      the best matching language and the confidence, the language is null if nothing matches
+  [[nodiscard]] Detected_type detect_language(String_view head, std::span<Lang_interface const* const> langs) noexcept;
+
+}
+
+#endif//SRCSTATS_DETECT_HPP_INCLUDED
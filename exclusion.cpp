@@ -0,0 +1,377 @@
+/******************************************************************************
+MIT License
+
+Copyright (c) 2024 Dmitry R. Kuvshinov
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+******************************************************************************/
+
+/// @file   exclusion.cpp
+/// @brief  Excluded paths automaton, exclusion.hpp implementation.
+/// @author D.R.Kuvshinov kuvshinovdr at yandex.ru
+
+#include "exclusion.hpp"
+
+#include <algorithm>
+
+
+namespace srcstats
+{
+
+  Component_glob::Component_glob(String_view pattern)
+  {
+    for (size_t i = 0; i < pattern.size(); ++i)
+    {
+      auto& token = _tokens.emplace_back();
+      switch (auto const ch = static_cast<unsigned char>(pattern[i]))
+      {
+      case '*':
+        token.is_star = true;
+        break;
+
+      case '?':
+        token.set.set();
+        break;
+
+      case '[':
+        if (auto const close = pattern.find(']', i + 2); close != NPOS)
+        {
+          auto const negate = pattern[i + 1] == '!' || pattern[i + 1] == '^';
+          for (auto j = i + 1 + negate; j < close; ++j)
+          {
+            auto const from = static_cast<unsigned char>(pattern[j]);
+            if (j + 2 < close && pattern[j + 1] == '-')
+            {
+              auto const to = static_cast<unsigned char>(pattern[j + 2]);
+              for (unsigned c = from; c <= to; ++c)
+                token.set.set(c);
+              j += 2;
+            }
+            else
+            {
+              token.set.set(from);
+            }
+          }
+
+          if (negate)
+            token.set.flip();
+          i = close;
+          break;
+        }
+        [[fallthrough]]; // unmatched [ is an ordinary character
+
+      default:
+        token.set.set(ch);
+      }
+    }
+
+    // Recognize literal, prefix* and *suffix.
+    auto const is_literal = [](Token const& t) { return !t.is_star && t.set.count() == 1; };
+    auto const literal    = [&](auto from, auto to)
+      {
+        for (auto it = from; it != to; ++it)
+          for (unsigned c = 0; c < 256; ++c)
+            if (it->set.test(c))
+              _literal += static_cast<Character>(c);
+      };
+
+    if (std::all_of(_tokens.begin(), _tokens.end(), is_literal))
+    {
+      _kind = Kind::literal;
+      literal(_tokens.begin(), _tokens.end());
+    }
+    else if (_tokens.size() > 1 && _tokens.back().is_star 
+     && std::all_of(_tokens.begin(), _tokens.end() - 1, is_literal))
+    {
+      _kind = Kind::prefix;
+      literal(_tokens.begin(), _tokens.end() - 1);
+    }
+    else if (_tokens.size() > 1 && _tokens.front().is_star
+          && std::all_of(_tokens.begin() + 1, _tokens.end(), is_literal))
+    {
+      _kind = Kind::suffix;
+      literal(_tokens.begin() + 1, _tokens.end());
+    }
+  }
+
+
+  bool Component_glob::matches(String_view name) const noexcept
+  {
+    switch (_kind)
+    {
+    case Kind::literal:
+      return name == _literal;
+    case Kind::prefix:
+      return name.starts_with(_literal);
+    case Kind::suffix:
+      return name.ends_with(_literal);
+    default:
+      return _matches_tokens(name);
+    }
+  }
+
+
+  bool Component_glob::_matches_tokens(String_view name) const noexcept
+  {
+    // Greedy matching with backtracking to the last star: O(pattern * name) in the worst case.
+    size_t t = 0, n = 0, star_t = NPOS, star_n = 0;
+    while (n < name.size())
+    {
+      if (t < _tokens.size() && _tokens[t].is_star)
+      {
+        star_t = t++;
+        star_n = n;
+      }
+      else if (t < _tokens.size() && _tokens[t].set.test(static_cast<unsigned char>(name[n])))
+      {
+        ++t;
+        ++n;
+      }
+      else if (star_t != NPOS)
+      {
+        t = star_t + 1;
+        n = ++star_n;
+      }
+      else
+      {
+        return false;
+      }
+    }
+
+    while (t < _tokens.size() && _tokens[t].is_star)
+      ++t;
+    return t == _tokens.size();
+  }
+
+
+  Exclusion_matcher::Exclusion_matcher()
+  {
+    (void)_new_node(); // absolute_root
+    (void)_new_node(); // relative_root
+  }
+
+
+  unsigned Exclusion_matcher::_new_node()
+  {
+    _nodes.emplace_back();
+    return static_cast<unsigned>(_nodes.size() - 1);
+  }
+
+
+  void Exclusion_matcher::add(String_view pattern)
+  {
+    std::filesystem::path const path(pattern);
+
+    std::vector<String> components;
+    size_t              separated = 0; // how many components including "."
+    for (auto const& component: path)
+    {
+      auto str = component.string();
+      if (str.empty())
+        continue;
+
+      ++separated;
+      if (str != "."sv)
+        components.emplace_back(std::move(str));
+    }
+
+    if (components.empty())
+      return;
+
+    auto node = relative_root;
+    if (path.has_root_path())
+      node = absolute_root;
+    else if (separated == 1)
+      components.insert(components.begin(), "**");
+
+    for (auto const& component: components)
+    {
+      unsigned next = no_node;
+      if (component == "**"sv)
+      {
+        if (_nodes[node].globstar == no_node)
+        {
+          next = _new_node();
+          _nodes[next].is_globstar = true;
+          _nodes[node].globstar    = next;
+        }
+
+        next = _nodes[node].globstar;
+      }
+      else if (Component_glob::is_glob(component))
+      {
+        next = _new_node();
+        _nodes[node].globs.emplace_back(Component_glob(component), next);
+      }
+      else if (auto const it = _nodes[node].literals.find(component); it != _nodes[node].literals.end())
+      {
+        next = it->second;
+      }
+      else
+      {
+        next = _new_node();
+        _nodes[node].literals.emplace(component, next);
+      }
+
+      node = next;
+    }
+
+    _nodes[node].accepting = true;
+    ++_pattern_count;
+  }
+
+
+  void Exclusion_matcher::_add_closure(State& state, unsigned node) const
+  {
+    for (; node != no_node; node = _nodes[node].globstar)
+      state.push_back(node);
+  }
+
+
+  void Exclusion_matcher::_advance(State const& from, String_view name, State& to) const
+  {
+    to.clear();
+    for (auto const id: from)
+    {
+      auto const& node = _nodes[id];
+      if (node.is_globstar)
+        _add_closure(to, id);
+
+      if (auto const it = node.literals.find(name); it != node.literals.end())
+        _add_closure(to, it->second);
+
+      for (auto const& [glob, next]: node.globs)
+        if (glob.matches(name))
+          _add_closure(to, next);
+    }
+
+    std::sort(to.begin(), to.end());
+    to.erase(std::unique(to.begin(), to.end()), to.end());
+  }
+
+
+  bool Exclusion_matcher::_is_accepting(State const& state) const noexcept
+  {
+    return std::any_of(state.begin(), state.end(), 
+        [this](unsigned id) { return _nodes[id].accepting; });
+  }
+
+
+  Exclusion_matcher::State& Exclusion_matcher::_scratch() noexcept
+  {
+    // Advancing by each directory entry reuses the storage of the walker thread.
+    thread_local State scratch;
+    return scratch;
+  }
+
+
+  void Exclusion_matcher::_walk_path(std::filesystem::path const& path, Step& step) const
+  {
+    auto& next = _scratch();
+    for (auto const& component: path)
+    {
+      if (step.state.empty() || step.excluded)
+        return;
+
+      if (auto const str = component.string(); !str.empty() && str != "."sv)
+      {
+        _advance(step.state, str, next);
+        step.state.swap(next);
+        step.excluded = _is_accepting(step.state);
+      }
+    }
+  }
+
+
+  Exclusion_matcher::Step Exclusion_matcher::root(std::filesystem::path const& root) const
+  {
+    if (empty())
+      return {};
+
+    // Absolute patterns are matched against the absolute root path first.
+    Step result;
+    _add_closure(result.state, absolute_root);
+    _walk_path(std::filesystem::absolute(root).lexically_normal(), result);
+
+    if (result.excluded)
+      return result;
+
+    // Relative patterns are matched against the root as it has been passed (e.g. src/gen under src).
+    if (root.is_relative())
+    {
+      Step relative;
+      _add_closure(relative.state, relative_root);
+      _walk_path(root.lexically_normal(), relative);
+      if (relative.excluded)
+        return relative;
+
+      result.state.insert(result.state.end(), relative.state.begin(), relative.state.end());
+    }
+
+    _add_closure(result.state, relative_root);
+    std::sort(result.state.begin(), result.state.end());
+    result.state.erase(std::unique(result.state.begin(), result.state.end()), result.state.end());
+    return result;
+  }
+
+
+  Exclusion_matcher::Step Exclusion_matcher::step(State const& state, String_view name) const
+  {
+    Step result;
+    if (!state.empty())
+    {
+      auto& next = _scratch();
+      _advance(state, name, next);
+      result.excluded = _is_accepting(next);
+      if (!result.excluded)
+        result.state = next; // the only allocation: the entry keeps its own state
+    }
+
+    return result;
+  }
+
+
+  bool Exclusion_matcher::excludes(State const& state, String_view name) const
+  {
+    if (state.empty())
+      return false;
+
+    auto& next = _scratch();
+    _advance(state, name, next);
+    return _is_accepting(next);
+  }
+
+
+  bool Exclusion_matcher::excludes(std::filesystem::path const& path) const
+  {
+    if (empty())
+      return false;
+
+    Step absolute;
+    _add_closure(absolute.state, absolute_root);
+    _walk_path(std::filesystem::absolute(path).lexically_normal(), absolute);
+
+    Step relative;
+    _add_closure(relative.state, relative_root);
+    _walk_path(path, relative);
+
+    return absolute.excluded || relative.excluded;
+  }
+
+}
@@ -0,0 +1,173 @@
+/******************************************************************************
+MIT License
+
+Copyright (c) 2024 Dmitry R. Kuvshinov
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+******************************************************************************/
+
+/// @file   exclusion.hpp
+/// @brief  Excluded paths: glob patterns compiled into a path component automaton.
+/// @author D.R.Kuvshinov kuvshinovdr at yandex.ru
+#ifndef SRCSTATS_EXCLUSION_HPP_INCLUDED
+#define SRCSTATS_EXCLUSION_HPP_INCLUDED
+
+#include "basic.hpp"
+
+#include <bitset>
+#include <filesystem>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+
+
+namespace srcstats
+{
+
+  /// @brief A compiled glob pattern matching one path component.
+  /// Supported: * (any characters), ? (any character), [abc], [a-z], [!abc] (character sets).
+  class Component_glob
+  {
+  public:
+    /// @brief         Compile a pattern.
+    /// @param pattern the pattern, it should not contain path separators
+    explicit Component_glob(String_view pattern);
+
+    /// @brief Check if the pattern has any special characters.
+    [[nodiscard]] static bool is_glob(String_view pattern) noexcept
+    {
+      return pattern.find_first_of("*?["sv) != NPOS;
+    }
+
+    /// @brief Check if the name matches the pattern.
+    [[nodiscard]] bool matches(String_view name) const noexcept;
+
+  private:
+    /// @brief A single pattern element: a character set or a star.
+    struct Token
+    {
+      std::bitset<256> set;
+      bool             is_star = false;
+    };
+
+    /// @brief Frequent special cases checked without the general matcher.
+    enum class Kind { general, literal, prefix, suffix };
+
+    std::vector<Token> _tokens;
+    String             _literal; // the literal part for literal, prefix* and *suffix patterns
+    Kind               _kind = Kind::general;
+
+    [[nodiscard]] bool _matches_tokens(String_view name) const noexcept;
+  };
+
+
+  /// @brief Compiled exclusion patterns.
+  /// Patterns are split into path components which are put into a trie (literal components are looked up 
+  /// in a hash table, glob components are tested one by one, ** matches any count of components).
+  /// The walker keeps the automaton state for each directory and advances it by one component per entry,
+  /// so checking a path costs O(depth) and excluded directories are never opened.
+  ///
+  /// A pattern without separators (e.g. *.pb.h or build-*) matches at any depth.
+  /// Other relative patterns (e.g. ./build or src/gen or **/third_party/**) are anchored both at the current 
+  /// directory (matching paths as they are passed by the user) and at each walked root, 
+  /// absolute patterns are matched against absolute paths.
+  class Exclusion_matcher
+  {
+  public:
+    /// @brief The automaton state: the sorted trie nodes matching the path walked so far.
+    /// An empty state means nothing below can be excluded.
+    using State = std::vector<unsigned>;
+
+    /// @brief The result of advancing the state by one or more path components.
+    struct Step
+    {
+      State state;
+      bool  excluded = false;
+    };
+
+
+    Exclusion_matcher();
+
+    /// @brief Check if no patterns have been added.
+    [[nodiscard]] bool empty() const noexcept
+    {
+      return _pattern_count == 0;
+    }
+
+    /// @brief         Compile and add a pattern.
+    /// @param pattern glob pattern or path
+    void add(String_view pattern);
+
+    /// @brief      Get the state for a walk starting at the given root directory.
+    /// @param root the root directory as passed by the user
+    /// @return     the state and whether the root itself is excluded
+    [[nodiscard]] Step root(std::filesystem::path const& root) const;
+
+    /// @brief       Advance the state by a directory entry name (the state of an excluded entry is empty).
+    /// @param state the state of the directory
+    /// @param name  entry name
+    /// @return      the state of the entry and whether it is excluded
+    [[nodiscard]] Step step(State const& state, String_view name) const;
+
+    /// @brief       Check if a directory entry is excluded (e.g. a file which needs no state of its own).
+    /// @param state the state of the directory
+    /// @param name  entry name
+    [[nodiscard]] bool excludes(State const& state, String_view name) const;
+
+    /// @brief      Check if a path passed by the user is excluded.
+    /// @param path file path
+    [[nodiscard]] bool excludes(std::filesystem::path const& path) const;
+
+  private:
+    static constexpr unsigned no_node       = ~0u;
+    static constexpr unsigned absolute_root = 0;
+    static constexpr unsigned relative_root = 1;
+
+    /// @brief Transparent hash allowing lookup by String_view.
+    struct String_hash
+      : std::hash<String_view>
+    {
+      using is_transparent = void;
+    };
+
+    struct Node
+    {
+      std::unordered_map<String, unsigned, String_hash, std::equal_to<>>
+                                                literals;
+      std::vector<std::pair<Component_glob, unsigned>>
+                                                globs;
+      unsigned                                  globstar    = no_node; // ** child
+      bool                                      is_globstar = false;   // matches any component staying here
+      bool                                      accepting   = false;
+    };
+
+    std::vector<Node> _nodes;
+    size_t            _pattern_count = 0;
+
+    [[nodiscard]] unsigned _new_node();
+    void _add_closure(State& state, unsigned node) const;
+    void _advance(State const& from, String_view name, State& to) const;
+    [[nodiscard]] bool _is_accepting(State const& state) const noexcept;
+    [[nodiscard]] static State& _scratch() noexcept;
+    void _walk_path(std::filesystem::path const& path, Step& step) const;
+  };
+
+}
+
+#endif//SRCSTATS_EXCLUSION_HPP_INCLUDED
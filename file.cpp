@@ -28,9 +28,20 @@ SOFTWARE.
 
 #include "file.hpp"
 #include "basic.hpp"
+#include "text_simd.hpp"
 
 #include <fstream>
 #include <algorithm>
+#include <optional>
+#include <utility>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define SRCSTATS_HAS_MMAP 1
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
 
 
 namespace srcstats
@@ -38,65 +49,321 @@ namespace srcstats
 
   using namespace characters;
 
+  namespace
+  {
+
+    /// @brief Open the file and read it to the buffer obtained as get_buffer(file size).
+    void read_file(fs::path const& filename, size_t padding_bytes, size_t max_file_size, auto get_buffer)
+    {
+      auto const file_size = fs::file_size(filename);
+      if (file_size > static_cast<uintmax_t>(max_file_size))
+        throw File_too_big(filename, file_size);
+
+      std::ifstream file(filename, std::ios::binary);
+      if (!file.is_open())
+        throw File_error("failed to open", filename);
+
+      auto const size       = static_cast<size_t>(file_size);
+      auto const bytes_read = read_padded(get_buffer(size + padding_bytes), size, padding_bytes, 
+          [&file](Character* out, size_t size)
+          {
+            file.read(out, size);
+            return static_cast<size_t>(file.gcount());
+          });
+
+      if (bytes_read != size)
+        throw File_error("failed to read", filename, bytes_read);
+    }
+
+  }
+
+
   File_data read_file_to_memory(
       fs::path const& filename,
       size_t          padding_bytes,
       size_t          max_file_size
     )
+  {
+    File_data result;
+    read_file(filename, padding_bytes, max_file_size, 
+        [&result](size_t) -> File_data& { return result; });
+
+    return result;
+  }
+
+
+  Buffer_pool::Buffer read_file_to_memory(
+      fs::path const& filename,
+      Buffer_pool&    pool,
+      size_t          padding_bytes,
+      size_t          max_file_size
+    )
+  {
+    std::optional<Buffer_pool::Buffer> result;
+    read_file(filename, padding_bytes, max_file_size, 
+        [&result, &pool](size_t size) -> File_data& { return *result.emplace(pool.borrow(size)); });
+
+    return std::move(*result);
+  }
+
+
+#if defined(SRCSTATS_HAS_MMAP)
+
+  bool read_file_to_batch(fs::path const& filename, File_batch& batch)
+  {
+    int const fd = ::open(filename.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+      throw File_error("failed to open", filename, errno);
+
+    size_t bytes_read = 0, size = 0;
+    try
+    {
+      struct stat st;
+      if (::fstat(fd, &st) != 0)
+        throw File_error("failed to get file size", filename, errno);
+
+      if (static_cast<uintmax_t>(st.st_size) > File_batch::max_file_size)
+      {
+        ::close(fd);
+        return false;
+      }
+
+      size       = static_cast<size_t>(st.st_size);
+      bytes_read = batch.add(size, [fd](Character* out, size_t size)
+        {
+          size_t bytes_read = 0;
+          while (bytes_read < size)
+          {
+            auto const bytes = ::read(fd, out + bytes_read, size - bytes_read);
+            if (bytes < 0 && errno == EINTR)
+              continue;
+            if (bytes <= 0)
+              break;
+            bytes_read += static_cast<size_t>(bytes);
+          }
+
+          return bytes_read;
+        });
+    }
+    catch (...)
+    {
+      ::close(fd);
+      throw;
+    }
+
+    ::close(fd);
+    if (bytes_read != size)
+      throw File_error("failed to read", filename, bytes_read);
+
+    return true;
+  }
+
+#else
+
+  bool read_file_to_batch(fs::path const& filename, File_batch& batch)
   {
     auto const file_size = fs::file_size(filename);
-    if (file_size > static_cast<uintmax_t>(max_file_size))
-      throw File_error("file is too big", filename, file_size);
+    if (file_size > static_cast<uintmax_t>(File_batch::max_file_size))
+      return false;
 
     std::ifstream file(filename, std::ios::binary);
     if (!file.is_open())
       throw File_error("failed to open", filename);
 
-    File_data result(file_size + padding_bytes, NUL);
-    result.resize(file_size);
-    
-    file.read(result.data(), file_size);
-    if (auto const bytes_read = file.gcount(); bytes_read != file_size)
+    auto const size       = static_cast<size_t>(file_size);
+    auto const bytes_read = batch.add(size, [&file](Character* out, size_t size)
+      {
+        file.read(out, size);
+        return static_cast<size_t>(file.gcount());
+      });
+
+    if (bytes_read != size)
       throw File_error("failed to read", filename, bytes_read);
 
-    return result;
+    return true;
+  }
+
+#endif
+
+
+  bool is_normalized(String_view input) noexcept
+  {
+    return find_control(input) == NPOS;
+  }
+
+
+  Character* normalize_to(String_view input, Character* out) noexcept
+  {
+    return copy_without_control(input, out);
   }
 
 
   void normalize(File_data& file_data) noexcept
   {
-    std::erase_if(file_data, [](unsigned char ch)
-      {
-        return ch < space && ch != TAB && ch != LF;
-      });
+    file_data.resize(static_cast<size_t>(copy_without_control(file_data, file_data.data()) - file_data.data()));
   }
 
 
-  void remove_empty_lines_and_whitespace_endings(File_data& file_data) noexcept
+#if defined(SRCSTATS_HAS_MMAP)
+
+  bool memory_mapping_supported() noexcept
+  {
+    return true;
+  }
+
+
+  Mapped_file::Mapped_file(fs::path const& filename, size_t padding_bytes, size_t max_file_size)
   {
-    auto write_pos = file_data.begin(), end = file_data.end();
+    int const fd = ::open(filename.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+      throw File_error("failed to open", filename, errno);
+
+    try
+    {
+      _map(fd, filename, padding_bytes, max_file_size);
+    }
+    catch (...)
+    {
+      ::close(fd);
+      throw;
+    }
+
+    ::close(fd);
+  }
+
+
+  Mapped_file::Mapped_file(int fd, fs::path const& filename, size_t padding_bytes, size_t max_file_size)
+  {
+    _map(fd, filename, padding_bytes, max_file_size);
+  }
+
+
+  void Mapped_file::_map(int fd, fs::path const& filename, size_t padding_bytes, size_t max_file_size)
+  {
+    static constexpr Character empty_padding[64] {};
     
-    for (auto read_pos = write_pos; read_pos != end;)
+    struct stat st;
+    if (::fstat(fd, &st) != 0)
+      throw File_error("failed to get file size", filename, errno);
+
+    auto const file_size = static_cast<uintmax_t>(st.st_size);
+    if (file_size > static_cast<uintmax_t>(max_file_size))
+      throw File_too_big(filename, file_size);
+
+    auto const size = static_cast<size_t>(file_size);
+    if (size == 0)
+    {
+      _view = { empty_padding, 0 };
+      return;
+    }
+
+    // The bytes after the end of file up to the end of its last page are zeros.
+    // If the padding does not fit there, an anonymous zero page is mapped after the file.
+    auto const page        = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+    auto const round_up    = [page](size_t n) { return (n + page - 1) / page * page; };
+    auto const file_pages  = round_up(size);
+    auto const total_pages = round_up(size + padding_bytes);
+
+    void* mapping = nullptr;
+    if (file_pages == total_pages)
+    {
+      mapping = ::mmap(nullptr, file_pages, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (mapping == MAP_FAILED)
+        throw File_error("failed to map", filename, errno);
+    }
+    else
+    {
+      mapping = ::mmap(nullptr, total_pages, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+      if (mapping == MAP_FAILED)
+        throw File_error("failed to map", filename, errno);
+
+      if (::mmap(mapping, size, PROT_READ, MAP_PRIVATE | MAP_FIXED, fd, 0) == MAP_FAILED)
+      {
+        auto const error = errno;
+        ::munmap(mapping, total_pages);
+        throw File_error("failed to map", filename, error);
+      }
+    }
+
+    ::madvise(mapping, size, MADV_SEQUENTIAL);
+    ::madvise(mapping, size, MADV_WILLNEED);
+
+    _mapping      = mapping;
+    _mapping_size = total_pages;
+    _view         = { static_cast<Character const*>(mapping), size };
+  }
+
+
+  void Mapped_file::_unmap() noexcept
+  {
+    if (_mapping)
+      ::munmap(_mapping, _mapping_size);
+  }
+
+#else
+
+  bool memory_mapping_supported() noexcept
+  {
+    return false;
+  }
+
+
+  Mapped_file::Mapped_file(fs::path const& filename, size_t padding_bytes, size_t max_file_size)
+  {
+    _fallback = read_file_to_memory(filename, padding_bytes, max_file_size);
+    _view     = _fallback;
+  }
+
+
+  Mapped_file::Mapped_file(int, fs::path const& filename, size_t, size_t)
+  {
+    throw File_error("file descriptors are not supported on this platform", filename);
+  }
+
+
+  void Mapped_file::_unmap() noexcept {}
+
+#endif
+
+
+  Mapped_file::Mapped_file(Mapped_file&& other) noexcept
+    : _view         (std::exchange(other._view, {})),
+      _mapping      (std::exchange(other._mapping, nullptr)),
+      _mapping_size (std::exchange(other._mapping_size, 0)),
+      _fallback     (std::move(other._fallback))
+  {
+    if (!_mapping && !_view.empty())
+      _view = _fallback;
+  }
+
+
+  Mapped_file& Mapped_file::operator=(Mapped_file&& other) noexcept
+  {
+    if (this != &other)
     {
-      // Select next line.
-      auto line_begin = read_pos, lf_pos = std::find(read_pos, end, LF), line_end = lf_pos;
-      // Remove final spaces.
-      while (line_end != line_begin && *(line_end - 1) <= space)
-        --line_end;
-      // Copy if the line is non-empty.
-      if (line_begin != line_end)
-        write_pos = std::copy(line_begin, line_end, write_pos);
-      // Finish?
-      if (lf_pos == end)
-        break;
-
-      // Find the beginning of the next line.
-      read_pos = std::find_if(lf_pos, end, [](char ch) { return ch > space; });
-      if (read_pos != end)
-        *write_pos++ = LF;      
+      _unmap();
+      _view         = std::exchange(other._view, {});
+      _mapping      = std::exchange(other._mapping, nullptr);
+      _mapping_size = std::exchange(other._mapping_size, 0);
+      _fallback     = std::move(other._fallback);
+
+      if (!_mapping && !_view.empty())
+        _view = _fallback;
     }
 
-    file_data.erase(write_pos, end);
+    return *this;
+  }
+
+
+  Mapped_file::~Mapped_file()
+  {
+    _unmap();
+  }
+
+
+  void remove_empty_lines_and_whitespace_endings(File_data& file_data) noexcept
+  {
+    file_data.resize(static_cast<size_t>(copy_trimmed_lines(file_data, file_data.data()) - file_data.data()));
   }
 
 }
@@ -28,6 +28,11 @@ SOFTWARE.
 #ifndef SRCSTATS_FILE_HPP_INCLUDED
 #define SRCSTATS_FILE_HPP_INCLUDED
 
+#include "basic.hpp"
+#include "buffer_pool.hpp"
+#include "file_batch.hpp"
+
+#include <algorithm>
 #include <filesystem>
 #include <string>
 #include <stdexcept>
@@ -78,10 +83,23 @@ namespace srcstats
   };
 
 
+  /// @brief Exception class for files larger than the size limit (they may be processed by chunks instead).
+  class File_too_big
+    : public File_error
+  {
+  public:
+    /// @brief           Create a file too big exception object.
+    /// @param file_path the path to the file
+    /// @param file_size the file size
+    File_too_big(fs::path const& file_path, uintmax_t file_size)
+      : File_error("file is too big", file_path, file_size) {}
+  };
+
+
   /// @brief               Read a file to memory, throw File_error if the file can't be open or read
   /// @param filename      the path to the file to be read
   /// @param padding_bytes how many additional zero bytes should be appended to the end of the file contents (reserved)
-  /// @param max_file_size maximal file size possible, throw File_error(file size) if the file is larger
+  /// @param max_file_size maximal file size possible, throw File_too_big if the file is larger
   /// @return              file data object storing file byte content
   File_data read_file_to_memory(
       fs::path const& filename,
@@ -90,6 +108,112 @@ namespace srcstats
     );
 
 
+  /// @brief               Read a file to a buffer borrowed from the pool, throw File_error if the file can't be open or read.
+  /// Only the padding bytes are zero-filled.
+  /// @param filename      the path to the file to be read
+  /// @param pool          the pool to borrow the buffer from
+  /// @param padding_bytes how many additional zero bytes should be appended to the end of the file contents
+  /// @param max_file_size maximal file size possible, throw File_too_big if the file is larger
+  /// @return              the borrowed buffer storing file byte content
+  Buffer_pool::Buffer read_file_to_memory(
+      fs::path const& filename,
+      Buffer_pool&    pool,
+      size_t          padding_bytes = 0,
+      size_t          max_file_size = ~size_t(0) / 2
+    );
+
+  /// @brief          Read a small file appending it to the batch, throw File_error if the file can't be open or read.
+  /// The file is read by one open, fstat and read where they are available.
+  /// @param filename the path to the file to be read
+  /// @param batch    the destination batch
+  /// @return         false if the file is larger than File_batch::max_file_size (it is not read then)
+  bool read_file_to_batch(fs::path const& filename, File_batch& batch);
+
+  /// @brief               Resize the buffer to the file size and read the contents by the callback, zero-fill the padding.
+  /// @param file_data     the destination buffer (its capacity is reused)
+  /// @param file_size     the file size
+  /// @param padding_bytes how many additional zero bytes should be appended to the end of the file contents
+  /// @param read          called as read(destination, file_size), returns how many bytes have been read
+  /// @return              how many bytes have been read
+  size_t read_padded(File_data& file_data, size_t file_size, size_t padding_bytes, auto read)
+  {
+    size_t bytes_read = 0;
+    file_data.resize_and_overwrite(file_size + padding_bytes, 
+        [file_size, &bytes_read, &read](Character* out, size_t size)
+        {
+          bytes_read = read(out, file_size);
+          std::fill(out + file_size, out + size, Character{});
+          return size;
+        });
+
+    file_data.resize(file_size);
+    return bytes_read;
+  }
+
+
+  /// @brief Memory mapped file contents followed by readable zero padding bytes.
+  /// The mapping is private and read-only, so the contents are to be transformed out of place.
+  /// If memory mapping is not supported on the platform, the file is read to an owned buffer.
+  class Mapped_file
+  {
+  public:
+    /// @brief               Map a file to memory, throw File_error if the file can't be open or mapped.
+    /// @param filename      the path to the file to be mapped
+    /// @param padding_bytes how many zero bytes should be readable after the file contents (less than a page)
+    /// @param max_file_size maximal file size possible, throw File_too_big if the file is larger
+    explicit Mapped_file(
+        fs::path const& filename,
+        size_t          padding_bytes = 0,
+        size_t          max_file_size = ~size_t(0) / 2
+      );
+
+    /// @brief               Map an already open file (POSIX file descriptor), the descriptor is not closed.
+    /// @param fd            the file descriptor
+    /// @param filename      the path to the file (for error messages)
+    /// @param padding_bytes how many zero bytes should be readable after the file contents (less than a page)
+    /// @param max_file_size maximal file size possible, throw File_too_big if the file is larger
+    Mapped_file(
+        int             fd,
+        fs::path const& filename,
+        size_t          padding_bytes = 0,
+        size_t          max_file_size = ~size_t(0) / 2
+      );
+
+    Mapped_file(Mapped_file&& other) noexcept;
+    Mapped_file& operator=(Mapped_file&& other) noexcept;
+    ~Mapped_file();
+
+    /// @brief Get the file contents (followed by the padding bytes).
+    [[nodiscard]] String_view view() const noexcept
+    {
+      return _view;
+    }
+
+  private:
+    String_view _view;
+    void*       _mapping      = nullptr;
+    size_t      _mapping_size = 0;
+    File_data   _fallback;
+
+    void _map(int fd, fs::path const& filename, size_t padding_bytes, size_t max_file_size);
+    void _unmap() noexcept;
+  };
+
+
+  /// @brief Check if memory mapping is supported (otherwise Mapped_file reads the files).
+  [[nodiscard]] bool memory_mapping_supported() noexcept;
+
+
+  /// @brief       Check if the text contains no ASCII characters with codes below 32 (SPACE) except for TAB and LF.
+  /// @param input the text to be checked
+  [[nodiscard]] bool is_normalized(String_view input) noexcept;
+
+  /// @brief       Copy the text removing ASCII characters with codes below 32 (SPACE) except for TAB and LF.
+  /// @param input the source text
+  /// @param out   the destination, it may be equal to input.data()
+  /// @return      pointer to the end of the written data
+  Character* normalize_to(String_view input, Character* out) noexcept;
+
   /// @brief           Remove ASCII characters with codes below 32 (SPACE) except for TAB and LF (in place).
   /// @param file_data File_data object will be resized accordingly
   void normalize(File_data& file_data) noexcept;
@@ -0,0 +1,133 @@
+/******************************************************************************
+MIT License
+
+Copyright (c) 2024 Dmitry R. Kuvshinov
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+******************************************************************************/
+
+/// @file   file_batch.hpp
+/// @brief  Small source files of one file type packed to one buffer.
+/// @author D.R.Kuvshinov kuvshinovdr at yandex.ru
+#ifndef SRCSTATS_FILE_BATCH_HPP_INCLUDED
+#define SRCSTATS_FILE_BATCH_HPP_INCLUDED
+
+#include "basic.hpp"
+
+#include <algorithm>
+#include <vector>
+
+
+namespace srcstats
+{
+
+  /// @brief Contents of small source files of the same language and subtype stored one after another 
+  /// (each followed by padding zero bytes) with the table of their offsets.
+  /// The files are read directly to the batch and analyzed by one call (see Lang_interface::analyze_batch),
+  /// so the costs of a file are not much more than the costs of its bytes.
+  class File_batch
+  {
+  public:
+    /// @brief Larger files are not batched.
+    static constexpr size_t max_file_size = size_t(16) << 10;
+
+    /// @brief The batch is full (to be analyzed) when its files take this many bytes.
+    static constexpr size_t capacity      = size_t(256) << 10;
+
+    /// @brief               Make an empty batch.
+    /// @param subtype       the file subtype of all the files
+    /// @param padding_bytes how many zero bytes follow each file
+    explicit File_batch(int subtype = 0, size_t padding_bytes = 0)
+      : _offsets{ 0 }, _padding_bytes(padding_bytes), _subtype(subtype) {}
+
+    /// @brief Get the file subtype of the files.
+    [[nodiscard]] int subtype() const noexcept
+    {
+      return _subtype;
+    }
+
+    /// @brief Get how many files are in the batch.
+    [[nodiscard]] size_t size() const noexcept
+    {
+      return _offsets.size() - 1;
+    }
+
+    /// @brief Check if there are no files in the batch.
+    [[nodiscard]] bool is_empty() const noexcept
+    {
+      return size() == 0;
+    }
+
+    /// @brief Check if the batch is to be analyzed before adding more files.
+    [[nodiscard]] bool is_full() const noexcept
+    {
+      return _arena.size() >= capacity;
+    }
+
+    /// @brief Get the contents of the file i (followed by padding zero bytes).
+    [[nodiscard]] String_view operator[](size_t i) const noexcept
+    {
+      return { _arena.data() + _offsets[i], _offsets[i + 1] - _offsets[i] - _padding_bytes };
+    }
+
+    /// @brief           Append a file read by the callback (the file is dropped if it is not read completely).
+    /// @param file_size the file size
+    /// @param read      called as read(destination, file_size), returns how many bytes have been read
+    /// @return          how many bytes have been read
+    size_t add(size_t file_size, auto read)
+    {
+      auto const offset = _arena.size();
+      if (_arena.capacity() < offset + file_size + _padding_bytes)
+        _arena.reserve(std::max(offset + file_size + _padding_bytes, capacity + max_file_size + _padding_bytes));
+
+      size_t bytes_read = 0;
+      _arena.resize_and_overwrite(offset + file_size + _padding_bytes,
+          [this, offset, file_size, &bytes_read, &read](Character* out, size_t size)
+          {
+            bytes_read = read(out + offset, file_size);
+            if (bytes_read != file_size)
+              return offset;
+
+            std::fill(out + offset + file_size, out + size, Character{});
+            return size;
+          });
+
+      if (bytes_read == file_size)
+        _offsets.push_back(_arena.size());
+
+      return bytes_read;
+    }
+
+    /// @brief Remove all the files keeping the memory.
+    void clear() noexcept
+    {
+      _arena.clear();
+      _offsets.resize(1);
+    }
+
+  private:
+    String              _arena;
+    std::vector<size_t> _offsets;       // file i takes [_offsets[i], _offsets[i + 1]) including its padding
+    size_t              _padding_bytes;
+    int                 _subtype;
+  };
+
+}
+
+#endif//SRCSTATS_FILE_BATCH_HPP_INCLUDED
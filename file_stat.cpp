@@ -27,8 +27,9 @@ SOFTWARE.
 /// @author D.R.Kuvshinov kuvshinovdr at yandex.ru
 
 #include "file_stat.hpp"
+#include "text_simd.hpp"
 
-#include <ranges>
+#include <algorithm>
 
 
 namespace srcstats
@@ -36,22 +37,117 @@ namespace srcstats
 
   File_statistics& File_statistics::operator()(String_view file_data) noexcept
   {
-    // I doubt this code compiles to an effective machine code sequence...
-    // Anyway it's short and "new" (C++20 ranges).
-    size_t line_counter = 0;
-
-    using namespace std::views;
-    for (auto line_length 
-              : file_data 
-              | lazy_split(characters::LF) 
-              | transform(std::ranges::distance))
+    // The same lines as file_data | views::lazy_split(LF) yields: none for an empty text,
+    // otherwise the last line follows the last LF (even if it is empty).
+    if (file_data.empty())
     {
-      _lines(line_length);
-      ++line_counter;
+      _files(0);
+      return *this;
     }
 
-    _files(line_counter);
+    // The lines are accumulated directly (a local accumulator would zero and merge its histogram per file).
+    auto const count = _lines.count();
+    auto const last  = accumulate_lines(file_data, _lines, line_quantiles());
+    _lines(last);
+    if (_line_quantiles)
+      (*_line_quantiles)(last);
+
+    _files(_lines.count() - count);
+    return *this;
+  }
+
+
+  File_statistics& File_statistics::operator()(File_statistics const& stats)
+  {
+    _files(stats.files());
+    _lines(stats.lines());
+    if (stats._line_quantiles)
+    {
+      use_line_quantiles();
+      (*_line_quantiles)(*stats._line_quantiles);
+    }
     return *this;
   }
 
+
+
+  File_statistics_stream& File_statistics_stream::operator()(String_view chunk) noexcept
+  {
+    using namespace characters;
+
+    if (!_trim)
+    {
+      // The same lines as lazy_split yields: the text is split by LF characters.
+      _empty = _empty && chunk.empty();
+      auto& lines = _stats->_lines;
+      auto const count = lines.count();
+      _line_length = accumulate_lines(chunk, lines, _quantiles, _line_length, _decoder);
+      _line_count += lines.count() - count;
+      return *this;
+    }
+
+    // Lines are written without their trailing whitespace, empty lines and leading whitespace of the next lines
+    // are skipped (the LF before the next line is written if it is found, even if the first line is empty).
+    // So the whitespace after the last non-whitespace character is held: the next non-whitespace character 
+    // follows an LF if the held whitespace has one and follows the held whitespace itself otherwise.
+    // Whitespace is ASCII up to space (see is_whitespace), so it ends any UTF-8 sequence.
+    auto const first = std::ranges::find_if_not(chunk, is_whitespace);
+    if (first == chunk.end())
+    {
+      _whitespace += chunk.size();
+      _between     = _between || chunk.contains(LF);
+      return *this;
+    }
+
+    auto const leading = String_view(chunk.begin(), first);
+    if (_between || leading.contains(LF))
+    {
+      _line(_line_length);
+      _line_length = 0;
+      _decoder     = {};
+    }
+    else if (_whitespace + leading.size() != 0)
+    {
+      _line_length += _whitespace + leading.size();
+      _decoder      = {};
+    }
+
+    // The text between the first and the last non-whitespace characters is trimmed as a whole.
+    auto const last = std::find_if_not(chunk.rbegin(), chunk.rend(), is_whitespace).base();
+    auto const text = String_view(first, last);
+    thread_local String trimmed;
+    if (trimmed.size() < text.size())
+      trimmed.resize(text.size());
+
+    auto& lines = _stats->_lines;
+    auto const count = lines.count();
+    auto const trimmed_end = copy_trimmed_lines(text, trimmed.data());
+    _line_length = accumulate_lines(String_view(trimmed.data(), trimmed_end), lines, _quantiles, _line_length, _decoder);
+    _line_count += lines.count() - count;
+
+    auto const trailing = String_view(last, chunk.end());
+    _whitespace = trailing.size();
+    _between    = trailing.contains(LF);
+    _empty      = false;
+    return *this;
+  }
+
+
+  void File_statistics_stream::finish() noexcept
+  {
+    if (!_empty)
+      _line(_line_length);
+
+    _stats->_files(_line_count);
+  }
+
+
+  void File_statistics_stream::_line(size_t length) noexcept
+  {
+    _stats->_lines(length);
+    if (_quantiles != nullptr)
+      (*_quantiles)(length);
+    ++_line_count;
+  }
+
 }
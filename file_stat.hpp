@@ -29,17 +29,39 @@ SOFTWARE.
 #define SRCSTATS_FILE_STAT_HPP_INCLUDED
 
 #include "stat_accum.hpp"
+#include "utf8.hpp"
 
+#include <memory>
 #include <string_view>
 
 
 namespace srcstats
 {
 
-  /// @brief Files (their lengths in text lines) and lines (their lengths in characters) statistics.
+  /// @brief Files (their lengths in text lines) and lines (their lengths in characters) statistics,
+  /// optionally with a sketch of the line lengths (see use_line_quantiles).
   class File_statistics
   {
   public:
+    File_statistics() = default;
+
+    /// @brief Copy the statistics, the sketch of the line lengths is copied too.
+    File_statistics(File_statistics const& other)
+      : _files(other._files), _lines(other._lines), 
+        _line_quantiles(other._line_quantiles ? std::make_unique<Quantile_sketch>(*other._line_quantiles) : nullptr) {}
+
+    File_statistics(File_statistics&&) noexcept = default;
+
+    File_statistics& operator=(File_statistics const& other)
+    {
+      if (this != &other)
+        *this = File_statistics(other);
+      return *this;
+    }
+
+    File_statistics& operator=(File_statistics&&) noexcept = default;
+
+
     // Getters
 
     /// @brief Check if our statistics does not have any data.
@@ -55,12 +77,19 @@ namespace srcstats
       return _files;
     }
 
-    /// @brief Access read-only lines accumulated statistics. Line "value" is this line size in characters.
+    /// @brief Access read-only lines accumulated statistics. Line "value" is this line size in characters
+    /// (UTF-8 characters, see Utf8_decoder).
     [[nodiscard]] constexpr Statistics_accumulator const& lines() const noexcept
     {
       return _lines;
     }
 
+    /// @brief Access read-only the sketch of the line lengths (null unless use_line_quantiles has been called).
+    [[nodiscard]] Quantile_sketch const* line_quantiles() const noexcept
+    {
+      return _line_quantiles.get();
+    }
+
 
     /// @brief       Print files and lines statistics.
     /// @param os    the destination output stream
@@ -71,7 +100,7 @@ namespace srcstats
       _files.print(os, "files", "lines");
 
       os << '\n';
-      _lines.print(os, "lines", "characters");
+      _lines.print(os, "lines", "characters", line_quantiles());
       
       os << '\n';
     }
@@ -79,19 +108,64 @@ namespace srcstats
     
     // Mutators
 
+    /// @brief Keep the sketch of the line lengths in addition to their histogram (see Quantile_sketch).
+    /// The statistics merged into these ones add their sketches if they have them.
+    void use_line_quantiles()
+    {
+      if (!_line_quantiles)
+        _line_quantiles = std::make_unique<Quantile_sketch>();
+    }
+
+    /// @brief Access the sketch of the line lengths (e.g. to put the lines of a File_statistics_stream to it).
+    [[nodiscard]] Quantile_sketch* line_quantiles() noexcept
+    {
+      return _line_quantiles.get();
+    }
+
     /// @brief Accumulate a file presented by a preconditioned string_view (lines are delimited with LF characters).
     File_statistics& operator()(String_view file_data) noexcept;
 
     /// @brief Update with data from another statistics accumulator. 
-    constexpr File_statistics& operator()(File_statistics const& stats) noexcept
-    {
-      _files(stats.files());
-      _lines(stats.lines());
-      return *this;
-    }
+    File_statistics& operator()(File_statistics const& stats);
+
+  private:
+    friend class File_statistics_stream;
+
+    Statistics_accumulator           _files, _lines;
+    std::unique_ptr<Quantile_sketch> _line_quantiles;
+  };
+
+
+  /// @brief Computes statistics of one file given by consecutive chunks (a line may span several chunks).
+  /// The lines are accumulated directly to the destination statistics (and their sketch if it is used), 
+  /// the file is accumulated by finish.
+  class File_statistics_stream
+  {
+  public:
+    /// @brief       Start a file.
+    /// @param stats the destination statistics, it must outlive the stream
+    /// @param trim  compute the statistics of the text as remove_empty_lines_and_whitespace_endings leaves it
+    explicit File_statistics_stream(File_statistics& stats, bool trim = false) noexcept
+      : _stats(&stats), _quantiles(stats.line_quantiles()), _trim(trim) {}
+
+    /// @brief Take the next chunk of the file.
+    File_statistics_stream& operator()(String_view chunk) noexcept;
+
+    /// @brief Finish the file and accumulate it to the destination statistics.
+    void finish() noexcept;
 
   private:
-    Statistics_accumulator _files, _lines;
+    File_statistics*       _stats;
+    Quantile_sketch*       _quantiles;
+    size_t                 _line_count  = 0;
+    size_t                 _line_length = 0;     // the current line length (without trailing whitespace if _trim)
+    size_t                 _whitespace  = 0;     // whitespace characters after the last non-whitespace one (if _trim)
+    Utf8_decoder           _decoder;             // the UTF-8 sequence the last byte belongs to
+    bool                   _trim;
+    bool                   _empty       = true;  // nothing has been met (if _trim, nothing but whitespace)
+    bool                   _between     = false; // the whitespace after the last non-whitespace has an LF (if _trim)
+
+    void _line(size_t length) noexcept;
   };
 
 }
@@ -28,15 +28,55 @@ SOFTWARE.
 
 #include "file_type.hpp"
 #include "file.hpp"
+#include "detect.hpp"
+#include "utf8.hpp"
+#include "basic.hpp"
 
+#if defined(SRCSTATS_STATIC_LANGUAGES)
+#include "langs/languages.hpp"
+#endif
+
+#include <fstream>
 #include <initializer_list>
 #include <tuple>
 #include <algorithm>
+#include <optional>
+#include <type_traits>
 
 
 namespace srcstats
 {
 
+  namespace
+  {
+
+    /// @brief Hash the extension bytes (FNV-1a starting with the seed instead of the offset basis).
+    [[nodiscard]] constexpr uint64_t hash_extension(String_view ext, uint64_t seed) noexcept
+    {
+      for (auto const ch: ext)
+        seed = (seed ^ static_cast<unsigned char>(ch)) * 0x100000001b3;
+      return seed;
+    }
+
+
+    /// @brief Call f(String_view file name) for the name following the last separator of the path.
+    /// The name is taken from the path bytes without allocations if possible (POSIX paths).
+    decltype(auto) with_file_name(std::filesystem::path const& filename, auto f)
+    {
+      if constexpr (std::is_same_v<std::filesystem::path::value_type, Character>)
+      {
+        String_view const path = filename.native();
+        return f(path.substr(path.rfind(std::filesystem::path::preferred_separator) + 1));
+      }
+      else
+      {
+        return f(String_view(filename.filename().string()));
+      }
+    }
+
+  }
+
+
   bool File_type_dispatcher::File_type_desc::operator<
         (File_type_dispatcher::File_type_desc const& other) const
   {
@@ -57,39 +97,433 @@ namespace srcstats
   }
 
 
-  void File_type_dispatcher::_sort()
+  void File_type_dispatcher::register_file_type(String_view ext, Lang_interface const* lang, int subtype)
   {
-    std::sort(_desc.begin(), _desc.end());
-    _is_dirty = false;
+    File_type_desc desc { String(ext), lang, subtype };
+    auto const it = std::upper_bound(_desc.begin(), _desc.end(), desc);
+    _desc.insert(it, std::move(desc));
+    _build_extension_table();
+
+    if (std::ranges::find(_langs, lang) == _langs.end())
+    {
+      _langs.push_back(lang);
+      _results.push_back(lang->new_result());
+    }
   }
 
 
-  bool File_type_dispatcher::operator()(std::filesystem::path const& filename)
+  Lang_result& File_type_dispatcher::result(Lang_interface const* lang) noexcept
+  {
+    // There are few languages, so the linear search is cheaper than hashing.
+    auto const it = std::ranges::find(_langs, lang);
+    return *_results[it - _langs.begin()];
+  }
+
+
+  void File_type_dispatcher::merge(File_type_dispatcher const& other)
+  {
+    for (size_t i = 0; i < _results.size(); ++i)
+      _results[i]->merge(*other._results[i]);
+  }
+
+
+  void File_type_dispatcher::_build_extension_table()
+  {
+    // The table has at least twice as many slots as there are extensions, 
+    // seeds are tried until all of them get different slots (the table grows after a number of failures).
+    std::vector<unsigned> keys;
+    for (size_t i = 0; i < _desc.size(); ++i)
+      if (i == 0 || _desc[i].ext != _desc[i - 1].ext)
+        keys.push_back(static_cast<unsigned>(i));
+
+    for (unsigned bits = 1; bits < 32; ++bits)
+    {
+      if ((size_t(1) << bits) < 2 * keys.size())
+        continue;
+
+      for (uint64_t seed = 0xcbf29ce484222325, attempt = 0; attempt < 64; ++attempt)
+      {
+        _slots.assign(size_t(1) << bits, 0);
+        _seed  = seed;
+        _shift = 64 - bits;
+
+        bool const perfect = std::ranges::all_of(keys, [this](unsigned key)
+          {
+            auto& slot = _slots[hash_extension(_desc[key].ext, _seed) >> _shift];
+            if (slot != 0)
+              return false;
+
+            slot = key + 1;
+            return true;
+          });
+
+        if (perfect)
+          return;
+
+        seed = seed * 6364136223846793005 + 1442695040888963407;
+      }
+    }
+  }
+
+
+  File_type File_type_dispatcher::find(std::filesystem::path const& filename) const
+  {
+    return with_file_name(filename, [this](String_view name) { return find(name); });
+  }
+
+
+  File_type File_type_dispatcher::_find_extension(String_view ext) const noexcept
+  {
+    if (_slots.empty())
+      return {};
+
+    auto const slot = _slots[hash_extension(ext, _seed) >> _shift];
+    if (slot == 0)
+      return {};
+
+    auto const& desc = _desc[slot - 1];
+    if (desc.ext != ext)
+      return {};
+
+    return { desc.lang, desc.subtype };
+  }
+
+
+  File_type File_type_dispatcher::find(String_view name) const noexcept
+  {
+    // Follow std::filesystem::path::extension: "." and ".." and names like ".profile" have no extension.
+    auto const pos = name.rfind('.');
+    if (pos == NPOS || pos == 0 || name == ".."sv)
+      return {};
+
+    return _find_extension(name.substr(pos));
+  }
+
+
+  File_type File_type_dispatcher::detect(std::filesystem::path const& filename)
+  {
+    if (!_detecting || !with_file_name(filename, is_detection_candidate))
+      return {};
+
+    auto const head = read_file_head(filename);
+    return _detect(filename, head.view());
+  }
+
+
+  File_type File_type_dispatcher::_detect(std::filesystem::path const& filename, String_view head)
+  {
+    auto const detected = detect_language(head, _langs);
+    if (!detected.lang)
+      return {};
+
+    if (detected.confidence >= accepted_confidence
+     || std::ranges::contains(_preferred_langs(filename.parent_path()), detected.lang))
+      return { detected.lang, detected.subtype };
+
+    return {};
+  }
+
+
+  std::vector<Lang_interface const*> const& File_type_dispatcher::_preferred_langs(
+      std::filesystem::path const& directory)
+  {
+    // The languages detected with directory_confidence in any file without an extension of the directory 
+    // (whether it is analyzed or not). The preference depends only on the directory contents, not on the files
+    // processed before, so every worker computes the same one whatever the order of the files and the thread
+    // count are. The directory is read once per dispatcher.
+    auto const [it, inserted] = _directory_langs.try_emplace(directory.string());
+    auto& langs = it->second;
+    if (!inserted)
+      return langs;
+
+    std::error_code error;
+    for (std::filesystem::directory_iterator entries(directory, error), end; !error && entries != end;)
+    {
+      auto const& entry = *entries;
+      if (with_file_name(entry.path(), is_detection_candidate) && entry.is_regular_file(error))
+      {
+        try
+        {
+          auto const head     = read_file_head(entry.path());
+          auto const detected = detect_language(head.view(), _langs);
+          if (detected.lang && detected.confidence >= directory_confidence 
+           && !std::ranges::contains(langs, detected.lang))
+            langs.push_back(detected.lang);
+        }
+        catch (File_error const&)
+        {
+          // An unreadable file prefers nothing, it is reported when it is processed.
+        }
+      }
+
+      entries.increment(error);
+    }
+
+    return langs;
+  }
+
+
+  File_analysis File_type_dispatcher::analyze(File_type type, String_view input, bool quantiles)
+  {
+    thread_local File_data transcoded;
+
+    File_analysis result;
+    if (quantiles)
+      result.use_line_quantiles();
+
+    auto const text = decode_text(input, transcoded);
+#if defined(SRCSTATS_STATIC_LANGUAGES)
+    if (Languages::visit(type.lang, [&](auto const& lang)
+          { lang.analyze(text, result.raw, result.decommented, type.subtype); }))
+      return result;
+#endif
+
+    type.lang->analyze(text, result.raw, result.decommented, type.subtype);
+    return result;
+  }
+
+
+  File_analysis File_type_dispatcher::analyze(File_type type, String_view input, File_data& buffer, 
+                                              Analysis_mode mode, bool quantiles)
+  {
+    if (mode == Analysis_mode::fused)
+      return analyze(type, input, quantiles);
+
+    // The text is kept at the beginning of the buffer if it is stored there (the byte order mark is erased).
+    thread_local File_data transcoded;
+    if (auto const bom = byte_order_mark(input);
+        bom.encoding == Text_encoding::utf8 && bom.size != 0 && input.data() == buffer.data())
+    {
+      buffer.erase(0, bom.size);
+      buffer.append(padding_bytes, characters::NUL);
+      buffer.resize(buffer.size() - padding_bytes);
+      input = buffer;
+    }
+    else
+    {
+      input = decode_text(input, transcoded, padding_bytes);
+    }
+
+    File_analysis result;
+    if (quantiles)
+      result.use_line_quantiles();
+
+    // Copy to the buffer only if something is to be removed (e.g. CR of CR LF line endings).
+    if (!is_normalized(input))
+    {
+      bool const in_place = input.data() == buffer.data();
+      buffer.resize_and_overwrite(input.size() + padding_bytes, [input, in_place](Character* out, size_t size)
+        {
+          auto const from = in_place ? String_view{ out, input.size() } : input;
+          auto const end  = normalize_to(from, out);
+          std::fill(end, out + size, characters::NUL);
+          return static_cast<size_t>(end - out);
+        });
+
+      input = buffer;
+    }
+
+    result.raw(input);
+
+    bool const in_place = input.data() == buffer.data();
+    buffer.resize_and_overwrite(input.size(), [&type, input, in_place](Character* out, size_t)
+      {
+        auto const from = in_place ? String_view{ out, input.size() } : input;
+        return static_cast<size_t>(type.lang->decomment(from, out, type.subtype) - out);
+      });
+
+    remove_empty_lines_and_whitespace_endings(buffer);
+    result.decommented(buffer);
+    return result;
+  }
+
+
+  File_analysis File_type_dispatcher::analyze_stream(File_type type, std::filesystem::path const& filename,
+                                                    Analysis_mode mode, bool quantiles)
+  {
+    std::ifstream file(filename, std::ios::binary);
+    if (!file.is_open())
+      throw File_error("failed to open", filename);
+
+    thread_local File_data input, transcoded, output;
+    input.resize(stream_chunk_size);
+    transcoded.resize(Utf16_transcoder::max_output_size(stream_chunk_size));
+    output.resize(transcoded.size() + Decomment_stream::max_held_bytes);
+
+    File_analysis result;
+    if (quantiles)
+      result.use_line_quantiles();
+
+    auto const decomment = type.lang->decomment_stream(type.subtype);
+    File_statistics_stream raw(result.raw), decommented(result.decommented, true);
+    auto const analyze = [mode, &decomment, &raw, &decommented](Character* data, size_t size)
+      {
+        if (mode == Analysis_mode::fused)
+        {
+          analyze_chunk(*decomment, { data, size }, raw, decommented);
+        }
+        else
+        {
+          String_view const chunk { data, normalize_to({ data, size }, data) };
+          raw(chunk);
+          decommented({ output.data(), (*decomment)(chunk, output.data()) });
+        }
+      };
+
+    // The byte order mark is looked for in the first chunk, UTF-16 chunks are transcoded.
+    std::optional<Utf16_transcoder> utf16;
+    uintmax_t bytes_read = 0;
+    do
+    {
+      file.read(input.data(), stream_chunk_size);
+      auto const size = static_cast<size_t>(file.gcount());
+      auto       skip = size_t(0);
+      if (bytes_read == 0)
+      {
+        auto const bom = byte_order_mark({ input.data(), size });
+        skip = bom.size;
+        if (bom.encoding != Text_encoding::utf8)
+          utf16.emplace(bom.encoding == Text_encoding::utf16be);
+      }
+      bytes_read += size;
+
+      if (utf16)
+      {
+        auto const end = (*utf16)({ input.data() + skip, size - skip }, transcoded.data());
+        analyze(transcoded.data(), static_cast<size_t>(end - transcoded.data()));
+      }
+      else
+      {
+        analyze(input.data() + skip, size - skip);
+      }
+    } while (file);
+
+    if (file.bad())
+      throw File_error("failed to read", filename, bytes_read);
+
+    if (utf16)
+      analyze(transcoded.data(), static_cast<size_t>(utf16->finish(transcoded.data()) - transcoded.data()));
+
+    finish_chunks(*decomment, decommented);
+
+    raw.finish();
+    decommented.finish();
+    return result;
+  }
+
+
+  void File_type_dispatcher::process(File_type type, Mapped_file const& file)
+  {
+    if (_analysis_mode == Analysis_mode::fused)
+      return accumulate(type, analyze(type, file.view(), _quantiles));
+
+    auto buffer = _buffers.borrow(file.view().size() + padding_bytes);
+    accumulate(type, analyze(type, file.view(), *buffer, Analysis_mode::reference, _quantiles));
+  }
+
+
+  void File_type_dispatcher::_process(File_type type, std::filesystem::path const& filename)
   {
-    if (_is_dirty)
-      _sort();
+    try
+    {
+      if (_streaming)
+        accumulate(type, analyze_stream(type, filename, _analysis_mode, _quantiles));
+      else if (_memory_mapping)
+        process(type, map(filename));
+      else if (!batching() || !add_to_batch(type, 
+                   [&filename](File_batch& batch) { return read_file_to_batch(filename, batch); }))
+        process(type, *read_file_to_memory(filename, _buffers, padding_bytes, maximal_file_size));
+    }
+    catch (File_too_big const&)
+    {
+      accumulate(type, analyze_stream(type, filename, _analysis_mode, _quantiles));
+    }
+  }
+
 
-    File_type_desc probe { filename.extension() };
+  File_batch& File_type_dispatcher::_batch(File_type type)
+  {
+    for (auto& pending: _batches)
+      if (pending.type.lang == type.lang && pending.type.subtype == type.subtype)
+        return pending.batch;
+
+    return _batches.emplace_back(type, File_batch(type.subtype, padding_bytes)).batch;
+  }
 
-    auto const it = std::upper_bound(_desc.begin(), _desc.end(), probe);
 
-    if (it == _desc.end() || it->ext.compare(probe.ext) != 0)
+  void File_type_dispatcher::accumulate(File_type type, File_analysis const& analysis)
+  {
+    auto& result = this->result(type.lang);
+#if defined(SRCSTATS_STATIC_LANGUAGES)
+    if (Languages::visit(type.lang, [&](auto const& lang)
+          { lang.accumulate(result, analysis.raw, analysis.decommented, type.subtype); }))
+      return;
+#endif
+
+    result.accumulate(analysis.raw, analysis.decommented, type.subtype);
+  }
+
+
+  void File_type_dispatcher::_process(File_type type, File_batch& batch)
+  {
+    auto& result = this->result(type.lang);
+#if defined(SRCSTATS_STATIC_LANGUAGES)
+    if (!Languages::visit(type.lang, [&](auto const& lang) { lang.analyze_batch(batch, result); }))
+#endif
+      type.lang->analyze_batch(batch, result);
+
+    batch.clear();
+  }
+
+
+  void File_type_dispatcher::flush()
+  {
+    for (auto& [type, batch]: _batches)
+      if (!batch.is_empty())
+        _process(type, batch);
+  }
+
+
+  bool File_type_dispatcher::_detect_and_process(std::filesystem::path const& filename)
+  {
+    if (!with_file_name(filename, is_detection_candidate))
+      return false;
+
+    auto const head = read_file_head(filename);
+    auto const type = _detect(filename, head.view());
+    if (!type)
       return false;
 
-    constexpr size_t padding_bytes     = 16;
-    constexpr size_t maximal_file_size = size_t(10) << 20;
+    if (_sniffing && skip({ sniff(head.view()), head.size }))
+      return true;
+
+    if (!head.is_whole() || _streaming)
+    {
+      _process(type, filename);
+      return true;
+    }
+
+    // Small files are read completely with their heads.
+    auto buffer = _buffers.borrow(head.length + padding_bytes);
+    buffer->assign(head.view());
+    buffer->append(padding_bytes, characters::NUL);
+    buffer->resize(head.length);
+
+    process(type, *buffer);
+    return true;
+  }
+
 
-    auto file_data = read_file_to_memory(filename, padding_bytes, maximal_file_size);
-    normalize(file_data);
+  bool File_type_dispatcher::operator()(std::filesystem::path const& filename)
+  {
+    auto const type = find(filename);
+    if (!type)
+      return _detecting && _detect_and_process(filename);
 
-    auto&      lang = *it->lang;
-    auto const st   =  it->subtype;
+    if (_sniffing && skip(sniff_file(filename)))
+      return true;
 
-    lang.accumulate_raw(file_data, st);
-    
-    lang.decomment_in_place(file_data, st);
-    remove_empty_lines_and_whitespace_endings(file_data);
-    lang.accumulate_decommented(file_data, st);
+    _process(type, filename);
     return true;
   }
 
@@ -23,57 +23,376 @@ SOFTWARE.
 ******************************************************************************/
 
 /// @file   file_type.hpp
-/// @brief  Recognize file type (currently only by its extension).
+/// @brief  Recognize file type by its extension or (optionally) by its contents.
 /// @author D.R.Kuvshinov kuvshinovdr at yandex.ru
 #ifndef SRCSTATS_FILE_TYPE_HPP_INCLUDED
 #define SRCSTATS_FILE_TYPE_HPP_INCLUDED
 
 #include "langs/lang_interface.hpp"
+#include "file.hpp"
+#include "file_batch.hpp"
+#include "sniff.hpp"
 
 #include <vector>
 #include <filesystem>
+#include <unordered_map>
 
 
 namespace srcstats
 {
 
-  /// @brief Given the file path dispatch it to the programming language object.
-  class File_type_dispatcher
+  /// @brief File type: the programming language analyzer and the file subtype.
+  struct File_type
+  {
+    Lang_interface const* lang    = nullptr;
+    int                   subtype = 0;
+
+    /// @brief Check if the file type has been recognized.
+    [[nodiscard]] explicit operator bool() const noexcept
+    {
+      return lang != nullptr;
+    }
+  };
+
+
+  /// @brief Statistics of one source file: as is and decommented.
+  struct File_analysis
+  {
+    File_statistics raw, decommented;
+
+    /// @brief Keep the sketches of the line lengths of both texts (see File_statistics::use_line_quantiles).
+    void use_line_quantiles()
+    {
+      raw.use_line_quantiles();
+      decommented.use_line_quantiles();
+    }
+  };
+
+
+  /// @brief How the statistics of a source file are computed.
+  enum class Analysis_mode
+  {
+    fused,      // cache-sized blocks go through all the steps, the decommented text is not stored (see analyze_chunk)
+    reference,  // normalize, decomment to a buffer, trim it and count lines of both texts (several passes)
+  };
+
+
+  /// @brief Given the file path dispatch it to the programming language analyzer.
+  /// Each worker thread has its own dispatcher accumulating its own language results
+  /// (aligned to cache lines as the counters are written), the analyzers are shared.
+  /// The other per-worker state (batches, buffers, directory preferences) must not change the results,
+  /// so they do not depend on which worker gets a file and in which order.
+  class alignas(cache_line_size) File_type_dispatcher
   {
   public:
-    /// @brief          Try to obtain the file type for the given file and call the corresponding language object.
-    /// Currently only the file extension is examined.
+    /// @brief How many zero bytes are appended to the file contents (required by the decommenters).
+    static constexpr size_t padding_bytes     = 16;
+
+    /// @brief Larger files are processed by chunks (see analyze_stream).
+    static constexpr size_t maximal_file_size = size_t(10) << 20;
+
+    /// @brief The size of the chunks large files are read by.
+    static constexpr size_t stream_chunk_size = size_t(64) << 10;
+
+
+    /// @brief          Try to obtain the file type for the given file and call the corresponding language analyzer.
+    /// The file extension is examined, if detection is used the files without extensions are detected by 
+    /// their heads (which are reused if they contain the whole files). Files larger than maximal_file_size 
+    /// are processed by chunks. If sniffing is used, binary, generated and minified files are counted apart 
+    /// without reading them.
     /// @param filename path to the file
     /// @return         true if the file type was found, false otherwise
     bool operator()(std::filesystem::path const& filename);
 
+    /// @brief          Try to obtain the file type for the given file (may be called from several threads).
+    /// Currently only the file extension is examined, it is taken from the path bytes without allocations.
+    /// @param filename path to the file
+    /// @return         the file type, it is false if the type was not found
+    [[nodiscard]] File_type find(std::filesystem::path const& filename) const;
+
+    /// @brief      Try to obtain the file type for the given file name without the directory part.
+    /// The extension is looked up in a perfect hash table: one hash of its bytes and one comparison.
+    /// @param name file name (as read from a directory)
+    /// @return     the file type, it is false if the type was not found
+    [[nodiscard]] File_type find(String_view name) const noexcept;
+
+    /// @brief      Check if the file name has no extension, so its type may be detected by the contents.
+    /// @param name file name (as read from a directory)
+    [[nodiscard]] static bool is_detection_candidate(String_view name) noexcept
+    {
+      return !name.empty() && name.find('.') == NPOS;
+    }
+
+    /// @brief          Detect the type of a file without an extension by its head (see detect_language).
+    /// The types detected with a low confidence are accepted only if the directory prefers the language:
+    /// another file without an extension in it is detected confidently as this language.
+    /// @param filename path to the file
+    /// @return         the file type, it is false if detection is not used, the file has an extension 
+    ///                 or the type was not detected
+    [[nodiscard]] File_type detect(std::filesystem::path const& filename);
+
+    /// @brief          Read a source file to memory (padded and size limited as the analysis requires).
+    /// @param filename path to the file
+    /// @return         file data object storing file byte content
+    [[nodiscard]] static File_data read(std::filesystem::path const& filename)
+    {
+      return read_file_to_memory(filename, padding_bytes, maximal_file_size);
+    }
+
+    /// @brief          Map a source file to memory (padded and size limited as the analysis requires).
+    /// @param filename path to the file
+    /// @return         mapped file object
+    [[nodiscard]] static Mapped_file map(std::filesystem::path const& filename)
+    {
+      return Mapped_file(filename, padding_bytes, maximal_file_size);
+    }
+
+    /// @brief           Compute raw and decommented statistics of a source file by blocks (the fused mode).
+    /// The byte order mark is skipped, UTF-16 files are transcoded to UTF-8 first (see decode_text).
+    /// @param type      the file type (must be recognized)
+    /// @param input     the file contents (no padding is required), it is not changed
+    /// @param quantiles keep the sketches of the line lengths (see File_analysis::use_line_quantiles)
+    /// @return          the file statistics
+    [[nodiscard]] static File_analysis analyze(File_type type, String_view input, bool quantiles = false);
+
+    /// @brief           Compute raw and decommented statistics of a source file.
+    /// @param type      the file type (must be recognized)
+    /// @param input     the file contents followed by padding_bytes readable zeros, it may be stored in the buffer
+    /// @param buffer    the working memory (used by the reference mode only), input is not changed unless 
+    ///                  it is stored here
+    /// @param mode      how the statistics are computed, the results are the same
+    /// @param quantiles keep the sketches of the line lengths (see File_analysis::use_line_quantiles)
+    /// @return          the file statistics
+    [[nodiscard]] static File_analysis analyze(File_type type, String_view input, File_data& buffer, 
+                                               Analysis_mode mode, bool quantiles = false);
+
+    /// @brief           Compute raw and decommented statistics of a source file.
+    /// @param type      the file type (must be recognized)
+    /// @param file_data the file contents as returned by read, it may be decommented in place
+    /// @param mode      how the statistics are computed
+    /// @param quantiles keep the sketches of the line lengths (see File_analysis::use_line_quantiles)
+    /// @return          the file statistics
+    [[nodiscard]] static File_analysis analyze(File_type type, File_data& file_data, 
+                                               Analysis_mode mode = Analysis_mode::fused, bool quantiles = false)
+    {
+      return analyze(type, file_data, file_data, mode, quantiles);
+    }
+
+    /// @brief           Compute raw and decommented statistics of a source file of any size reading it by chunks.
+    /// Memory usage does not depend on the file size, the result is the same as the result of analyze.
+    /// @param type      the file type (must be recognized)
+    /// @param filename  path to the file
+    /// @param mode      how the statistics of the chunks are computed
+    /// @param quantiles keep the sketches of the line lengths (see File_analysis::use_line_quantiles)
+    /// @return          the file statistics
+    [[nodiscard]] static File_analysis analyze_stream(File_type type, std::filesystem::path const& filename,
+                                                      Analysis_mode mode = Analysis_mode::fused, 
+                                                      bool quantiles = false);
+
+    /// @brief          Accumulate the statistics of a source file in the result of its language (see results).
+    /// @param type     the file type (must be recognized by this dispatcher)
+    /// @param analysis the file statistics
+    void accumulate(File_type type, File_analysis const& analysis);
+
+    /// @brief           Analyze a source file and accumulate its statistics in the result of its language.
+    /// @param type      the file type (must be recognized)
+    /// @param file_data the file contents as returned by read, it may be decommented in place
+    void process(File_type type, File_data& file_data)
+    {
+      accumulate(type, analyze(type, file_data, _analysis_mode, _quantiles));
+    }
+
+    /// @brief      Add a small file to the batch of its type, analyze the batch when it is full (see batching).
+    /// @param type the file type (must be recognized)
+    /// @param read called as read(batch), appends the file to the batch (e.g. read_file_to_batch), 
+    ///             returns false if the file is too large to be batched
+    /// @return     the result of read
+    bool add_to_batch(File_type type, auto read)
+    {
+      auto& batch = _batch(type);
+      if (!read(batch))
+        return false;
+
+      if (batch.is_full())
+        _process(type, batch);
+
+      return true;
+    }
+
+    /// @brief Analyze the batches which are not full yet and accumulate their statistics.
+    /// To be called when all the files have been passed (before the results are used or merged).
+    void flush();
+
+    /// @brief      Analyze a memory mapped source file and accumulate its statistics in the result of its language.
+    /// The reference mode transforms the file in a buffer borrowed from the pool.
+    /// @param type the file type (must be recognized)
+    /// @param file the mapped file as returned by map
+    void process(File_type type, Mapped_file const& file);
+
+    /// @brief Process all files by chunks in operator() (otherwise only the files larger than maximal_file_size).
+    void use_streaming(bool enabled) noexcept
+    {
+      _streaming = enabled;
+    }
+
+    /// @brief Pack the small files to batches analyzed by one call each (see File_batch, the default), 
+    /// used unless the files are streamed, memory mapped, analyzed by the reference mode or sketched.
+    void use_batching(bool enabled) noexcept
+    {
+      _batching = enabled;
+    }
+
+    /// @brief Check if the small files are packed to batches (see use_batching).
+    [[nodiscard]] bool batching() const noexcept
+    {
+      return _batching && !_streaming && !_memory_mapping && !_quantiles && _analysis_mode == Analysis_mode::fused;
+    }
+
+    /// @brief Compute the statistics by the old multi-pass algorithm (see Analysis_mode) to check the fused one.
+    void use_reference_analysis(bool enabled) noexcept
+    {
+      _analysis_mode = enabled ? Analysis_mode::reference : Analysis_mode::fused;
+    }
+
+    /// @brief Read the heads of the files before reading them, skip binary, generated and minified files (see sniff).
+    void use_sniffing(bool enabled) noexcept
+    {
+      _sniffing = enabled;
+    }
+
+    /// @brief Check if the files are sniffed before reading.
+    [[nodiscard]] bool sniffing() const noexcept
+    {
+      return _sniffing;
+    }
+
+    /// @brief Detect the languages of the files without extensions by their contents (see detect).
+    void use_detection(bool enabled) noexcept
+    {
+      _detecting = enabled;
+    }
+
+    /// @brief Check if the files without extensions are detected.
+    [[nodiscard]] bool detecting() const noexcept
+    {
+      return _detecting;
+    }
+
+    /// @brief      Count the sniffed file apart if it is not a source file.
+    /// @param file the result of sniff_file
+    /// @return     true if the file is to be skipped
+    bool skip(Sniffed_file const& file) noexcept
+    {
+      if (file.kind == File_kind::source)
+        return false;
+
+      _skipped.count(file);
+      return true;
+    }
+
+    /// @brief Get the counters of the files skipped after sniffing.
+    [[nodiscard]] Sniff_counters const& skipped() const noexcept
+    {
+      return _skipped;
+    }
+
+    /// @brief Keep the sketches of the line lengths to estimate their percentiles (see Quantile_sketch).
+    void use_quantiles(bool enabled) noexcept
+    {
+      _quantiles = enabled;
+    }
+
+    /// @brief Check if the sketches of the line lengths are kept.
+    [[nodiscard]] bool quantiles() const noexcept
+    {
+      return _quantiles;
+    }
+
+    /// @brief Get the mode the statistics are computed in.
+    [[nodiscard]] Analysis_mode analysis_mode() const noexcept
+    {
+      return _analysis_mode;
+    }
+
+    /// @brief Access the pool of the file buffers (used by the thread owning this dispatcher).
+    [[nodiscard]] Buffer_pool& buffers() noexcept
+    {
+      return _buffers;
+    }
+
+    /// @brief Memory map the files instead of reading them in operator().
+    void use_memory_mapping(bool enabled) noexcept
+    {
+      _memory_mapping = enabled;
+    }
+
     /// @brief           Add an association between a file extension and a file type (language).
-    /// @param ext       file extension
-    /// @param lang      language object that is to be called for this file type
+    /// The extension table is rebuilt, so the types are to be registered before the files are looked up.
+    /// A new empty result is made for each new language.
+    /// @param ext       file extension (with the dot)
+    /// @param lang      language analyzer that is to be called for this file type, it must outlive the dispatcher
     /// @param subtype   file subtype (e.g. header or source)
-    void register_file_type(std::filesystem::path ext,
-            Lang_interface* lang, int subtype = 0)
+    void register_file_type(String_view ext, Lang_interface const* lang, int subtype = 0);
+
+    /// @brief Get the statistics accumulated by this dispatcher, one result per registered language
+    /// in the order of registration.
+    [[nodiscard]] std::span<Lang_result_uptr const> results() const noexcept
     {
-      _desc.emplace_back(std::move(ext), lang, subtype);
-      _is_dirty = true;
+      return _results;
     }
 
+    /// @brief Get the statistics of a language accumulated by this dispatcher (the language must be registered).
+    [[nodiscard]] Lang_result& result(Lang_interface const* lang) noexcept;
+
+    /// @brief Add the statistics accumulated by another dispatcher having the same languages registered in the same order.
+    /// Other counters (e.g. skipped) are not merged.
+    void merge(File_type_dispatcher const& other);
+
   private:
 
-    /// @brief Description of a file type: filename extension, language statistics object, file subtype.
+    /// @brief The small files of a file type waiting to be analyzed.
+    struct Pending_batch
+    {
+      File_type  type;
+      File_batch batch;
+    };
+
+    /// @brief Description of a file type: filename extension, language analyzer, file subtype.
     struct File_type_desc
     {
-      std::filesystem::path ext;
-      Lang_interface*       lang    = nullptr;
+      String                ext;
+      Lang_interface const* lang    = nullptr;
       int                   subtype = 0;
 
       bool operator<(File_type_desc const&) const;
     };
 
-    std::vector<File_type_desc> _desc;
-    bool                        _is_dirty   = false;
+    std::vector<File_type_desc>  _desc;       // sorted, the first description of an extension is used
+    std::vector<unsigned>        _slots;      // perfect hash table of the extensions: _desc index + 1 or 0 if empty
+    uint64_t                     _seed  = 0;  // the seed of hash_extension giving no collisions
+    unsigned                     _shift = 64; // the slot is the hash shifted right by this
+    std::vector<Lang_interface const*> _langs; // the distinct registered languages (the detection candidates)
+    std::vector<Lang_result_uptr> _results;   // the statistics accumulated by this dispatcher, one per _langs item
+    std::unordered_map<String, std::vector<Lang_interface const*>> _directory_langs; // preferred languages
+    std::vector<Pending_batch>   _batches;    // one per file type met
+    Buffer_pool                  _buffers;
+    Sniff_counters               _skipped;
+    bool                         _memory_mapping = false;
+    bool                         _streaming      = false;
+    bool                         _sniffing       = false;
+    bool                         _detecting      = false;
+    bool                         _quantiles      = false;
+    bool                         _batching       = true;
+    Analysis_mode                _analysis_mode  = Analysis_mode::fused;
 
-    void _sort();
+    void                      _build_extension_table();
+    [[nodiscard]] File_type   _find_extension(String_view ext) const noexcept;
+    [[nodiscard]] File_type   _detect(std::filesystem::path const& filename, String_view head);
+    [[nodiscard]] std::vector<Lang_interface const*> const& _preferred_langs(std::filesystem::path const& directory);
+    void                      _process(File_type type, std::filesystem::path const& filename);
+    [[nodiscard]] File_batch& _batch(File_type type);
+    void                      _process(File_type type, File_batch& batch);
+    bool                      _detect_and_process(std::filesystem::path const& filename);
   };
 
 }
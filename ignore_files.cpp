@@ -0,0 +1,193 @@
+/******************************************************************************
+MIT License
+
+Copyright (c) 2024 Dmitry R. Kuvshinov
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+******************************************************************************/
+
+/// @file   ignore_files.cpp
+/// @brief  Ignore files support, ignore_files.hpp implementation.
+/// @author D.R.Kuvshinov kuvshinovdr at yandex.ru
+
+#include "ignore_files.hpp"
+
+#include <algorithm>
+
+
+namespace srcstats
+{
+
+  std::optional<Ignore_rule> Ignore_rule::parse(String_view line)
+  {
+    if (line.ends_with('\r'))
+      line.remove_suffix(1);
+
+    // Trailing spaces are ignored unless escaped.
+    while (line.ends_with(' ') && !line.ends_with("\\ "sv))
+      line.remove_suffix(1);
+
+    if (line.empty() || line.front() == '#')
+      return std::nullopt;
+
+    Ignore_rule rule;
+    if (line.front() == '!')
+    {
+      rule._negated = true;
+      line.remove_prefix(1);
+    }
+    else if (line.starts_with("\\!"sv) || line.starts_with("\\#"sv))
+    {
+      line.remove_prefix(1);
+    }
+
+    if (line.ends_with('/'))
+    {
+      rule._directory_only = true;
+      line.remove_suffix(1);
+    }
+
+    rule._anchored = line.find('/') != NPOS;
+
+    while (!line.empty())
+    {
+      auto const pos       = line.find('/');
+      auto const component = line.substr(0, pos);
+      line.remove_prefix(pos == NPOS ? line.size() : pos + 1);
+
+      if (component.empty())
+        continue;
+
+      if (component == "**"sv)
+        rule._components.emplace_back();
+      else
+        rule._components.emplace_back(Component_glob(component));
+    }
+
+    if (rule._components.empty())
+      return std::nullopt;
+
+    return rule;
+  }
+
+
+  bool Ignore_rule::matches(std::span<String_view const> relative, bool is_directory) const
+  {
+    if (_directory_only && !is_directory)
+      return false;
+
+    if (!_anchored)
+      return !_components.front() || _components.front()->matches(relative.back());
+
+    return _matches(0, relative);
+  }
+
+
+  bool Ignore_rule::_matches(size_t component, std::span<String_view const> relative) const
+  {
+    if (component == _components.size())
+      return relative.empty();
+
+    if (!_components[component])
+    {
+      // ** matches any count of components.
+      for (size_t skip = 0; skip <= relative.size(); ++skip)
+        if (_matches(component + 1, relative.subspan(skip)))
+          return true;
+
+      return false;
+    }
+
+    return !relative.empty()
+        && _components[component]->matches(relative.front())
+        && _matches(component + 1, relative.subspan(1));
+  }
+
+
+  unsigned Ignore_state::rule_source_bit(String_view name) noexcept
+  {
+    for (unsigned i = 0; i < std::size(rule_sources); ++i)
+      if (rule_sources[i] == name)
+        return 1u << i;
+
+    return 0;
+  }
+
+
+  bool Ignore_state::ignores(String_view name, bool is_directory) const
+  {
+    if (!_top)
+      return false;
+
+    thread_local std::vector<String_view> components;
+    components.assign(_path.begin(), _path.end());
+    components.push_back(name);
+
+    for (auto frame = _top.get(); frame; frame = frame->parent.get())
+    {
+      auto const relative = std::span<String_view const>(components).subspan(frame->depth);
+      for (auto rule = frame->rules.rbegin(); rule != frame->rules.rend(); ++rule)
+        if (rule->matches(relative, is_directory))
+          return !rule->is_negated();
+    }
+
+    return false;
+  }
+
+
+  Ignore_state Ignore_state::enter(String_view name) const
+  {
+    Ignore_state result;
+    if (_top)
+    {
+      result._top  = _top;
+      result._path = _path;
+      result._path.emplace_back(name);
+    }
+
+    return result;
+  }
+
+
+  void Ignore_state::_push(std::span<File_data const> contents)
+  {
+    auto frame = std::make_shared<Frame>();
+    for (String_view text: contents)
+    {
+      while (!text.empty())
+      {
+        auto const pos = text.find(characters::LF);
+        if (auto rule = Ignore_rule::parse(text.substr(0, pos)))
+          frame->rules.emplace_back(std::move(*rule));
+        text.remove_prefix(pos == NPOS ? text.size() : pos + 1);
+      }
+    }
+
+    if (frame->rules.empty())
+      return;
+
+    if (!_top)
+      _path.clear();
+
+    frame->parent = std::move(_top);
+    frame->depth  = _path.size();
+    _top          = std::move(frame);
+  }
+
+}
@@ -0,0 +1,155 @@
+/******************************************************************************
+MIT License
+
+Copyright (c) 2024 Dmitry R. Kuvshinov
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+******************************************************************************/
+
+/// @file   ignore_files.hpp
+/// @brief  Ignore files support (.gitignore syntax): per-directory rule stacks.
+/// @author D.R.Kuvshinov kuvshinovdr at yandex.ru
+#ifndef SRCSTATS_IGNORE_FILES_HPP_INCLUDED
+#define SRCSTATS_IGNORE_FILES_HPP_INCLUDED
+
+#include "exclusion.hpp"
+#include "report.hpp"
+
+#include <memory>
+#include <optional>
+#include <span>
+#include <vector>
+
+
+namespace srcstats
+{
+
+  /// @brief A rule (a line) of an ignore file.
+  class Ignore_rule
+  {
+  public:
+    /// @brief      Parse an ignore file line.
+    /// @param line the line without LF
+    /// @return     the rule or nothing if the line is empty or a comment
+    [[nodiscard]] static std::optional<Ignore_rule> parse(String_view line);
+
+    /// @brief Check if the rule is a negated one (re-includes matching entries).
+    [[nodiscard]] bool is_negated() const noexcept
+    {
+      return _negated;
+    }
+
+    /// @brief              Check if the rule matches a path.
+    /// @param relative     the path components relative to the directory of the ignore file
+    /// @param is_directory whether the path is a directory
+    [[nodiscard]] bool matches(std::span<String_view const> relative, bool is_directory) const;
+
+  private:
+    std::vector<std::optional<Component_glob>> _components; // nothing stands for **
+    bool _negated        = false;
+    bool _directory_only = false;
+    bool _anchored       = false; // match the whole relative path or only the entry name
+
+    [[nodiscard]] bool _matches(size_t component, std::span<String_view const> relative) const;
+  };
+
+
+  /// @brief Ignore rules in effect for a directory.
+  /// The rules of each directory are parsed once and pushed on a stack shared by its subdirectories,
+  /// the stack is popped (freed) when all the subdirectories have been walked.
+  class Ignore_state
+  {
+  public:
+    /// @brief Rule sources in the increasing precedence order (.git stands for .git/info/exclude).
+    static constexpr String_view rule_sources[] 
+    { 
+      ".git"sv, 
+      ".gitignore"sv, 
+      ".ignore"sv, 
+      ".srcstatsignore"sv 
+    };
+
+    /// @brief Get the bit corresponding to the rule_sources element with this name, 0 if there is none.
+    [[nodiscard]] static unsigned rule_source_bit(String_view name) noexcept;
+
+    /// @brief Check if the directory is not affected by any rules.
+    [[nodiscard]] bool empty() const noexcept
+    {
+      return !_top;
+    }
+
+    /// @brief              Check if a directory entry is ignored: the last matching rule of the deepest ignore file wins.
+    /// @param name         entry name
+    /// @param is_directory whether the entry is a directory
+    [[nodiscard]] bool ignores(String_view name, bool is_directory) const;
+
+    /// @brief      Get the state of a subdirectory (without its own rules).
+    /// @param name the subdirectory name
+    [[nodiscard]] Ignore_state enter(String_view name) const;
+
+    /// @brief           Read and push the rules of this directory's ignore files.
+    /// @param present   the rule_source_bit values of the rule sources present in the directory
+    /// @param read_file function reading a file of this directory: read_file(String const& relative_path) -> File_data
+    template <typename Read_file>
+    void load(unsigned present, Read_file read_file)
+    {
+      if (present == 0)
+        return;
+
+      std::vector<File_data> contents;
+      if (present & rule_source_bit(".git"sv))
+      {
+        try
+        {
+          contents.emplace_back(read_file(String{ ".git/info/exclude"sv }));
+        }
+        catch (File_error const&)
+        {
+          // It is normal for .git/info/exclude to be absent.
+        }
+      }
+
+      for (auto const name: std::span(rule_sources).subspan(1))
+        if (present & rule_source_bit(name))
+          run_and_report_exception([&contents, &read_file, name]
+            {
+              contents.emplace_back(read_file(String{ name }));
+            });
+
+      _push(contents);
+    }
+
+  private:
+    /// @brief Rules of one directory linked to the rules of its ancestors.
+    struct Frame
+    {
+      std::shared_ptr<Frame const> parent;
+      std::vector<Ignore_rule>     rules;
+      size_t                       depth = 0; // the directory position in _path
+    };
+
+    std::shared_ptr<Frame const> _top;
+    std::vector<String>          _path; // directory names below the bottom frame directory
+
+    void _push(std::span<File_data const> contents);
+  };
+
+}
+
+#endif//SRCSTATS_IGNORE_FILES_HPP_INCLUDED
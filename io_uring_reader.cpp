@@ -0,0 +1,468 @@
+/******************************************************************************
+MIT License
+
+Copyright (c) 2024 Dmitry R. Kuvshinov
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+******************************************************************************/
+/// @file   io_uring_reader.cpp
+/// @brief  Batched asynchronous file reading, io_uring_reader.hpp implementation.
+/// @author D.R.Kuvshinov kuvshinovdr at yandex.ru
+
+#include "io_uring_reader.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <system_error>
+#include <utility>
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#define SRCSTATS_HAS_IO_URING 1
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+#endif
+
+
+namespace srcstats
+{
+
+#if defined(SRCSTATS_HAS_IO_URING)
+
+  using namespace characters;
+
+  namespace
+  {
+
+    /// @brief Wrap a File_error or a derived exception object (not sliced).
+    [[nodiscard]] Io_uring_reader::Result make_error(auto const& error)
+    {
+      return Io_uring_reader::Result(std::unexpect, std::make_exception_ptr(error));
+    }
+
+  }
+
+
+
+  /// @brief The submission and completion queues shared with the kernel.
+  struct Io_uring_reader::Ring
+  {
+    int           fd        = -1;
+    void*         sq_ptr    = MAP_FAILED;
+    size_t        sq_size   = 0;
+    void*         cq_ptr    = MAP_FAILED;
+    size_t        cq_size   = 0;
+    io_uring_sqe* sqes      = static_cast<io_uring_sqe*>(MAP_FAILED);
+    size_t        sqes_size = 0;
+
+    unsigned*     sq_tail   = nullptr;
+    unsigned      sq_mask   = 0;
+    unsigned*     sq_array  = nullptr;
+    unsigned*     cq_head   = nullptr;
+    unsigned*     cq_tail   = nullptr;
+    unsigned      cq_mask   = 0;
+    io_uring_cqe* cqes      = nullptr;
+
+    std::vector<struct statx> statx_buffers; // one per slot
+
+    /// @brief         Set up the ring, throw std::system_error on failure.
+    /// @param entries the submission queue size
+    explicit Ring(unsigned entries)
+    {
+      io_uring_params params {};
+      fd = static_cast<int>(::syscall(SYS_io_uring_setup, entries, &params));
+      if (fd < 0)
+        throw std::system_error(errno, std::system_category(), "io_uring_setup");
+
+      try
+      {
+        // openat, statx and read operations are available since the same kernel version as this feature.
+        if (!(params.features & IORING_FEAT_RW_CUR_POS))
+          throw std::system_error(ENOSYS, std::system_category(), "io_uring is too old");
+
+        sq_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        cq_size = params.cq_off.cqes  + params.cq_entries * sizeof(io_uring_cqe);
+        bool const single_mmap = params.features & IORING_FEAT_SINGLE_MMAP;
+        if (single_mmap)
+          sq_size = cq_size = max(sq_size, cq_size);
+
+        sq_ptr = _map(sq_size, IORING_OFF_SQ_RING);
+        cq_ptr = single_mmap ? sq_ptr : _map(cq_size, IORING_OFF_CQ_RING);
+        sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+        sqes = static_cast<io_uring_sqe*>(_map(sqes_size, IORING_OFF_SQES));
+
+        auto const sq = static_cast<char*>(sq_ptr), cq = static_cast<char*>(cq_ptr);
+        sq_tail  = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+        sq_mask  = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+        sq_array = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+        cq_head  = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+        cq_tail  = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+        cq_mask  = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+        cqes     = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+      }
+      catch (...)
+      {
+        _release();
+        throw;
+      }
+    }
+
+    ~Ring()
+    {
+      _release();
+    }
+
+    Ring(Ring const&)            = delete;
+    Ring& operator=(Ring const&) = delete;
+
+    /// @brief Put a request to the submission queue (there is always room: one request per slot at most).
+    void push(io_uring_sqe const& sqe) noexcept
+    {
+      auto const tail  = *sq_tail;
+      auto const index = tail & sq_mask;
+      sqes[index]     = sqe;
+      sq_array[index] = index;
+      std::atomic_ref(*sq_tail).store(tail + 1, std::memory_order_release);
+    }
+
+    /// @brief  Submit the requests and wait for completions, throw std::system_error on failure.
+    /// @return how many requests have been submitted
+    unsigned enter(unsigned to_submit, unsigned min_complete)
+    {
+      for (;;)
+      {
+        auto const result = ::syscall(SYS_io_uring_enter, fd, to_submit, min_complete, 
+                                      IORING_ENTER_GETEVENTS, nullptr, 0);
+        if (result >= 0)
+          return static_cast<unsigned>(result);
+        if (errno != EINTR)
+          throw std::system_error(errno, std::system_category(), "io_uring_enter");
+      }
+    }
+
+    /// @brief        Take the available completions calling handle(slot, result) for each one.
+    /// The queue head is advanced before each call, so the handler may throw.
+    /// @return       how many completions have been taken
+    unsigned take_completions(auto handle)
+    {
+      unsigned taken = 0;
+      auto head = *cq_head;
+      for (auto const tail = std::atomic_ref(*cq_tail).load(std::memory_order_acquire); 
+           head != tail; ++taken)
+      {
+        auto const cqe = cqes[head & cq_mask];
+        std::atomic_ref(*cq_head).store(++head, std::memory_order_release);
+        handle(static_cast<unsigned>(cqe.user_data), cqe.res);
+      }
+
+      return taken;
+    }
+
+  private:
+    void* _map(size_t size, off_t offset)
+    {
+      auto const result = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, offset);
+      if (result == MAP_FAILED)
+        throw std::system_error(errno, std::system_category(), "io_uring mmap");
+      return result;
+    }
+
+    void _release() noexcept
+    {
+      if (sqes != MAP_FAILED)
+        ::munmap(sqes, sqes_size);
+      if (cq_ptr != MAP_FAILED && cq_ptr != sq_ptr)
+        ::munmap(cq_ptr, cq_size);
+      if (sq_ptr != MAP_FAILED)
+        ::munmap(sq_ptr, sq_size);
+      if (fd >= 0)
+        ::close(fd);
+    }
+  };
+
+
+  bool io_uring_supported() noexcept
+  {
+    static bool const supported = []
+      {
+        try
+        {
+          Io_uring_reader reader(1);
+          return true;
+        }
+        catch (...)
+        {
+          return false;
+        }
+      }();
+
+    return supported;
+  }
+
+
+  Io_uring_reader::Io_uring_reader(unsigned depth, size_t padding_bytes, size_t max_file_size)
+    : _ring(std::make_unique<Ring>(depth != 0 ? depth : 1)),
+      _slots(depth != 0 ? depth : 1),
+      _padding_bytes(padding_bytes),
+      _max_file_size(max_file_size)
+  {
+    _ring->statx_buffers.resize(_slots.size());
+    _free_slots.reserve(_slots.size());
+    for (auto slot = static_cast<unsigned>(_slots.size()); slot-- != 0;)
+      _free_slots.push_back(slot);
+  }
+
+
+  Io_uring_reader::~Io_uring_reader()
+  {
+    // The kernel may still write to the buffers of the submitted requests.
+    try
+    {
+      while (_pending != 0)
+      {
+        _ring->enter(0, 1);
+        _pending -= _ring->take_completions([this](unsigned slot, int result)
+          {
+            if (_slots[slot].stage == Stage::open && result >= 0)
+              ::close(result);
+          });
+      }
+    }
+    catch (...)
+    {
+      // Nothing to do, the buffers are freed anyway.
+    }
+
+    for (auto& slot: _slots)
+      if (slot.fd >= 0)
+        ::close(slot.fd);
+  }
+
+
+  unsigned Io_uring_reader::start(std::filesystem::path filename)
+  {
+    auto const slot = _free_slots.back();
+    _free_slots.pop_back();
+
+    _slots[slot].filename = std::move(filename);
+    _queue_open(slot);
+    return slot;
+  }
+
+
+  void Io_uring_reader::wait(Completion const& on_done)
+  {
+    auto const submitted = _ring->enter(_queued, 1);
+    _queued  -= submitted;
+    _pending += submitted;
+
+    _ring->take_completions([this, &on_done](unsigned slot, int result)
+      {
+        --_pending;
+        _complete(slot, result, on_done);
+      });
+  }
+
+
+  void Io_uring_reader::abandon(std::function<void(unsigned, std::filesystem::path const&)> const& on_abandon)
+  {
+    for (unsigned slot = 0; slot < _slots.size(); ++slot)
+    {
+      auto& s = _slots[slot];
+      if (s.stage == Stage::idle || s.stage == Stage::abandoned)
+        continue;
+
+      // The destructor closes the descriptor opened by a pending openat.
+      if (s.stage != Stage::open)
+        s.stage = Stage::abandoned;
+      on_abandon(slot, s.filename);
+    }
+  }
+
+
+  void Io_uring_reader::_queue_open(unsigned slot)
+  {
+    auto& s = _slots[slot];
+    io_uring_sqe sqe {};
+    sqe.opcode     = IORING_OP_OPENAT;
+    sqe.fd         = AT_FDCWD;
+    sqe.addr       = reinterpret_cast<uintptr_t>(s.filename.c_str());
+    sqe.open_flags = O_RDONLY | O_CLOEXEC;
+    sqe.user_data  = slot;
+
+    s.stage = Stage::open;
+    _ring->push(sqe);
+    ++_queued;
+  }
+
+
+  void Io_uring_reader::_queue_statx(unsigned slot)
+  {
+    static char const empty_path[] = "";
+
+    auto& s = _slots[slot];
+    io_uring_sqe sqe {};
+    sqe.opcode      = IORING_OP_STATX;
+    sqe.fd          = s.fd;
+    sqe.addr        = reinterpret_cast<uintptr_t>(empty_path);
+    sqe.len         = STATX_SIZE;
+    sqe.statx_flags = AT_EMPTY_PATH;
+    sqe.off         = reinterpret_cast<uintptr_t>(&_ring->statx_buffers[slot]);
+    sqe.user_data   = slot;
+
+    s.stage = Stage::statx;
+    _ring->push(sqe);
+    ++_queued;
+  }
+
+
+  void Io_uring_reader::_queue_read(unsigned slot)
+  {
+    constexpr size_t max_read_size = size_t(1) << 30;
+
+    auto& s = _slots[slot];
+    io_uring_sqe sqe {};
+    sqe.opcode    = IORING_OP_READ;
+    sqe.fd        = s.fd;
+    sqe.addr      = reinterpret_cast<uintptr_t>(s.file_data.data() + s.offset);
+    sqe.len       = static_cast<unsigned>(min(s.size - s.offset, max_read_size));
+    sqe.off       = s.offset;
+    sqe.user_data = slot;
+
+    s.stage = Stage::read;
+    _ring->push(sqe);
+    ++_queued;
+  }
+
+
+  void Io_uring_reader::_complete(unsigned slot, int result, Completion const& on_done)
+  {
+    auto& s = _slots[slot];
+    switch (s.stage)
+    {
+    case Stage::open:
+      if (result < 0)
+        return _finish(slot, make_error(File_error("failed to open", s.filename, -result)), on_done);
+
+      s.fd = result;
+      return _queue_statx(slot);
+
+    case Stage::statx:
+      {
+        if (result < 0)
+          return _finish(slot, make_error(File_error("failed to get the file size", s.filename, -result)), on_done);
+
+        auto const file_size = _ring->statx_buffers[slot].stx_size;
+        if (file_size > static_cast<uintmax_t>(_max_file_size))
+          return _finish(slot, make_error(File_too_big(s.filename, file_size)), on_done);
+
+        s.size   = static_cast<size_t>(file_size);
+        s.offset = 0;
+        // Only the padding is zero-filled, the contents are read later.
+        s.file_data.resize_and_overwrite(s.size + _padding_bytes, [&s](Character* out, size_t size)
+          {
+            std::fill(out + s.size, out + size, NUL);
+            return size;
+          });
+        s.file_data.resize(s.size);
+        if (s.size == 0)
+          return _finish(slot, std::move(s.file_data), on_done);
+
+        return _queue_read(slot);
+      }
+
+    case Stage::read:
+      // Keep the errno as for openat and statx or, as the other readers, the count of bytes read if the file is cut.
+      if (result < 0)
+        return _finish(slot, make_error(File_error("failed to read", s.filename, -result)), on_done);
+      if (result == 0)
+        return _finish(slot, make_error(File_error("failed to read", s.filename, s.offset)), on_done);
+
+      s.offset += static_cast<size_t>(result);
+      if (s.offset < s.size)
+        return _queue_read(slot);
+
+      return _finish(slot, std::move(s.file_data), on_done);
+
+    case Stage::idle:
+    case Stage::abandoned:
+      break;
+    }
+  }
+
+
+  void Io_uring_reader::_finish(unsigned slot, Result result, Completion const& on_done)
+  {
+    auto& s = _slots[slot];
+    if (s.fd >= 0)
+    {
+      ::close(s.fd);
+      s.fd = -1;
+    }
+
+    s.stage = Stage::idle;
+    s.filename.clear();
+    s.file_data = {};
+    _free_slots.push_back(slot);
+
+    on_done(slot, std::move(result));
+  }
+
+#else
+
+  struct Io_uring_reader::Ring {};
+
+
+  bool io_uring_supported() noexcept
+  {
+    return false;
+  }
+
+
+  Io_uring_reader::Io_uring_reader(unsigned, size_t padding_bytes, size_t max_file_size)
+    : _padding_bytes(padding_bytes), _max_file_size(max_file_size)
+  {
+    throw std::system_error(ENOSYS, std::system_category(), "io_uring is not supported on this platform");
+  }
+
+
+  Io_uring_reader::~Io_uring_reader() = default;
+
+
+  unsigned Io_uring_reader::start(std::filesystem::path)
+  {
+    return 0;
+  }
+
+
+  void Io_uring_reader::wait(Completion const&) {}
+  void Io_uring_reader::abandon(std::function<void(unsigned, std::filesystem::path const&)> const&) {}
+  void Io_uring_reader::_queue_open(unsigned) {}
+  void Io_uring_reader::_queue_statx(unsigned) {}
+  void Io_uring_reader::_queue_read(unsigned) {}
+  void Io_uring_reader::_complete(unsigned, int, Completion const&) {}
+  void Io_uring_reader::_finish(unsigned, Result, Completion const&) {}
+
+#endif
+
+}
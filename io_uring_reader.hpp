@@ -0,0 +1,141 @@
+/******************************************************************************
+MIT License
+
+Copyright (c) 2024 Dmitry R. Kuvshinov
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+******************************************************************************/
+/// @file   io_uring_reader.hpp
+/// @brief  Batched asynchronous file reading with Linux io_uring.
+/// @author D.R.Kuvshinov kuvshinovdr at yandex.ru
+#ifndef SRCSTATS_IO_URING_READER_HPP_INCLUDED
+#define SRCSTATS_IO_URING_READER_HPP_INCLUDED
+
+#include "file.hpp"
+#include "basic.hpp"
+
+#include <exception>
+#include <expected>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <vector>
+
+
+namespace srcstats
+{
+
+  /// @brief Check if io_uring can be used (Linux 5.6 or newer, not disabled by the system).
+  [[nodiscard]] bool io_uring_supported() noexcept;
+
+
+  /// @brief Reads many files at once keeping open, statx and read requests of all of them in flight.
+  /// Each file occupies a slot until it is read completely: openat -> statx -> read (repeated for short reads).
+  /// The object is to be used by one thread.
+  class Io_uring_reader
+  {
+  public:
+    /// @brief The result of reading a file: its contents followed by the padding bytes or the error (File_error).
+    using Result = std::expected<File_data, std::exception_ptr>;
+
+    /// @brief Called for each finished file: on_done(slot, result).
+    using Completion = std::function<void(unsigned, Result)>;
+
+    /// @brief               Create the ring, throw std::system_error if io_uring is not available.
+    /// @param depth         how many files may be read at once
+    /// @param padding_bytes how many additional zero bytes should be appended to the end of the file contents
+    /// @param max_file_size maximal file size possible, larger files are reported as File_too_big
+    explicit Io_uring_reader(
+        unsigned depth,
+        size_t   padding_bytes = 0,
+        size_t   max_file_size = ~size_t(0) / 2
+      );
+
+    ~Io_uring_reader();
+
+    Io_uring_reader(Io_uring_reader const&)            = delete;
+    Io_uring_reader& operator=(Io_uring_reader const&) = delete;
+
+    /// @brief Get the maximal count of files read at once.
+    [[nodiscard]] unsigned depth() const noexcept
+    {
+      return static_cast<unsigned>(_slots.size());
+    }
+
+    /// @brief Get the count of files being read.
+    [[nodiscard]] unsigned in_flight() const noexcept
+    {
+      return depth() - static_cast<unsigned>(_free_slots.size());
+    }
+
+    /// @brief Check if there are no free slots (start may not be called).
+    [[nodiscard]] bool full() const noexcept
+    {
+      return _free_slots.empty();
+    }
+
+    /// @brief          Queue reading of a file, the request is submitted by the next wait() call.
+    /// @param filename path to the file
+    /// @return         the slot index passed to the completion callback
+    unsigned start(std::filesystem::path filename);
+
+    /// @brief         Submit the queued requests, wait for at least one completion and handle all the completions.
+    /// Follow-up requests of the files (statx after openat, read after statx) are queued for the next call.
+    /// @param on_done called for each file which has been read completely or has failed
+    void wait(Completion const& on_done);
+
+    /// @brief             Give up the files in flight after wait() has thrown (the ring has failed).
+    /// Their slots stay occupied: the kernel may still complete the submitted requests until the destructor.
+    /// @param on_abandon  called for each file given up: on_abandon(slot, filename)
+    void abandon(std::function<void(unsigned, std::filesystem::path const&)> const& on_abandon);
+
+  private:
+    /// @brief The request in flight.
+    enum class Stage { idle, open, statx, read, abandoned };
+
+    struct Slot
+    {
+      std::filesystem::path filename;
+      File_data             file_data;
+      size_t                size   = 0;  // the file size (without the padding)
+      size_t                offset = 0;  // how many bytes have been read
+      int                   fd     = -1;
+      Stage                 stage  = Stage::idle;
+    };
+
+    struct Ring;
+
+    std::unique_ptr<Ring> _ring;
+    std::vector<Slot>     _slots;
+    std::vector<unsigned> _free_slots;
+    unsigned              _queued  = 0;  // requests written to the ring but not submitted yet
+    unsigned              _pending = 0;  // requests submitted but not completed yet
+    size_t                _padding_bytes;
+    size_t                _max_file_size;
+
+    void _queue_open(unsigned slot);
+    void _queue_statx(unsigned slot);
+    void _queue_read(unsigned slot);
+    void _complete(unsigned slot, int result, Completion const& on_done);
+    void _finish(unsigned slot, Result result, Completion const& on_done);
+  };
+
+}
+
+#endif//SRCSTATS_IO_URING_READER_HPP_INCLUDED
@@ -29,58 +29,34 @@ SOFTWARE.
 #define SRCSTATS_CPP_DECOMMENT_HPP_INCLUDED
 
 #include "../../basic.hpp"
+#include "../decomment_lexer.hpp"
+#include "../decomment_stream.hpp"
 
 
 namespace srcstats
 {
   
-  /// @brief A finite state machine implementation that removes all comments from a C++ source.
-  class Cpp_decomment
+  /// @brief Lexical rules of C++ relevant to comment removal.
+  inline constexpr Lexer_rules cpp_lexer_rules
   {
-  public:
-    /// @brief       Setup the source data (with 2-character NUL padding!).
-    /// @param begin the pointer to the first character of the source data
-    /// @param end   the pointer after the last character of the source data (end[1] must be defined)
-    constexpr Cpp_decomment(Character const* begin, Character const* end) noexcept
-      : _cur(begin), _end(end) {}
-
-    /// @brief       Setup the source data (with 2-character NUL padding!).
-    /// @param data  the pointer to the first character of the source data
-    /// @param size  the size of the source data (data[size + 1] must be defined)
-    constexpr Cpp_decomment(Character const* data, size_t size) noexcept
-      : Cpp_decomment(data, data + size) {}
-
-    /// @brief       Setup the source data (with 2-character NUL padding!).
-    /// @param input input text span
-    explicit constexpr Cpp_decomment(String_view input) noexcept
-      : Cpp_decomment(input.data(), input.size()) {}
-
-    /// @brief       Do the job.
-    /// @param out   the pointer to the output buffer (must be no less than the source input)
-    /// @return      pointer to the end of the written data
-    Character* to(Character* out) noexcept
-    {
-      _out = out;
-      _run();
-      return _out;
-    }
-
-  private:
-    using In_ptr = Character const*;
-    using Out_ptr = Character*;
+    .line_comment        = "//"sv,
+    .block_comment_open  = "/*"sv,
+    .block_comment_close = "*/"sv,
+    .line_continuation   = characters::backslash,
+    .quotes              = "'\""sv,
+    .escape              = characters::backslash,
+    .raw_literal         = Raw_literal::delimited,
+    .raw_quote           = characters::quote,
+    .raw_prefix          = characters::R,
+    .raw_open            = characters::par_open,
+    .raw_close           = characters::par_close,
+  };
 
-    In_ptr    _cur{ nullptr };
-    In_ptr    _end{ nullptr };
-    Out_ptr   _out{ nullptr };
-    Character _comment{}; // a character which is to be output in place of the skipped comment
+  /// @brief A finite state machine implementation that removes all comments from a C++ source.
+  using Cpp_decomment = Decomment_lexer<cpp_lexer_rules>;
 
-    void   _run()                        noexcept;
-    In_ptr _skip_until_comment()         noexcept; // returns where comment starts, _cur is set just after the comment 
-    In_ptr _skip_literal(Character term) noexcept;
-    In_ptr _skip_raw_literal()           noexcept;
-    In_ptr _skip_single_line_comment()   noexcept;
-    In_ptr _skip_multiline_comment()     noexcept;
-  };
+  /// @brief A resumable version of Cpp_decomment (for sources given by chunks).
+  using Cpp_decomment_stream = Decomment_lexer_stream<cpp_lexer_rules>;
 
 }
 
@@ -23,61 +23,48 @@ SOFTWARE.
 ******************************************************************************/
 
 /// @file   cpp_stat.cpp
-/// @brief  Statistics accumulator class for C++ files implementation.
+/// @brief  Analyzer class for C++ files implementation.
 /// @author D.R.Kuvshinov kuvshinovdr at yandex.ru
 #include "cpp_stat.hpp"
-#include "cpp_decomment.hpp"
 
 #include "../../file_type.hpp"
-#include "../lang_base.hpp"
 
 
 namespace srcstats
 {
 
-  class Cpp_statistics
-    : public Lang_base<2>
+  void Cpp_analyzer::register_file_types(File_type_dispatcher& ftd) const
   {
-  public:
-    static constexpr int fst_header = 0;
-    static constexpr int fst_source = 1;
+    for (auto ext : { ".h"sv, ".hpp"sv, ".hxx"sv, "ixx"sv })
+      ftd.register_file_type(ext, this, fst_header);
 
-    /// @brief Initialize the base object.
-    Cpp_statistics()
-      : Lang_base({ "Header"sv, "Source"sv }) {}
+    for (auto ext : { ".c"sv, ".cc"sv, ".cpp"sv, ".cxx"sv })
+      ftd.register_file_type(ext, this, fst_source);
+  }
 
-    /// @brief Returns "C++" as the language name. 
-    [[nodiscard]] std::string_view language_name() const noexcept override
-    {
-      return "C++"sv;
-    }
 
-    /// @brief Register all file types corresponding to C++. 
-    void register_file_types(File_type_dispatcher& ftd) override
+  Content_signature Cpp_analyzer::content_signature() const noexcept
+  {
+    static constexpr std::string_view names[] { "c++"sv, "cpp"sv, "cxx"sv, "cling"sv };
+    static constexpr std::string_view keywords[]
     {
-      for (auto ext : { ".h"sv, ".hpp"sv, ".hxx"sv, "ixx"sv })
-        ftd.register_file_type(ext, this, fst_header);
-
-      for (auto ext : { ".c"sv, ".cc"sv, ".cpp"sv, ".cxx"sv })
-        ftd.register_file_type(ext, this, fst_source);
-    }
+      "#include"sv, "#define"sv, "#ifndef"sv, "#pragma"sv, "template"sv, "typename"sv,
+      "namespace"sv, "std::"sv, "public:"sv, "private:"sv, "constexpr"sv, "nullptr"sv,
+    };
 
-    /// @brief Remove comments in place.
-    void decomment_in_place(String& file_contents, int = 0) override
-    {
-      Cpp_decomment decomment(file_contents);
+    return { names, keywords, fst_header };
+  }
 
-      auto const new_size =
-        decomment.to(file_contents.data()) - file_contents.data();
 
-      file_contents.resize(new_size);
-    }
-  };
+  Character* Cpp_analyzer::decomment(String_view input, Character* out, int) const
+  {
+    return Cpp_decomment(input).to(out);
+  }
 
 
-  Lang_interface_uptr new_cpp_statistics()
+  Decomment_stream_uptr Cpp_analyzer::decomment_stream(int) const
   {
-    return std::make_unique<Cpp_statistics>();
+    return std::make_unique<Cpp_decomment_stream>();
   }
 
 }
@@ -23,19 +23,62 @@ SOFTWARE.
 ******************************************************************************/
 
 /// @file   cpp_stat.hpp
-/// @brief  Statistics accumulator interface for C++ files (separate header and source statistics).
+/// @brief  Analyzer of C++ files (separate header and source statistics).
 /// @author D.R.Kuvshinov kuvshinovdr at yandex.ru
 #ifndef SRCSTATS_CPP_STAT_HPP_INCLUDED
 #define SRCSTATS_CPP_STAT_HPP_INCLUDED
 
-#include "../lang_interface.hpp"
+#include "cpp_decomment.hpp"
+#include "../lang_base.hpp"
 
 
 namespace srcstats
 {
-  
-  /// @brief Make a new C++ statistics implementation object.
-  [[nodiscard]] Lang_interface_uptr new_cpp_statistics();
+
+  /// @brief C++ language analyzer. The analysis by blocks is defined here, so it is inlined 
+  /// where the class is known (see Language_set).
+  class Cpp_analyzer final
+    : public Lang_base<2>
+  {
+  public:
+    static constexpr int fst_header = 0;
+    static constexpr int fst_source = 1;
+
+    /// @brief Initialize the base object.
+    Cpp_analyzer()
+      : Lang_base({ "Header"sv, "Source"sv }) {}
+
+    /// @brief Returns "C++" as the language name. 
+    [[nodiscard]] std::string_view language_name() const noexcept override
+    {
+      return "C++"sv;
+    }
+
+    /// @brief Register all file types corresponding to C++. 
+    void register_file_types(File_type_dispatcher& ftd) const override;
+
+    /// @brief Modelines (-*- C++ -*-, vim: ft=cpp) and the headers of C++ sources, e.g. the standard library ones.
+    [[nodiscard]] Content_signature content_signature() const noexcept override;
+
+    /// @brief Remove comments.
+    Character* decomment(String_view input, Character* out, int = 0) const override;
+
+    /// @brief Make a new resumable decommenter.
+    [[nodiscard]] Decomment_stream_uptr decomment_stream(int = 0) const override;
+
+    /// @brief Compute raw and decommented statistics by blocks.
+    void analyze(String_view input, File_statistics& raw, File_statistics& decommented, int = 0) const override
+    {
+      Cpp_decomment_stream stream;
+      srcstats::analyze(stream, input, raw, decommented);
+    }
+
+    /// @brief Compute the statistics of a batch of sources one by one.
+    void analyze_batch(File_batch const& batch, Lang_result& result) const override
+    {
+      analyze_batch_by<Cpp_decomment_stream>(batch, result);
+    }
+  };
 
 }
 
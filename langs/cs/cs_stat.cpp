@@ -23,54 +23,45 @@ SOFTWARE.
 ******************************************************************************/
 
 /// @file   cs_stat.cpp
-/// @brief  Statistics accumulator class for C# files implementation.
+/// @brief  Analyzer class for C# files implementation.
 /// @author D.R.Kuvshinov kuvshinovdr at yandex.ru
 #include "cs_stat.hpp"
-#include "cs_decomment.hpp"
 
 #include "../../file_type.hpp"
-#include "../lang_base.hpp"
 
 
 namespace srcstats
 {
 
-  class Cs_statistics
-    : public Lang_base<1>
+  void Cs_analyzer::register_file_types(File_type_dispatcher& ftd) const
   {
-  public:
-    /// @brief Initialize the base object.
-    Cs_statistics() = default;
+    for (auto ext : { ".cs"sv, ".csx"sv })
+      ftd.register_file_type(ext, this);
+  }
 
-    /// @brief Returns "C#" as the language name. 
-    [[nodiscard]] std::string_view language_name() const noexcept override
-    {
-      return "C#"sv;
-    }
 
-    /// @brief Register all file types corresponding to C++. 
-    void register_file_types(File_type_dispatcher& ftd) override
+  Content_signature Cs_analyzer::content_signature() const noexcept
+  {
+    static constexpr std::string_view names[] { "csharp"sv, "c#"sv, "cs"sv, "dotnet-script"sv, "csi"sv };
+    static constexpr std::string_view keywords[]
     {
-      for (auto ext : { ".cs"sv, ".csx"sv })
-        ftd.register_file_type(ext, this);
-    }
+      "using System"sv, "namespace"sv, "public class"sv, "{ get;"sv,
+      "set; }"sv, "static void Main"sv, "async Task"sv, "readonly"sv,
+    };
 
-    /// @brief Remove comments in place.
-    void decomment_in_place(String& file_contents, int = 0) override
-    {
-      Cs_decomment decomment(file_contents);
+    return { names, keywords };
+  }
 
-      auto const new_size =
-        decomment.to(file_contents.data()) - file_contents.data();
 
-      file_contents.resize(new_size);
-    }
-  };
+  Character* Cs_analyzer::decomment(String_view input, Character* out, int) const
+  {
+    return Cs_decomment(input).to(out);
+  }
 
 
-  Lang_interface_uptr new_cs_statistics()
+  Decomment_stream_uptr Cs_analyzer::decomment_stream(int) const
   {
-    return std::make_unique<Cs_statistics>();
+    return std::make_unique<Cs_decomment_stream>();
   }
 
 }
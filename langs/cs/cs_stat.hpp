@@ -23,19 +23,58 @@ SOFTWARE.
 ******************************************************************************/
 
 /// @file   cs_stat.hpp
-/// @brief  Statistics accumulator interface for C# files.
+/// @brief  Analyzer of C# files.
 /// @author D.R.Kuvshinov kuvshinovdr at yandex.ru
 #ifndef SRCSTATS_CS_STAT_HPP_INCLUDED
 #define SRCSTATS_CS_STAT_HPP_INCLUDED
 
-#include "../lang_interface.hpp"
+#include "cs_decomment.hpp"
+#include "../lang_base.hpp"
 
 
 namespace srcstats
 {
-  
-  /// @brief Make a new C# statistics implementation object.
-  [[nodiscard]] Lang_interface_uptr new_cs_statistics();
+
+  /// @brief C# language analyzer. The analysis by blocks is defined here, so it is inlined 
+  /// where the class is known (see Language_set).
+  class Cs_analyzer final
+    : public Lang_base<1>
+  {
+  public:
+    /// @brief Initialize the base object.
+    Cs_analyzer() = default;
+
+    /// @brief Returns "C#" as the language name. 
+    [[nodiscard]] std::string_view language_name() const noexcept override
+    {
+      return "C#"sv;
+    }
+
+    /// @brief Register all file types corresponding to C#. 
+    void register_file_types(File_type_dispatcher& ftd) const override;
+
+    /// @brief Modelines (-*- csharp -*-, vim: ft=cs) and the shebangs of C# scripts.
+    [[nodiscard]] Content_signature content_signature() const noexcept override;
+
+    /// @brief Remove comments.
+    Character* decomment(String_view input, Character* out, int = 0) const override;
+
+    /// @brief Make a new resumable decommenter.
+    [[nodiscard]] Decomment_stream_uptr decomment_stream(int = 0) const override;
+
+    /// @brief Compute raw and decommented statistics by blocks.
+    void analyze(String_view input, File_statistics& raw, File_statistics& decommented, int = 0) const override
+    {
+      Cs_decomment_stream stream;
+      srcstats::analyze(stream, input, raw, decommented);
+    }
+
+    /// @brief Compute the statistics of a batch of sources one by one.
+    void analyze_batch(File_batch const& batch, Lang_result& result) const override
+    {
+      analyze_batch_by<Cs_decomment_stream>(batch, result);
+    }
+  };
 
 }
 
@@ -0,0 +1,849 @@
+/******************************************************************************
+MIT License
+
+Copyright (c) 2024 Dmitry R. Kuvshinov
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+******************************************************************************/
+/// @file   decomment_lexer.hpp
+/// @brief  Comment removal engine generated from the lexical rules of a language.
+/// @author D.R.Kuvshinov kuvshinovdr at yandex.ru
+#ifndef SRCSTATS_DECOMMENT_LEXER_HPP_INCLUDED
+#define SRCSTATS_DECOMMENT_LEXER_HPP_INCLUDED
+
+#include "../basic.hpp"
+#include "../text_simd.hpp"
+#include "decomment_stream.hpp"
+
+#include <algorithm>
+#include <array>
+
+
+namespace srcstats
+{
+
+  /// @brief Raw string literal forms (there are no escapes inside).
+  enum class Raw_literal : unsigned char
+  {
+    none,
+    delimited,      // prefix"delimiter(...)delimiter" as C++ R"x(...)x"
+    multiquote,     // three or more quotes closed by as many quotes as C# """..."""
+  };
+
+
+  /// @brief Lexical rules of a language relevant to comment removal (each language declares them as constexpr data).
+  struct Lexer_rules
+  {
+    String_view line_comment;        // two characters starting a comment lasting until the end of the line
+    String_view block_comment_open;  // two characters starting a comment lasting until block_comment_close
+    String_view block_comment_close; // two characters ending the comment
+    Character   line_continuation;   // a single-line comment goes on after a line ending with this character
+    String_view quotes;              // characters starting and ending literals
+    Character   escape;              // a character escaping the next one in a literal
+    Raw_literal raw_literal = Raw_literal::none;
+    Character   raw_quote   = {};    // the quote of raw literals
+    Character   raw_prefix  = {};    // delimited: the character before the opening quote
+    Character   raw_open    = {};    // delimited: the character after the opening delimiter
+    Character   raw_close   = {};    // delimited: the character before the closing delimiter
+  };
+
+
+  /// @brief What is to be done on a character.
+  enum class Lexer_action : unsigned char
+  {
+    code,           // nothing, the character is code (or it is skipped after a comment lead or a raw prefix)
+    comment_lead,   // the next character may start a comment
+    raw_prefix,     // the next character may start a raw literal
+    line_comment,
+    block_comment,
+    literal,
+    raw_literal,
+  };
+
+  /// @brief The dense transition table: actions by the state (code, after a comment lead, after a raw prefix, 
+  /// the same as the values of the actions entering them) and the character code.
+  using Lexer_table = std::array<std::array<Lexer_action, 256>, 3>;
+
+
+  /// @brief Check if the rules may be used by Decomment_lexer.
+  [[nodiscard]] constexpr bool is_supported(Lexer_rules const& rules) noexcept
+  {
+    auto const& line = rules.line_comment, open = rules.block_comment_open, close = rules.block_comment_close;
+    return line.size() == 2 && open.size() == 2 && close.size() == 2
+        && line[0] == open[0] && line[1] != open[1] && !rules.quotes.empty()
+        && rules.quotes.find(line[0]) == NPOS
+        && (rules.raw_literal != Raw_literal::delimited 
+            || (rules.raw_prefix != line[0] && rules.quotes.find(rules.raw_prefix) == NPOS))
+        && (rules.raw_literal != Raw_literal::multiquote || rules.quotes.find(rules.raw_quote) != NPOS);
+  }
+
+
+  /// @brief Build the transition table of the rules at compile time.
+  [[nodiscard]] constexpr Lexer_table make_lexer_table(Lexer_rules const& rules) noexcept
+  {
+    auto const at = [](Character ch) { return static_cast<unsigned char>(ch); };
+
+    Lexer_table table{}; // everything is code
+    auto& code  = table[static_cast<size_t>(Lexer_action::code)];
+    auto& lead  = table[static_cast<size_t>(Lexer_action::comment_lead)];
+    auto& raw   = table[static_cast<size_t>(Lexer_action::raw_prefix)];
+
+    code[at(rules.line_comment[0])]       = Lexer_action::comment_lead;
+    lead[at(rules.line_comment[1])]       = Lexer_action::line_comment;
+    lead[at(rules.block_comment_open[1])] = Lexer_action::block_comment;
+
+    for (auto const quote: rules.quotes)
+      code[at(quote)] = Lexer_action::literal;
+
+    if (rules.raw_literal == Raw_literal::delimited)
+    {
+      code[at(rules.raw_prefix)] = Lexer_action::raw_prefix;
+      raw[at(rules.raw_quote)]   = Lexer_action::raw_literal;
+    }
+
+    return table;
+  }
+
+
+  /// @brief How many characters start transitions from code.
+  [[nodiscard]] constexpr size_t count_starts(Lexer_table const& table) noexcept
+  {
+    return static_cast<size_t>(std::ranges::count_if(table[0], 
+             [](Lexer_action action) { return action != Lexer_action::code; }));
+  }
+
+  /// @brief Get the characters starting transitions from code (up to four, the first one is repeated if less).
+  [[nodiscard]] constexpr Four_characters find_starts(Lexer_table const& table) noexcept
+  {
+    Four_characters starts{};
+    size_t count = 0;
+    for (size_t i = 0; i < table[0].size() && count < starts.size(); ++i)
+      if (table[0][i] != Lexer_action::code)
+        starts[count++] = static_cast<Character>(i);
+
+    for (auto i = count; i < starts.size(); ++i)
+      starts[i] = starts[0];
+    return starts;
+  }
+
+
+  /// @brief       A finite state machine removing all comments from a source, specialized by the lexical rules.
+  /// Code is skipped up to the next character starting a transition (by a table lookup per character 
+  /// or by the vectorized searches), then the action is taken from the transition table. Literal contents
+  /// are skipped up to the first quote which is not escaped. The peculiarities are the same for all languages:
+  /// a character after a comment lead or a raw prefix is skipped with it if they do not start a comment or 
+  /// a raw literal, the last character of a block comment end (and the quote after the closing ) of a delimited 
+  /// raw literal without delimiter) is examined again as code.
+  /// @tparam rules the lexical rules of the language (see is_supported)
+  template <Lexer_rules const& rules>
+  class Decomment_lexer
+  {
+    static_assert(is_supported(rules), "comment markers should be two characters starting with the same one");
+    static_assert(count_starts(make_lexer_table(rules)) <= 4, "up to four characters may start transitions");
+
+  public:
+    /// @brief       Setup the source data (with 2-character NUL padding!).
+    /// @param begin the pointer to the first character of the source data
+    /// @param end   the pointer after the last character of the source data (end[1] must be defined)
+    /// @param level the instruction set of the searches (Simd_level::scalar examines each character by the table)
+    constexpr Decomment_lexer(Character const* begin, Character const* end, 
+                              Simd_level level = simd_level()) noexcept
+      : _cur(begin), _end(end), _level(level) {}
+
+    /// @brief       Setup the source data (with 2-character NUL padding!).
+    /// @param data  the pointer to the first character of the source data
+    /// @param size  the size of the source data (data[size + 1] must be defined)
+    /// @param level the instruction set of the searches
+    constexpr Decomment_lexer(Character const* data, size_t size, Simd_level level = simd_level()) noexcept
+      : Decomment_lexer(data, data + size, level) {}
+
+    /// @brief       Setup the source data (with 2-character NUL padding!).
+    /// @param input input text span
+    /// @param level the instruction set of the searches
+    explicit constexpr Decomment_lexer(String_view input, Simd_level level = simd_level()) noexcept
+      : Decomment_lexer(input.data(), input.size(), level) {}
+
+    /// @brief       Do the job.
+    /// @param out   the pointer to the output buffer (must be no less than the source input)
+    /// @return      pointer to the end of the written data
+    Character* to(Character* out) noexcept
+    {
+      _out = out;
+      _run();
+      return _out;
+    }
+
+  private:
+    using In_ptr  = Character const*;
+    using Out_ptr = Character*;
+
+    static constexpr Lexer_table     _table  = make_lexer_table(rules);
+    static constexpr Four_characters _starts = find_starts(_table);
+
+    In_ptr     _cur{ nullptr };
+    In_ptr     _end{ nullptr };
+    Out_ptr    _out{ nullptr };
+    Simd_level _level;
+    Character  _comment{}; // a character which is to be output in place of the skipped comment
+
+    [[nodiscard]] static constexpr Lexer_action _action(Lexer_action state, Character ch) noexcept
+    {
+      return _table[static_cast<size_t>(state)][static_cast<unsigned char>(ch)];
+    }
+
+    void _run() noexcept
+    {
+      while (_cur < _end)
+      {
+        auto const from = _cur, to = _skip_until_comment();
+        _out = std::copy(from, to, _out); // the ranges may overlap (in place decommenting)
+        if (to < _end)
+          *_out++ = _comment;
+      }
+    }
+
+    // Returns where comment starts, _cur is set just after the comment.
+    In_ptr _skip_until_comment() noexcept
+    {
+      while ((_cur = _skip_code()) < _end)
+      {
+        In_ptr const start = _cur;
+        auto action = _action(Lexer_action::code, *_cur++);
+        if (action == Lexer_action::comment_lead || action == Lexer_action::raw_prefix)
+          action = _action(action, *_cur++);
+
+        switch (action)
+        {
+        case Lexer_action::line_comment:
+          _comment = characters::LF;
+          _cur     = _skip_single_line_comment();
+          return start;
+
+        case Lexer_action::block_comment:
+          _comment = characters::space;
+          _cur     = _skip_multiline_comment();
+          return start;
+
+        case Lexer_action::literal:
+          if constexpr (rules.raw_literal == Raw_literal::multiquote)
+          {
+            if (*start == rules.raw_quote && _cur[0] == rules.raw_quote && _cur[1] == rules.raw_quote)
+            {
+              _cur = _skip_multiquote_literal();
+              break;
+            }
+          }
+
+          _cur = _skip_literal(*start);
+          break;
+
+        case Lexer_action::raw_literal:
+          _cur = _skip_delimited_literal();
+          break;
+
+        default:
+          break;
+        }
+      }
+
+      return _end;
+    }
+
+    // Returns the next character starting a transition or _end.
+    [[nodiscard]] In_ptr _skip_code() const noexcept
+    {
+      if (_cur >= _end) // a skipped character may be the padding
+        return _end;
+
+      if (_level == Simd_level::scalar)
+      {
+        auto cur = _cur;
+        while (cur < _end && _action(Lexer_action::code, *cur) == Lexer_action::code)
+          ++cur;
+        return cur;
+      }
+
+      auto const pos = find_any_of({ _cur, _end }, _starts, _level);
+      return pos == NPOS ? _end : _cur + pos;
+    }
+
+    [[nodiscard]] In_ptr _skip_literal(Character term) const noexcept
+    {
+      if (_level != Simd_level::scalar && rules.escape == characters::backslash)
+      {
+        auto const pos = find_unescaped({ _cur, _end }, term, _level);
+        return pos == NPOS ? _end : _cur + pos + 1;
+      }
+
+      auto const end = _end;
+      for (auto cur = _cur; cur < end;)
+      {
+        if (auto const in = *cur++; in == term)
+          return cur;
+        else
+          cur += in == rules.escape;
+      }
+
+      return end;
+    }
+
+    // _cur is after the opening quote.
+    [[nodiscard]] In_ptr _skip_delimited_literal() const noexcept
+    {
+      String_view       sv { _cur, _end };
+      String_view const term = sv.substr(0, sv.find(rules.raw_open));
+
+      // Simple case of R"(...)"
+      if (term.empty())
+      {
+        constexpr static Character   token_chars[] { rules.raw_close, rules.raw_quote };
+        constexpr static String_view token         { &token_chars[0], 2               };
+
+        if (auto const pos = String_view{ _cur, _end }.find(token); pos != NPOS)
+          return _cur + pos + 1;
+        return _end;
+      }
+
+      // Complex case of R"delim(...)delim"
+      for (sv.remove_prefix(min(sv.size(), term.size() + 1)); !sv.empty();)
+      {
+        auto const pos = sv.find(term);
+        if (pos == NPOS)
+          break;
+
+        bool const has_close = sv[pos - 1] == rules.raw_close;
+        sv.remove_prefix(pos + term.size());
+        if (has_close && sv.front() == rules.raw_quote)
+          return sv.data() + 1;
+      }
+
+      return _end;
+    }
+
+    // _cur is after the first quote of at least three, the literal ends with as many quotes as it starts with.
+    [[nodiscard]] In_ptr _skip_multiquote_literal() const noexcept
+    {
+      auto const body   = std::find_if(_cur, _end, [](Character ch) { return ch != rules.raw_quote; });
+      auto const quotes = static_cast<size_t>(body - _cur) + 1;
+
+      for (String_view sv{ body, _end }; ;)
+      {
+        auto const pos = sv.find(rules.raw_quote);
+        if (pos == NPOS)
+          return _end;
+
+        sv.remove_prefix(pos);
+        auto const run = min(sv.find_first_not_of(rules.raw_quote), sv.size());
+        if (run >= quotes)
+          return sv.data() + quotes;
+        sv.remove_prefix(run);
+      }
+    }
+
+    [[nodiscard]] In_ptr _skip_single_line_comment() const noexcept
+    {
+      for (String_view sv{ _cur, _end }; !sv.empty();)
+      {
+        auto const pos = sv.find(characters::LF);
+        if (pos == NPOS)
+          break;
+
+        bool const finish = sv[pos - 1] != rules.line_continuation;
+        sv.remove_prefix(pos + 1);
+        if (finish)
+          return sv.data();
+      }
+
+      return _end;
+    }
+
+    [[nodiscard]] In_ptr _skip_multiline_comment() const noexcept
+    {
+      if (auto const pos = String_view{ _cur, _end }.find(rules.block_comment_close); pos != NPOS)
+        return _cur + pos + rules.block_comment_close.size() - 1;
+      return _end;
+    }
+  };
+
+
+  /// @brief        A resumable version of Decomment_lexer for sources given by chunks, generated from the same rules.
+  /// The state (an open literal or comment, a held back comment lead, a raw literal delimiter) is carried 
+  /// from one chunk to the next one, inside a chunk code and literals are skipped by the same vectorized searches
+  /// and comments are searched for their ends as Decomment_lexer does. The results are the same 
+  /// as the results of Decomment_lexer for the whole source including its peculiarities, except that 
+  /// a delimited raw literal with a delimiter longer than max_raw_delimiter lasts until the end of the source.
+  /// @tparam rules the lexical rules of the language (see is_supported)
+  template <Lexer_rules const& rules>
+  class Decomment_lexer_stream final
+    : public Decomment_stream
+  {
+  public:
+    /// @brief Raw string literal delimiters are at most 16 characters long in C++, 
+    /// a literal with a longer one than this is considered lasting until the end of the source.
+    static constexpr size_t max_raw_delimiter = 64;
+
+    /// @brief       Start a source.
+    /// @param level the instruction set of the searches (Simd_level::scalar examines each character by the table)
+    explicit Decomment_lexer_stream(Simd_level level = simd_level()) noexcept
+      : _level(level) {}
+
+    /// @brief       Decomment the next chunk.
+    /// @param chunk the next part of the source text
+    /// @param out   the output buffer of at least chunk.size() + max_held_bytes bytes
+    /// @return      pointer to the end of the written data
+    Character* operator()(String_view chunk, Character* out) noexcept override
+    {
+      for (auto cur = chunk.data(), end = cur + chunk.size(); cur < end;)
+        cur = _step(cur, end, out);
+      return out;
+    }
+
+    /// @brief     Finish the source writing the held back comment lead if any.
+    /// @param out the output buffer of at least max_held_bytes bytes
+    /// @return    pointer to the end of the written data
+    Character* finish(Character* out) noexcept override
+    {
+      // Decomment_lexer reads the padding NUL after a final comment lead, so the lead is just output.
+      if (_state == State::comment_lead)
+        *out++ = rules.line_comment[0];
+
+      _state = State::code;
+      return out;
+    }
+
+  private:
+    using In_ptr = Character const*;
+
+    enum class State : unsigned char
+    {
+      code,
+      comment_lead,     // the comment lead is held back: the next character may start a comment
+      raw_prefix,       // the next character may start a delimited raw literal (it is skipped anyway)
+      line_comment,
+      block_comment,
+      literal,
+      literal_escape,   // the next character of the literal is escaped
+      quote,            // multiquote: a quote has been met, it may start a raw literal
+      two_quotes,       // multiquote: an empty literal or a raw literal start
+      multiquote_open,  // multiquote: the opening quotes are being counted
+      multiquote_body,
+      raw_delimiter,    // delimited: the delimiter is being read till raw_open
+      raw_simple,       // delimited: the literal without a delimiter
+      raw_body,         // delimited: the literal with a delimiter
+      raw_quote,        // delimited: raw_close and the delimiter have been met, raw_quote is checked
+      raw_unterminated, // delimited: the delimiter is too long
+    };
+
+    static constexpr Lexer_table     _table  = make_lexer_table(rules);
+    static constexpr Four_characters _starts = find_starts(_table);
+
+    Simd_level _level;
+    State      _state    = State::code;
+    Character  _term     = 0;                              // literal terminator
+    Character  _prev     = 0;                              // the previous character of a comment or a raw literal
+    size_t     _quotes   = 0;                              // multiquote: how many quotes start the literal
+    size_t     _run      = 0;                              // multiquote: how many quotes have been met in a row
+    String     _delimiter;                                 // delimited: raw literal delimiter
+    std::array<unsigned char, max_raw_delimiter> _fallback; // delimiter prefix function (KMP)
+    std::array<Character, max_raw_delimiter + 1> _history;  // the last raw literal characters
+    size_t     _matched  = 0;                              // how many delimiter characters are matched
+    size_t     _position = 0;                              // raw literal character index
+
+    [[nodiscard]] static constexpr Lexer_action _action(Lexer_action state, Character ch) noexcept
+    {
+      return _table[static_cast<size_t>(state)][static_cast<unsigned char>(ch)];
+    }
+
+    // Take at least one character (cur < end), return the next one to be taken.
+    In_ptr _step(In_ptr cur, In_ptr end, Character*& out) noexcept
+    {
+      switch (_state)
+      {
+      case State::code:
+        {
+          auto const next = _skip_tokens(cur, end);
+          out = std::copy(cur, next, out);
+          return next == end ? end : _start(next, out);
+        }
+
+      case State::comment_lead:
+        switch (_action(Lexer_action::comment_lead, *cur))
+        {
+        case Lexer_action::line_comment:
+          *out++ = characters::LF;
+          _prev  = *cur;
+          _state = State::line_comment;
+          break;
+
+        case Lexer_action::block_comment:
+          *out++ = characters::space;
+          _prev  = characters::NUL;
+          _state = State::block_comment;
+          break;
+
+        default:
+          *out++ = rules.line_comment[0];
+          *out++ = *cur;
+          _state = State::code;
+        }
+        return cur + 1;
+
+      case State::raw_prefix:
+        _state = State::code;
+        if (_action(Lexer_action::raw_prefix, *cur) == Lexer_action::raw_literal)
+        {
+          _delimiter.clear();
+          _state = State::raw_delimiter;
+        }
+
+        *out++ = *cur;
+        return cur + 1;
+
+      case State::line_comment:
+        return _skip_line_comment(cur, end);
+
+      case State::block_comment:
+        return _skip_block_comment(cur, end);
+
+      case State::literal:
+        return _skip_literal(cur, end, out);
+
+      case State::literal_escape:
+        *out++ = *cur;
+        _state = State::literal;
+        return cur + 1;
+
+      case State::quote:
+        if (*cur != rules.raw_quote)
+        {
+          _term  = rules.raw_quote;
+          _state = State::literal;
+          return cur;
+        }
+
+        *out++ = *cur;
+        _state = State::two_quotes;
+        return cur + 1;
+
+      case State::two_quotes:
+        if (*cur != rules.raw_quote) // an empty literal, the character is code
+        {
+          _state = State::code;
+          return cur;
+        }
+
+        *out++  = *cur;
+        _quotes = 3;
+        _state  = State::multiquote_open;
+        return cur + 1;
+
+      case State::multiquote_open:
+        if (*cur == rules.raw_quote)
+        {
+          ++_quotes;
+        }
+        else
+        {
+          _run   = 0;
+          _state = State::multiquote_body;
+        }
+
+        *out++ = *cur;
+        return cur + 1;
+
+      case State::multiquote_body:
+        _run   = *cur == rules.raw_quote ? _run + 1 : 0;
+        *out++ = *cur;
+        if (_run == _quotes) // the rest of the quotes are code
+          _state = State::code;
+        return cur + 1;
+
+      case State::raw_unterminated: // the rest of the source is the literal
+        out = std::copy(cur, end, out);
+        return end;
+
+      default:
+        return _step_delimited(cur, out);
+      }
+    }
+
+    // Take a character starting a transition from code.
+    In_ptr _start(In_ptr cur, Character*& out) noexcept
+    {
+      auto const ch = *cur;
+      switch (_action(Lexer_action::code, ch))
+      {
+      case Lexer_action::comment_lead:
+        _state = State::comment_lead;
+        return cur + 1;
+
+      case Lexer_action::raw_prefix:
+        _state = State::raw_prefix;
+        break;
+
+      default:
+        _term  = ch;
+        _state = rules.raw_literal == Raw_literal::multiquote && ch == rules.raw_quote ? State::quote : State::literal;
+        break;
+      }
+
+      *out++ = ch;
+      return cur + 1;
+    }
+
+    // Returns the next character starting a transition which is to be taken by the state machine or end: 
+    // a comment lead or a raw prefix with the character after it and a literal are skipped as Decomment_lexer 
+    // skips them if they do not start a comment or a raw literal and end in the chunk, so they are not copied 
+    // one by one.
+    [[nodiscard]] In_ptr _skip_tokens(In_ptr cur, In_ptr end) const noexcept
+    {
+      for (;;)
+      {
+        cur = _skip_code(cur, end);
+        if (end - cur < 2)
+          return cur;
+
+        auto const action = _action(Lexer_action::code, *cur);
+        if (action == Lexer_action::comment_lead || action == Lexer_action::raw_prefix)
+        {
+          if (_action(action, cur[1]) != Lexer_action::code)
+            return cur;
+
+          cur += 2;
+          continue;
+        }
+
+        if (_level == Simd_level::scalar || rules.escape != characters::backslash
+         || (rules.raw_literal == Raw_literal::multiquote && *cur == rules.raw_quote))
+          return cur;
+
+        auto const pos = find_unescaped({ cur + 1, end }, *cur, _level);
+        if (pos == NPOS)
+          return cur;
+
+        cur += pos + 2;
+      }
+    }
+
+    // Returns the next character starting a transition or end.
+    [[nodiscard]] In_ptr _skip_code(In_ptr cur, In_ptr end) const noexcept
+    {
+      if (_level == Simd_level::scalar)
+      {
+        while (cur < end && _action(Lexer_action::code, *cur) == Lexer_action::code)
+          ++cur;
+        return cur;
+      }
+
+      auto const pos = find_any_of({ cur, end }, _starts, _level);
+      return pos == NPOS ? end : cur + pos;
+    }
+
+    In_ptr _skip_literal(In_ptr cur, In_ptr end, Character*& out) noexcept
+    {
+      if (_level != Simd_level::scalar && rules.escape == characters::backslash)
+      {
+        if (auto const pos = find_unescaped({ cur, end }, _term, _level); pos != NPOS)
+        {
+          out    = std::copy(cur, cur + pos + 1, out);
+          _state = State::code;
+          return cur + pos + 1;
+        }
+
+        // The literal goes on, the next chunk starts escaped after an odd run of escapes.
+        auto run = end;
+        while (run != cur && run[-1] == rules.escape)
+          --run;
+        if ((end - run) % 2 != 0)
+          _state = State::literal_escape;
+
+        out = std::copy(cur, end, out);
+        return end;
+      }
+
+      while (cur < end)
+      {
+        auto const in = *cur++;
+        *out++ = in;
+        if (in == _term)
+        {
+          _state = State::code;
+          return cur;
+        }
+
+        if (in == rules.escape)
+        {
+          if (cur == end)
+          {
+            _state = State::literal_escape;
+            return end;
+          }
+
+          *out++ = *cur++;
+        }
+      }
+
+      return end;
+    }
+
+    // A line comment ends after LF which does not follow the line continuation character.
+    In_ptr _skip_line_comment(In_ptr cur, In_ptr end) noexcept
+    {
+      for (auto from = cur; from < end;)
+      {
+        auto const pos = String_view{ from, end }.find(characters::LF);
+        if (pos == NPOS)
+          break;
+
+        auto const lf = from + pos;
+        if ((lf == cur ? _prev : lf[-1]) != rules.line_continuation)
+        {
+          _state = State::code;
+          return lf + 1;
+        }
+
+        from = lf + 1;
+      }
+
+      _prev = end[-1];
+      return end;
+    }
+
+    // The last character of the block comment end is examined again as code.
+    In_ptr _skip_block_comment(In_ptr cur, In_ptr end) noexcept
+    {
+      auto const& close = rules.block_comment_close;
+      if (_prev == close[0] && *cur == close[1])
+      {
+        _state = State::code;
+        return cur;
+      }
+
+      if (auto const pos = String_view{ cur, end }.find(close); pos != NPOS)
+      {
+        _state = State::code;
+        return cur + pos + 1;
+      }
+
+      _prev = end[-1];
+      return end;
+    }
+
+    // Delimited raw literals are rare, they go character by character.
+    In_ptr _step_delimited(In_ptr cur, Character*& out) noexcept
+    {
+      auto const ch = *cur;
+      switch (_state)
+      {
+      case State::raw_delimiter:
+        if (ch == rules.raw_open)
+        {
+          _prev = ch;
+          if (_delimiter.empty())
+            _state = State::raw_simple;
+          else
+            _start_raw_body();
+        }
+        else if (_delimiter.size() == max_raw_delimiter)
+        {
+          _state = State::raw_unterminated;
+        }
+        else
+        {
+          _delimiter.push_back(ch);
+        }
+        break;
+
+      case State::raw_simple:
+        if (ch == rules.raw_quote && _prev == rules.raw_close) // the quote is examined again as code
+        {
+          _state = State::code;
+          return cur;
+        }
+
+        _prev = ch;
+        break;
+
+      case State::raw_quote:
+        if (ch == rules.raw_quote)
+        {
+          _state = State::code;
+          break;
+        }
+
+        _state = State::raw_body;
+        _match_raw(ch);
+        break;
+
+      case State::raw_body:
+        _match_raw(ch);
+        break;
+
+      default:
+        break;
+      }
+
+      *out++ = ch;
+      return cur + 1;
+    }
+
+    void _start_raw_body() noexcept
+    {
+      // Knuth-Morris-Pratt prefix function: leftmost matches are found as String_view::find finds them.
+      auto const size = _delimiter.size();
+      _fallback[0] = 0;
+      for (size_t i = 1, k = 0; i < size; ++i)
+      {
+        while (k != 0 && _delimiter[i] != _delimiter[k])
+          k = _fallback[k - 1];
+        if (_delimiter[i] == _delimiter[k])
+          ++k;
+        _fallback[i] = static_cast<unsigned char>(k);
+      }
+
+      _history[0] = rules.raw_open;
+      _position   = 1;
+      _matched    = 0;
+      _state      = State::raw_body;
+    }
+
+    void _match_raw(Character ch) noexcept
+    {
+      auto const size = _delimiter.size();
+      _history[_position++ % (size + 1)] = ch;
+
+      while (_matched != 0 && _delimiter[_matched] != ch)
+        _matched = _fallback[_matched - 1];
+      if (_delimiter[_matched] == ch)
+        ++_matched;
+
+      if (_matched == size)
+      {
+        // The next search starts after the match, the match closes the literal if it follows raw_close
+        // and precedes raw_quote.
+        _matched = 0;
+        if (_history[(_position - size - 1) % (size + 1)] == rules.raw_close)
+          _state = State::raw_quote;
+      }
+    }
+  };
+
+}
+
+#endif//SRCSTATS_DECOMMENT_LEXER_HPP_INCLUDED
@@ -0,0 +1,152 @@
+/******************************************************************************
+MIT License
+
+Copyright (c) 2024 Dmitry R. Kuvshinov
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+******************************************************************************/
+/// @file   decomment_stream.hpp
+/// @brief  Resumable decommenting interface for sources given by consecutive chunks.
+/// @author D.R.Kuvshinov kuvshinovdr at yandex.ru
+#ifndef SRCSTATS_DECOMMENT_STREAM_HPP_INCLUDED
+#define SRCSTATS_DECOMMENT_STREAM_HPP_INCLUDED
+
+#include "../basic.hpp"
+#include "../file_stat.hpp"
+#include "../file_batch.hpp"
+#include "../text_simd.hpp"
+#include "../utf8.hpp"
+
+#include <concepts>
+#include <memory>
+
+
+namespace srcstats
+{
+
+  /// @brief Removes comments from a source given by consecutive chunks of any size.
+  /// The state (open literals, comments, raw string delimiters) is carried from one chunk to the next one,
+  /// the result is the same as if the whole source was decommented at once.
+  class Decomment_stream
+  {
+  public:
+    /// @brief How many bytes may be written in addition to the chunk size (held back characters).
+    static constexpr size_t max_held_bytes = 1;
+
+    virtual ~Decomment_stream() {}
+
+    /// @brief       Decomment the next chunk (no padding is required).
+    /// @param chunk the next part of the source text
+    /// @param out   the output buffer of at least chunk.size() + max_held_bytes bytes (may not overlap chunk)
+    /// @return      pointer to the end of the written data
+    virtual Character* operator()(String_view chunk, Character* out) = 0;
+
+    /// @brief     Finish the source writing the held back characters if any.
+    /// @param out the output buffer of at least max_held_bytes bytes
+    /// @return    pointer to the end of the written data
+    virtual Character* finish(Character* out) = 0;
+  };
+
+
+  /// @brief The size of the blocks the chunks are analyzed by (a block and its copies stay in the cache).
+  inline constexpr size_t analysis_block_size = size_t(16) << 10;
+
+
+  /// @brief             Analyze the next chunk of a source without storing its decommented text (the fused mode).
+  /// The chunk is taken by blocks: each block is normalized (copied only if it has control characters, see 
+  /// copy_without_control), taken by the raw statistics, decommented to a per-thread buffer and taken by
+  /// the decommented statistics (which trim it to another per-thread buffer). So the text is not stepped through
+  /// once character by character: the blocks stay in the cache while they are copied between the vectorized 
+  /// kernels, and the decommented text of a file is never stored as a whole.
+  /// @tparam Stream     the decommenting stream class (its members are called directly if it is final)
+  /// @param stream      the decommenting stream of the source
+  /// @param chunk       the next part of the source text (not normalized)
+  /// @param raw         the statistics of the raw text
+  /// @param decommented the statistics of the decommented text (it should trim lines)
+  template <std::derived_from<Decomment_stream> Stream>
+  void analyze_chunk(Stream& stream, String_view chunk, 
+                     File_statistics_stream& raw, File_statistics_stream& decommented)
+  {
+    thread_local String normalized(analysis_block_size, characters::NUL), 
+                        output(analysis_block_size + Decomment_stream::max_held_bytes, characters::NUL);
+
+    for (size_t at = 0; at < chunk.size(); at += analysis_block_size)
+    {
+      auto block = chunk.substr(at, analysis_block_size);
+      if (find_control(block) != NPOS)
+        block = { normalized.data(), copy_without_control(block, normalized.data()) };
+
+      raw(block);
+      decommented({ output.data(), stream(block, output.data()) });
+    }
+  }
+
+
+  /// @brief             Finish the analysis of a source given by chunks (see analyze_chunk).
+  /// @param stream      the decommenting stream of the source
+  /// @param decommented the statistics of the decommented text
+  template <std::derived_from<Decomment_stream> Stream>
+  void finish_chunks(Stream& stream, File_statistics_stream& decommented)
+  {
+    Character held[Decomment_stream::max_held_bytes];
+    decommented({ held, stream.finish(held) });
+  }
+
+
+  /// @brief             Compute the raw and decommented statistics of a whole source (see analyze_chunk).
+  /// @param stream      a new decommenting stream of the source language
+  /// @param input       the source text (not normalized, no padding is required)
+  /// @param raw         the destination statistics of the raw source
+  /// @param decommented the destination statistics of the decommented and cleaned-up source
+  /// (the line lengths are put to their sketches if they are used, see File_statistics::use_line_quantiles)
+  template <std::derived_from<Decomment_stream> Stream>
+  void analyze(Stream& stream, String_view input, File_statistics& raw, File_statistics& decommented)
+  {
+    File_statistics_stream raw_stream(raw), decommented_stream(decommented, true);
+    analyze_chunk(stream, input, raw_stream, decommented_stream);
+    finish_chunks(stream, decommented_stream);
+    raw_stream.finish();
+    decommented_stream.finish();
+  }
+
+
+  /// @brief            Compute the raw and decommented statistics of all sources of a batch.
+  /// The result is the same as analyze gives for each source (after decode_text). 
+  /// @tparam Stream     the decommenting stream class of the language (its members are called directly)
+  /// @param batch       the sources of the same language and subtype
+  /// @param raw         the destination statistics of the raw sources
+  /// @param decommented the destination statistics of the decommented and cleaned-up sources
+  template <std::derived_from<Decomment_stream> Stream>
+  void analyze_batch(File_batch const& batch, File_statistics& raw, File_statistics& decommented)
+  {
+    String transcoded;
+    for (size_t i = 0; i < batch.size(); ++i)
+    {
+      Stream stream;
+      analyze(stream, decode_text(batch[i], transcoded), raw, decommented);
+    }
+  }
+
+
+  /// @brief An owning pointer to a decommenting stream.
+  using Decomment_stream_uptr = std::unique_ptr<Decomment_stream>;
+
+}
+
+#endif//SRCSTATS_DECOMMENT_STREAM_HPP_INCLUDED
@@ -23,7 +23,7 @@ SOFTWARE.
 ******************************************************************************/
 
 /// @file   lang_base.hpp
-/// @brief  A templated base class for easier implementation of Lang_interface.
+/// @brief  Templated base classes for easier implementation of Lang_interface and Lang_result.
 /// @author D.R.Kuvshinov kuvshinovdr at yandex.ru
 #ifndef SRCSTATS_LANG_BASE_HPP_INCLUDED
 #define SRCSTATS_LANG_BASE_HPP_INCLUDED
@@ -32,7 +32,6 @@ SOFTWARE.
 
 #include <array>
 #include <type_traits>
-#include <initializer_list>
 
 
 namespace srcstats
@@ -53,9 +52,11 @@ namespace srcstats
 
 
   /// @brief               Language statistics across all its source file subtypes.
+  /// Each worker thread accumulates to its own result objects merged at the end, the statistics 
+  /// are aligned to cache lines, so the objects of different workers never share them.
   /// @tparam SubtypeCount how many file subtypes are to be supported
   template <int SubtypeCount>
-  class Lang_statistics
+  class alignas(cache_line_size) Lang_statistics
   {
   public:
     /// @brief Check if our statistics does not have any data.
@@ -74,6 +75,12 @@ namespace srcstats
       return _stats.at(subtype);
     }
 
+    /// @brief Access file statistics to accumulate to them directly (see analyze_batch).
+    [[nodiscard]] constexpr File_statistics& stats(int subtype = 0)
+    {
+      return _stats.at(subtype);
+    }
+
     /// @brief Compute the statistics total across all source file subtypes.
     [[nodiscard]] constexpr File_statistics compute_total() const noexcept
     {
@@ -118,10 +125,18 @@ namespace srcstats
       os << std::endl;
     }
 
-    /// @brief Process the preconditioned file data according to its type.
-    Lang_statistics& operator()(String_view file_data, int subtype)
+    /// @brief Update with the statistics of the given file subtype.
+    Lang_statistics& operator()(File_statistics const& stats, int subtype)
     {
-      _stats.at(subtype)(file_data);
+      _stats.at(subtype)(stats);
+      return *this;
+    }
+
+    /// @brief Update with data from another language statistics object.
+    constexpr Lang_statistics& operator()(Lang_statistics const& other) noexcept
+    {
+      for (int i = 0; i < SubtypeCount; ++i)
+        _stats[i](other._stats[i]);
       return *this;
     }
 
@@ -136,12 +151,8 @@ namespace srcstats
     : public Lang_interface
   {
   protected:
-    Lang_base_titles(std::initializer_list<std::string_view> titles_list)
-    {
-      auto const p = titles_list.begin();
-      for (int i = 0; i < SubtypeCount; ++i)
-        _titles[i] = p[i];
-    }
+    Lang_base_titles(Subtype_titles<SubtypeCount> const& titles)
+      : _titles(titles) {}
 
     [[nodiscard]] constexpr Subtype_titles<SubtypeCount> const& titles() const noexcept
     {
@@ -169,23 +180,32 @@ namespace srcstats
   };
 
 
-  /// @brief               Common things for Lang_interface implementations.
+  /// @brief               Language statistics accumulated by a worker: raw (with comments) and decommented.
   /// @tparam SubtypeCount how many file subtypes are to be supported
   template <int SubtypeCount>
-  class Lang_base
-    : public Lang_base_titles<SubtypeCount>
+  class Lang_base_result final
+    : public Lang_result
   {
   public:
-    /// @brief Accumulate statistics for the next raw source file (with comments).
-    void accumulate_raw(String const& file_contents, int subtype = 0) override
+    /// @brief               Initialize empty statistics.
+    /// @param language_name the language name printed in the header
+    /// @param titles        titles for file statistics per file subtype
+    Lang_base_result(std::string_view language_name, Subtype_titles<SubtypeCount> const& titles) noexcept
+      : _language_name(language_name), _titles(titles) {}
+
+    /// @brief Accumulate statistics of the next source file: raw (with comments) and decommented.
+    void accumulate(File_statistics const& raw, File_statistics const& decommented, int subtype = 0) override
     {
-      _raw(file_contents, subtype);
+      _raw(raw, subtype);
+      _decommented(decommented, subtype);
     }
 
-    /// @brief Accumulate statistics for decommented and cleaned-up source file.
-    void accumulate_decommented(String const& file_contents, int subtype = 0) override
+    /// @brief Add statistics accumulated by another result of the same language.
+    void merge(Lang_result const& other) override
     {
-      _decommented(file_contents, subtype);
+      auto& that = dynamic_cast<Lang_base_result const&>(other);
+      _raw(that._raw);
+      _decommented(that._decommented);
     }
 
     /// @brief Print full statistics for this language.
@@ -196,20 +216,19 @@ namespace srcstats
 
       static constexpr auto suffix = " statistics #\n"sv;
 
-      auto const lang_name = this->language_name();
-      auto const width     = lang_name.size() + suffix.size() + 1;
+      auto const width = _language_name.size() + suffix.size() + 1;
       
       underline(os, '=', width);
-      os << "# " << lang_name << suffix;
+      os << "# " << _language_name << suffix;
       underline(os, '=', width);
 
       os << "\nRaw files\n"
               "=========\n\n";
-      _raw.print(os, titles());
+      _raw.print(os, _titles);
 
       os << "Decommented files\n"
             "=================\n\n";
-      _decommented.print(os, titles());
+      _decommented.print(os, _titles);
 
       os << std::endl;
     }
@@ -226,12 +245,65 @@ namespace srcstats
       return _decommented.compute_total();
     }
 
+    /// @brief Access the raw file statistics of the subtype to accumulate to them directly.
+    [[nodiscard]] File_statistics& raw(int subtype = 0)
+    {
+      return _raw.stats(subtype);
+    }
+
+    /// @brief Access the decommented file statistics of the subtype to accumulate to them directly.
+    [[nodiscard]] File_statistics& decommented(int subtype = 0)
+    {
+      return _decommented.stats(subtype);
+    }
+
+  private:
+    Lang_statistics<SubtypeCount> _raw, _decommented;
+    std::string_view              _language_name;
+    Subtype_titles<SubtypeCount>  _titles;
+  };
+
+
+  /// @brief               Common things for Lang_interface implementations.
+  /// @tparam SubtypeCount how many file subtypes are to be supported
+  template <int SubtypeCount>
+  class Lang_base
+    : public Lang_base_titles<SubtypeCount>
+  {
+  public:
+    /// @brief The class of the statistics objects made by new_result.
+    using Result = Lang_base_result<SubtypeCount>;
+
+    /// @brief Make a new empty statistics object for this language.
+    [[nodiscard]] Lang_result_uptr new_result() const override
+    {
+      return std::make_unique<Result>(this->language_name(), titles());
+    }
+
+    /// @brief             Accumulate statistics of the next source file without virtual calls.
+    /// @param result      the destination statistics made by new_result
+    /// @param raw         statistics of the raw source file (with comments)
+    /// @param decommented statistics of the decommented and cleaned-up source file
+    /// @param subtype     file subtype
+    static void accumulate(Lang_result& result, File_statistics const& raw, File_statistics const& decommented, 
+                           int subtype = 0)
+    {
+      static_cast<Result&>(result).accumulate(raw, decommented, subtype);
+    }
+
   protected:
     using Lang_base_titles<SubtypeCount>::Lang_base_titles;
     using Lang_base_titles<SubtypeCount>::titles;
 
-  private:
-    Lang_statistics<SubtypeCount> _raw, _decommented;
+    /// @brief         Analyze a batch by the decommenting stream of the language (see srcstats::analyze_batch).
+    /// @tparam Stream the decommenting stream class
+    template <std::derived_from<Decomment_stream> Stream>
+    static void analyze_batch_by(File_batch const& batch, Lang_result& result)
+    {
+      auto&      that    = dynamic_cast<Result&>(result);
+      auto const subtype = batch.subtype();
+      srcstats::analyze_batch<Stream>(batch, that.raw(subtype), that.decommented(subtype));
+    }
   };
 
 }
@@ -23,15 +23,17 @@ SOFTWARE.
 ******************************************************************************/
 
 /// @file   lang_interface.hpp
-/// @brief  Abstract base class describing a programming language.
+/// @brief  Abstract base classes describing a programming language and its accumulated statistics.
 /// @author D.R.Kuvshinov kuvshinovdr at yandex.ru
 #ifndef SRCSTATS_LANG_INTERFACE_HPP_INCLUDED
 #define SRCSTATS_LANG_INTERFACE_HPP_INCLUDED
 
 #include "../file_stat.hpp"
+#include "decomment_stream.hpp"
 
 #include <ostream>
 #include <memory>
+#include <span>
 
 
 namespace srcstats
@@ -39,25 +41,27 @@ namespace srcstats
 
   class File_type_dispatcher;
 
-  /// @brief Language statistics abstract interface.
-  struct Lang_interface
+  /// @brief What identifies a language in the file contents (see detect_language).
+  struct Content_signature
   {
-    virtual ~Lang_interface() {}
-
-    /// @brief Get the programming language name.
-    [[nodiscard]] virtual std::string_view language_name() const noexcept = 0;
-
-    /// @brief Register all file types corresponding to this language. 
-    virtual void register_file_types(File_type_dispatcher&) = 0;
+    std::span<std::string_view const> names;       // lower case names given in modelines and shebangs
+    std::span<std::string_view const> keywords;    // tokens frequent in the sources of the language
+    int                               subtype = 0; // the file subtype of the detected files
+  };
 
-    /// @brief Accumulate statistics for the next raw source file (with comments).
-    virtual void accumulate_raw(String const& file_contents, int subtype = 0) = 0;
+  /// @brief Statistics of a language accumulated by one worker thread (see Lang_interface::new_result).
+  struct Lang_result
+  {
+    virtual ~Lang_result() {}
 
-    /// @brief Remove comments in place.
-    virtual void decomment_in_place(String& file_contents, int subtype = 0) = 0;
+    /// @brief             Accumulate statistics of the next source file.
+    /// @param raw         statistics of the raw source file (with comments)
+    /// @param decommented statistics of the decommented and cleaned-up source file
+    /// @param subtype     file subtype
+    virtual void accumulate(File_statistics const& raw, File_statistics const& decommented, int subtype = 0) = 0;
 
-    /// @brief Accumulate statistics for decommented and cleaned-up source file.
-    virtual void accumulate_decommented(String const& file_contents, int subtype = 0) = 0;
+    /// @brief Add statistics accumulated by another result of the same language.
+    virtual void merge(Lang_result const& other) = 0;
 
     /// @brief Print full statistics for this language.
     virtual void print(std::ostream&) const = 0;
@@ -70,7 +74,57 @@ namespace srcstats
   };
 
 
-  /// @brief An owning pointer to a statistics object.
+  /// @brief An owning pointer to a language statistics object.
+  using Lang_result_uptr = std::unique_ptr<Lang_result>;
+
+
+  /// @brief Language analyzer abstract interface.
+  /// The analyzer does not change after construction, so one object is shared by all the worker threads,
+  /// the statistics are accumulated in the separate result objects of the workers.
+  struct Lang_interface
+  {
+    virtual ~Lang_interface() {}
+
+    /// @brief Get the programming language name.
+    [[nodiscard]] virtual std::string_view language_name() const noexcept = 0;
+
+    /// @brief Make a new empty statistics object for this language (e.g. for another worker thread).
+    [[nodiscard]] virtual Lang_result_uptr new_result() const = 0;
+
+    /// @brief Register all file types corresponding to this language. 
+    virtual void register_file_types(File_type_dispatcher&) const = 0;
+
+    /// @brief Get what identifies the language in the contents of files without extensions.
+    [[nodiscard]] virtual Content_signature content_signature() const noexcept = 0;
+
+    /// @brief         Remove comments.
+    /// @param input   the source text followed by at least two readable NUL characters
+    /// @param out     the output buffer, it may be equal to input.data() (in place decommenting)
+    /// @param subtype file subtype
+    /// @return        pointer to the end of the written data
+    virtual Character* decomment(String_view input, Character* out, int subtype = 0) const = 0;
+
+    /// @brief         Make a new resumable decommenter for a source given by chunks (e.g. a very large file).
+    /// @param subtype file subtype
+    [[nodiscard]] virtual Decomment_stream_uptr decomment_stream(int subtype = 0) const = 0;
+
+    /// @brief             Compute raw and decommented statistics of a source by cache-sized blocks (see analyze_chunk),
+    /// the decommented text is not stored.
+    /// @param input       the source text (not normalized, no padding is required)
+    /// @param raw         the destination statistics of the raw source
+    /// @param decommented the destination statistics of the decommented and cleaned-up source
+    /// @param subtype     file subtype
+    virtual void analyze(String_view input, File_statistics& raw, File_statistics& decommented, int subtype = 0) const = 0;
+
+    /// @brief        Compute the statistics of all sources of a batch and accumulate them by one call.
+    /// The result is the same as analyzing the sources one by one and accumulating them.
+    /// @param batch  the sources of this language and the same subtype (read as analyze reads them)
+    /// @param result the destination statistics made by new_result of this analyzer
+    virtual void analyze_batch(File_batch const& batch, Lang_result& result) const = 0;
+  };
+
+
+  /// @brief An owning pointer to a language analyzer.
   using Lang_interface_uptr = std::unique_ptr<Lang_interface>;
 
 }
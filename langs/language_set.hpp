@@ -0,0 +1,75 @@
+/******************************************************************************
+MIT License
+
+Copyright (c) 2024 Dmitry R. Kuvshinov
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+******************************************************************************/
+
+/// @file   language_set.hpp
+/// @brief  Languages given as a compile-time list of analyzer classes.
+/// @author D.R.Kuvshinov kuvshinovdr at yandex.ru
+#ifndef SRCSTATS_LANGUAGE_SET_HPP_INCLUDED
+#define SRCSTATS_LANGUAGE_SET_HPP_INCLUDED
+
+#include "lang_interface.hpp"
+
+#include <concepts>
+#include <span>
+
+
+namespace srcstats
+{
+
+  /// @brief        A compile-time list of language analyzer classes with one static analyzer object per class.
+  /// Visiting an analyzer gives it as its own (final) class, so its members are called directly
+  /// and may be inlined instead of being called through Lang_interface.
+  /// @tparam Langs the analyzer classes (default constructible)
+  template <std::derived_from<Lang_interface>... Langs>
+  class Language_set
+  {
+  public:
+    /// @brief How many languages are in the set.
+    static constexpr size_t size = sizeof...(Langs);
+
+    /// @brief Get the analyzers of the languages in the order of the list (e.g. to register their file types).
+    [[nodiscard]] static std::span<Lang_interface const* const, size> analyzers() noexcept
+    {
+      static Lang_interface const* const list[] { &_analyzer<Langs>... };
+      return list;
+    }
+
+    /// @brief      Call f with the analyzer as its own class if it is one of analyzers()
+    /// (which is found by comparing the pointers, as a switch on the index of the language would do).
+    /// @param lang the analyzer
+    /// @param f    the function called as f(Lang const&)
+    /// @return     false if lang is not in the set (f is not called then)
+    static bool visit(Lang_interface const* lang, auto&& f)
+    {
+      return ((lang == &_analyzer<Langs> && (f(_analyzer<Langs>), true)) || ...);
+    }
+
+  private:
+    template <class Lang>
+    static inline Lang const _analyzer {};
+  };
+
+}
+
+#endif//SRCSTATS_LANGUAGE_SET_HPP_INCLUDED
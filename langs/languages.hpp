@@ -0,0 +1,46 @@
+/******************************************************************************
+MIT License
+
+Copyright (c) 2024 Dmitry R. Kuvshinov
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+******************************************************************************/
+
+/// @file   languages.hpp
+/// @brief  The list of the supported languages.
+/// @author D.R.Kuvshinov kuvshinovdr at yandex.ru
+#ifndef SRCSTATS_LANGUAGES_HPP_INCLUDED
+#define SRCSTATS_LANGUAGES_HPP_INCLUDED
+
+#include "language_set.hpp"
+#include "cpp/cpp_stat.hpp"
+#include "cs/cs_stat.hpp"
+
+
+namespace srcstats
+{
+
+  /// @brief The supported languages: add each new analyzer class here.
+  /// If SRCSTATS_STATIC_LANGUAGES is defined, the files of these languages are analyzed
+  /// by visiting their analyzers (see Language_set::visit) instead of calling Lang_interface.
+  using Languages = Language_set<Cpp_analyzer, Cs_analyzer>;
+
+}
+
+#endif//SRCSTATS_LANGUAGES_HPP_INCLUDED
@@ -0,0 +1,330 @@
+/******************************************************************************
+MIT License
+
+Copyright (c) 2024 Dmitry R. Kuvshinov
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+******************************************************************************/
+
+/// @file   native_walk.cpp
+/// @brief  Low-level Linux directory walking, native_walk.hpp implementation.
+/// @author D.R.Kuvshinov kuvshinovdr at yandex.ru
+
+#include "native_walk.hpp"
+
+#if defined(__linux__)
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#endif
+
+
+namespace srcstats
+{
+
+#if defined(__linux__)
+
+  namespace
+  {
+
+    /// @brief The record layout returned by getdents64.
+    struct Linux_dirent64
+    {
+      ino64_t        d_ino;
+      off64_t        d_off;
+      unsigned short d_reclen;
+      unsigned char  d_type;
+      char           d_name[1];
+    };
+
+
+    /// @brief How many bytes of directory entries are read by one getdents64 call.
+    constexpr size_t dirent_buffer_size = size_t(64) << 10;
+
+
+    /// @brief Close a file descriptor when leaving the scope.
+    class Fd_guard
+    {
+    public:
+      explicit Fd_guard(int fd) noexcept
+        : _fd(fd) {}
+
+      ~Fd_guard()
+      {
+        if (_fd >= 0)
+          ::close(_fd);
+      }
+
+      Fd_guard(Fd_guard const&)            = delete;
+      Fd_guard& operator=(Fd_guard const&) = delete;
+
+      [[nodiscard]] int get() const noexcept
+      {
+        return _fd;
+      }
+
+    private:
+      int _fd;
+    };
+
+
+    /// @brief Read up to size bytes (fewer only at the end of the file or on an error).
+    size_t read_all(int fd, Character* out, size_t size) noexcept
+    {
+      size_t bytes_read = 0;
+      while (bytes_read < size)
+      {
+        auto const bytes = ::read(fd, out + bytes_read, size - bytes_read);
+        if (bytes < 0 && errno == EINTR)
+          continue;
+        if (bytes <= 0)
+          break;
+        bytes_read += static_cast<size_t>(bytes);
+      }
+
+      return bytes_read;
+    }
+
+  }
+
+
+  bool native_walk_supported() noexcept
+  {
+    return true;
+  }
+
+
+  Directory_handle::Directory_handle(std::filesystem::path path)
+    : _path(std::move(path))
+  {
+    _fd = ::open(_path.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (_fd < 0)
+      throw File_error("failed to open directory", _path, errno);
+  }
+
+
+  Directory_handle::Directory_handle(std::shared_ptr<Directory_handle const> parent, String_view name)
+    : _path(parent->path() / name)
+  {
+    _fd = ::openat(parent->fd(), _path.filename().c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (_fd < 0)
+      throw File_error("failed to open directory", _path, errno);
+  }
+
+
+  Directory_handle::~Directory_handle()
+  {
+    if (_fd >= 0)
+      ::close(_fd);
+  }
+
+
+  void list_directory(Directory_handle const& dir, Directory_visitor const& visitor)
+  {
+    thread_local auto const buffer = std::make_unique<char[]>(dirent_buffer_size);
+
+    for (;;)
+    {
+      auto const bytes = ::syscall(SYS_getdents64, dir.fd(), buffer.get(), dirent_buffer_size);
+      if (bytes < 0)
+        throw File_error("failed to read directory", dir.path(), errno);
+      if (bytes == 0)
+        return;
+
+      for (long pos = 0; pos < bytes;)
+      {
+        auto const& entry = *reinterpret_cast<Linux_dirent64 const*>(buffer.get() + pos);
+        pos += entry.d_reclen;
+
+        String_view const name = entry.d_name;
+        if (name == "."sv || name == ".."sv)
+          continue;
+
+        switch (entry.d_type)
+        {
+        case DT_REG:
+          visitor.on_file(name, unknown_file_size);
+          break;
+
+        case DT_DIR:
+          visitor.on_directory(name);
+          break;
+
+        case DT_LNK:
+        case DT_UNKNOWN:
+          if (struct statx st; 
+              ::statx(dir.fd(), entry.d_name, AT_STATX_SYNC_AS_STAT, STATX_TYPE | STATX_SIZE, &st) == 0)
+          {
+            if (S_ISREG(st.stx_mode))
+              visitor.on_file(name, st.stx_size);
+            else if (S_ISDIR(st.stx_mode))
+              visitor.on_directory(name);
+          }
+          break;
+        }
+      }
+    }
+  }
+
+
+  Buffer_pool::Buffer read_file_at(
+      Directory_handle const& dir,
+      String const&           name,
+      Buffer_pool&            pool,
+      uintmax_t               size,
+      size_t                  padding_bytes,
+      size_t                  max_file_size
+    )
+  {
+    Fd_guard const file(::openat(dir.fd(), name.c_str(), O_RDONLY | O_CLOEXEC));
+    if (file.get() < 0)
+      throw File_error("failed to open", dir.path() / name, errno);
+
+    if (size == unknown_file_size)
+    {
+      struct stat st;
+      if (::fstat(file.get(), &st) != 0)
+        throw File_error("failed to get file size", dir.path() / name, errno);
+      size = static_cast<uintmax_t>(st.st_size);
+    }
+
+    if (size > static_cast<uintmax_t>(max_file_size))
+      throw File_too_big(dir.path() / name, size);
+
+    auto result = pool.borrow(static_cast<size_t>(size) + padding_bytes);
+    auto const bytes_read = read_padded(*result, static_cast<size_t>(size), padding_bytes, 
+        [&file](Character* out, size_t size) { return read_all(file.get(), out, size); });
+
+    if (bytes_read != size)
+      throw File_error("failed to read", dir.path() / name, bytes_read);
+
+    return result;
+  }
+
+
+  bool read_file_to_batch_at(Directory_handle const& dir, String const& name, File_batch& batch, uintmax_t size)
+  {
+    if (size != unknown_file_size && size > File_batch::max_file_size)
+      return false;
+
+    Fd_guard const file(::openat(dir.fd(), name.c_str(), O_RDONLY | O_CLOEXEC));
+    if (file.get() < 0)
+      throw File_error("failed to open", dir.path() / name, errno);
+
+    if (size == unknown_file_size)
+    {
+      struct stat st;
+      if (::fstat(file.get(), &st) != 0)
+        throw File_error("failed to get file size", dir.path() / name, errno);
+      size = static_cast<uintmax_t>(st.st_size);
+
+      if (size > File_batch::max_file_size)
+        return false;
+    }
+
+    auto const bytes_read = batch.add(static_cast<size_t>(size), 
+        [&file](Character* out, size_t size) { return read_all(file.get(), out, size); });
+
+    if (bytes_read != size)
+      throw File_error("failed to read", dir.path() / name, bytes_read);
+
+    return true;
+  }
+
+
+  Sniffed_file sniff_file_at(Directory_handle const& dir, String const& name)
+  {
+    Fd_guard const file(::openat(dir.fd(), name.c_str(), O_RDONLY | O_CLOEXEC));
+    if (file.get() < 0)
+      throw File_error("failed to open", dir.path() / name, errno);
+
+    return sniff_file(file.get(), dir.path() / name);
+  }
+
+
+  Mapped_file map_file_at(
+      Directory_handle const& dir,
+      String const&           name,
+      size_t                  padding_bytes,
+      size_t                  max_file_size
+    )
+  {
+    Fd_guard const file(::openat(dir.fd(), name.c_str(), O_RDONLY | O_CLOEXEC));
+    if (file.get() < 0)
+      throw File_error("failed to open", dir.path() / name, errno);
+
+    return Mapped_file(file.get(), dir.path() / name, padding_bytes, max_file_size);
+  }
+
+#else
+
+  bool native_walk_supported() noexcept
+  {
+    return false;
+  }
+
+
+  Directory_handle::Directory_handle(std::filesystem::path path)
+    : _path(std::move(path))
+  {
+    throw File_error("the native walker is not supported on this platform", _path);
+  }
+
+
+  Directory_handle::Directory_handle(std::shared_ptr<Directory_handle const> parent, String_view name)
+    : _path(parent->path() / name)
+  {
+    throw File_error("the native walker is not supported on this platform", _path);
+  }
+
+
+  Directory_handle::~Directory_handle() {}
+
+
+  void list_directory(Directory_handle const&, Directory_visitor const&) {}
+
+
+  Buffer_pool::Buffer read_file_at(Directory_handle const& dir, String const& name, Buffer_pool&, uintmax_t, size_t, size_t)
+  {
+    throw File_error("the native walker is not supported on this platform", dir.path() / name);
+  }
+
+
+  bool read_file_to_batch_at(Directory_handle const& dir, String const& name, File_batch&, uintmax_t)
+  {
+    throw File_error("the native walker is not supported on this platform", dir.path() / name);
+  }
+
+
+  Sniffed_file sniff_file_at(Directory_handle const& dir, String const& name)
+  {
+    throw File_error("the native walker is not supported on this platform", dir.path() / name);
+  }
+
+
+  Mapped_file map_file_at(Directory_handle const& dir, String const& name, size_t, size_t)
+  {
+    throw File_error("the native walker is not supported on this platform", dir.path() / name);
+  }
+
+#endif
+
+}
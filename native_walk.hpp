@@ -0,0 +1,158 @@
+/******************************************************************************
+MIT License
+
+Copyright (c) 2024 Dmitry R. Kuvshinov
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+******************************************************************************/
+
+/// @file   native_walk.hpp
+/// @brief  Low-level Linux directory walking and file reading relative to open directory descriptors.
+/// @author D.R.Kuvshinov kuvshinovdr at yandex.ru
+#ifndef SRCSTATS_NATIVE_WALK_HPP_INCLUDED
+#define SRCSTATS_NATIVE_WALK_HPP_INCLUDED
+
+#include "file.hpp"
+#include "sniff.hpp"
+#include "basic.hpp"
+
+#include <filesystem>
+#include <functional>
+#include <memory>
+
+
+namespace srcstats
+{
+
+  /// @brief Check if the native walker is supported on this platform (currently Linux only).
+  [[nodiscard]] bool native_walk_supported() noexcept;
+
+
+  /// @brief An open directory, the entries are opened relative to it, so the kernel does not resolve full paths.
+  /// Directory handles are shared by the tasks referring to their entries, the descriptor is closed by the last one.
+  class Directory_handle
+  {
+  public:
+    /// @brief      Open a root directory by its path, throw File_error on failure.
+    /// @param path the directory path
+    explicit Directory_handle(std::filesystem::path path);
+
+    /// @brief        Open a subdirectory, throw File_error on failure.
+    /// @param parent the parent directory
+    /// @param name   the subdirectory name
+    Directory_handle(std::shared_ptr<Directory_handle const> parent, String_view name);
+
+    ~Directory_handle();
+
+    Directory_handle(Directory_handle const&)            = delete;
+    Directory_handle& operator=(Directory_handle const&) = delete;
+
+    /// @brief Get the directory descriptor.
+    [[nodiscard]] int fd() const noexcept
+    {
+      return _fd;
+    }
+
+    /// @brief Get the directory path (for exclusion checks and error messages).
+    [[nodiscard]] std::filesystem::path const& path() const noexcept
+    {
+      return _path;
+    }
+
+  private:
+    std::filesystem::path _path;
+    int                   _fd = -1;
+  };
+
+  using Directory_handle_sptr = std::shared_ptr<Directory_handle const>;
+
+
+  /// @brief Unknown file size marker (the size is obtained when the file is opened).
+  constexpr uintmax_t unknown_file_size = ~uintmax_t(0);
+
+  /// @brief Directory entry callbacks: on_file(name, size or unknown_file_size), on_directory(name).
+  /// The name is valid only during the call.
+  struct Directory_visitor
+  {
+    std::function<void(String_view, uintmax_t)> on_file;
+    std::function<void(String_view)>            on_directory;
+  };
+
+  /// @brief         Read all directory entries in large batches, throw File_error on failure.
+  /// Entry types reported by the file system are trusted, only symbolic links and unknown types are examined
+  /// (following the links as std::filesystem::directory_entry::is_regular_file and is_directory do).
+  /// @param dir     the directory
+  /// @param visitor the callbacks called for each regular file and directory (other entries are skipped)
+  void list_directory(Directory_handle const& dir, Directory_visitor const& visitor);
+
+
+  /// @brief               Read a file to a borrowed buffer opening it relative to its directory, throw File_error on failure.
+  /// Only the padding bytes are zero-filled.
+  /// @param dir           the directory containing the file
+  /// @param name          the file name (should be NUL-terminated, e.g. come from a String)
+  /// @param pool          the pool to borrow the buffer from
+  /// @param size          the file size if it is already known, unknown_file_size otherwise
+  /// @param padding_bytes how many additional zero bytes should be appended to the end of the file contents
+  /// @param max_file_size maximal file size possible, throw File_too_big if the file is larger
+  /// @return              the borrowed buffer storing file byte content
+  Buffer_pool::Buffer read_file_at(
+      Directory_handle const& dir,
+      String const&           name,
+      Buffer_pool&            pool,
+      uintmax_t               size          = unknown_file_size,
+      size_t                  padding_bytes = 0,
+      size_t                  max_file_size = ~size_t(0) / 2
+    );
+
+  /// @brief       Read a small file appending it to the batch opening it relative to its directory, 
+  /// throw File_error on failure.
+  /// @param dir   the directory containing the file
+  /// @param name  the file name (should be NUL-terminated, e.g. come from a String)
+  /// @param batch the destination batch
+  /// @param size  the file size if it is already known, unknown_file_size otherwise
+  /// @return      false if the file is larger than File_batch::max_file_size (it is not read then)
+  bool read_file_to_batch_at(
+      Directory_handle const& dir,
+      String const&           name,
+      File_batch&             batch,
+      uintmax_t               size = unknown_file_size
+    );
+
+  /// @brief      Read the head of a file opening it relative to its directory and classify it (see sniff_file).
+  /// @param dir  the directory containing the file
+  /// @param name the file name (should be NUL-terminated, e.g. come from a String)
+  /// @return     the file kind and size
+  [[nodiscard]] Sniffed_file sniff_file_at(Directory_handle const& dir, String const& name);
+
+  /// @brief               Map a file to memory opening it relative to its directory, throw File_error on failure.
+  /// @param dir           the directory containing the file
+  /// @param name          the file name (should be NUL-terminated, e.g. come from a String)
+  /// @param padding_bytes how many zero bytes should be readable after the file contents
+  /// @param max_file_size maximal file size possible, throw File_too_big if the file is larger
+  /// @return              mapped file object
+  Mapped_file map_file_at(
+      Directory_handle const& dir,
+      String const&           name,
+      size_t                  padding_bytes = 0,
+      size_t                  max_file_size = ~size_t(0) / 2
+    );
+
+}
+
+#endif//SRCSTATS_NATIVE_WALK_HPP_INCLUDED
@@ -0,0 +1,225 @@
+/******************************************************************************
+MIT License
+
+Copyright (c) 2024 Dmitry R. Kuvshinov
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+******************************************************************************/
+
+/// @file   pipeline.cpp
+/// @brief  Staged source file processing, pipeline.hpp implementation.
+/// @author D.R.Kuvshinov kuvshinovdr at yandex.ru
+
+#include "pipeline.hpp"
+#include "report.hpp"
+
+#include <string_view>
+
+
+namespace srcstats
+{
+
+  namespace
+  {
+
+    [[nodiscard]] std::unique_ptr<Io_uring_reader> make_io_uring_reader(unsigned depth)
+    {
+      if (depth == 0 || !io_uring_supported())
+        return nullptr;
+
+      return std::make_unique<Io_uring_reader>(depth,
+          File_type_dispatcher::padding_bytes, File_type_dispatcher::maximal_file_size);
+    }
+
+  }
+
+
+  File_pipeline::File_pipeline(File_type_dispatcher& target, size_t readers, size_t analyzers, size_t capacity, 
+                               unsigned io_uring_depth, Analysis_mode mode, bool quantiles)
+    : _target(target),
+      _io_uring(make_io_uring_reader(io_uring_depth)),
+      _readers(_io_uring ? 1 : max(readers, 1)),
+      _analysis_mode(mode),
+      _quantiles(quantiles),
+      _to_read(capacity), 
+      _to_analyze(capacity, _readers),
+      _to_merge(capacity, max(analyzers, 1))
+  {
+    analyzers = max(analyzers, 1);
+    _threads.reserve(_readers + analyzers + 1);
+
+    if (_io_uring)
+      _threads.emplace_back([this] { _read_io_uring(); });
+    else
+      for (size_t i = 0; i < _readers; ++i)
+        _threads.emplace_back([this] { _read(); });
+
+    for (size_t i = 0; i < analyzers; ++i)
+      _threads.emplace_back([this] { _analyze(); });
+
+    _threads.emplace_back([this] { _merge(); });
+  }
+
+
+  File_pipeline::~File_pipeline()
+  {
+    finish();
+  }
+
+
+  void File_pipeline::submit(std::filesystem::path filename, File_type type)
+  {
+    _to_read.push({ std::move(filename), type });
+  }
+
+
+  void File_pipeline::finish()
+  {
+    if (_threads.empty())
+      return;
+
+    // Closing is propagated by the stages themselves.
+    _to_read.close();
+    _threads.clear();
+  }
+
+
+  void File_pipeline::print_counters(std::ostream& os) const
+  {
+    auto const print = [&os](std::string_view title, Queue_counters const& c)
+      {
+        os << title 
+           << ": max depth = "      << c.max_depth 
+           << ", average depth = "  << c.average_depth()
+           << ", producer waits = " << c.full_waits
+           << ", consumer waits = " << c.empty_waits << '\n';
+      };
+
+    if (_io_uring)
+      os << "Reading stage: io_uring, up to " << _io_uring->depth() << " files at once\n";
+    else
+      os << "Reading stage: " << _readers << " thread(s)\n";
+
+    os << "Pipeline queues (capacity " << _to_read.capacity() << ")\n";
+    print("walk -> read     "sv, _to_read.counters());
+    print("read -> analyze  "sv, _to_analyze.counters());
+    print("analyze -> merge "sv, _to_merge.counters());
+  }
+
+
+  void File_pipeline::_read()
+  {
+    while (auto job = _to_read.pop())
+      _read_file(job->type, job->filename);
+
+    _to_analyze.close();
+  }
+
+
+  void File_pipeline::_read_file(File_type type, std::filesystem::path const& filename)
+  {
+    run_and_report_exception([&]
+      {
+        try
+        {
+          _to_analyze.push({ type, File_type_dispatcher::read(filename) });
+        }
+        catch (File_too_big const&)
+        {
+          _stream(type, filename);
+        }
+      });
+  }
+
+
+  void File_pipeline::_read_io_uring()
+  {
+    std::vector<File_type> types(_io_uring->depth()); // the types of the files being read, by slot
+    auto const on_done = [this, &types](unsigned slot, Io_uring_reader::Result result)
+      {
+        run_and_report_exception([&]
+          {
+            try
+            {
+              if (!result)
+                std::rethrow_exception(result.error());
+              _to_analyze.push({ types[slot], std::move(*result) });
+            }
+            catch (File_too_big const& error)
+            {
+              _stream(types[slot], error.file_path());
+            }
+          });
+      };
+
+    run_and_report_exception([this, &types, &on_done]
+      {
+        for (bool walking = true; walking || _io_uring->in_flight() != 0;)
+        {
+          // Keep the ring full, wait for the walker only if there is nothing else to wait for.
+          while (walking && !_io_uring->full())
+          {
+            auto job = _io_uring->in_flight() == 0 ? _to_read.pop() : _to_read.try_pop();
+            if (!job)
+            {
+              walking = _io_uring->in_flight() != 0;
+              break;
+            }
+
+            types[_io_uring->start(std::move(job->filename))] = job->type;
+          }
+
+          if (_io_uring->in_flight() != 0)
+            _io_uring->wait(on_done);
+        }
+      });
+
+    // If io_uring has failed, read the files in flight and the rest with read(), then close the next queue.
+    _io_uring->abandon([this, &types](unsigned slot, std::filesystem::path const& filename)
+      {
+        _read_file(types[slot], filename);
+      });
+    _read();
+  }
+
+
+  void File_pipeline::_stream(File_type type, std::filesystem::path const& filename)
+  {
+    // The analyzers close the merging queue only after the readers have closed the analysis queue.
+    _to_merge.push({ type, File_type_dispatcher::analyze_stream(type, filename, _analysis_mode, _quantiles) });
+  }
+
+
+  void File_pipeline::_analyze()
+  {
+    while (auto job = _to_analyze.pop())
+      _to_merge.push({ job->type, 
+                       File_type_dispatcher::analyze(job->type, job->file_data, _analysis_mode, _quantiles) });
+
+    _to_merge.close();
+  }
+
+
+  void File_pipeline::_merge()
+  {
+    while (auto job = _to_merge.pop())
+      _target.accumulate(job->type, job->analysis);
+  }
+
+}
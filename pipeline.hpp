@@ -0,0 +1,124 @@
+/******************************************************************************
+MIT License
+
+Copyright (c) 2024 Dmitry R. Kuvshinov
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+******************************************************************************/
+
+/// @file   pipeline.hpp
+/// @brief  Staged source file processing: walk -> read -> analyze -> merge.
+/// @author D.R.Kuvshinov kuvshinovdr at yandex.ru
+#ifndef SRCSTATS_PIPELINE_HPP_INCLUDED
+#define SRCSTATS_PIPELINE_HPP_INCLUDED
+
+#include "file_type.hpp"
+#include "bounded_queue.hpp"
+#include "io_uring_reader.hpp"
+
+#include <filesystem>
+#include <memory>
+#include <ostream>
+#include <thread>
+#include <vector>
+
+
+namespace srcstats
+{
+
+  /// @brief Staged source file processing with bounded queues between the stages.
+  /// The walking stage is the caller (see submit), reading, analysis and merging run in their own threads.
+  /// So reading of the next files is in flight while the previous ones are being decommented.
+  /// Merging is done by one thread, so the language results are never accessed concurrently.
+  /// Files larger than File_type_dispatcher::maximal_file_size are processed by chunks in the reading stage.
+  class File_pipeline
+  {
+  public:
+    /// @brief                Start the stage threads.
+    /// @param target         the dispatcher accumulating the statistics of the files (only by the merging thread 
+    ///                       until finish, its other members may be used by the caller meanwhile)
+    /// @param readers        how many threads read files (if io_uring is not used)
+    /// @param analyzers      how many threads decomment files and compute their statistics
+    /// @param capacity       the capacity of each queue between the stages
+    /// @param io_uring_depth if not zero, one thread reads up to this count of files at once with io_uring
+    ///                       (falls back to the reader threads if io_uring is not available)
+    /// @param mode           how the analyzers compute the file statistics
+    /// @param quantiles      keep the sketches of the line lengths (see File_analysis::use_line_quantiles)
+    File_pipeline(File_type_dispatcher& target, size_t readers, size_t analyzers, size_t capacity = 256, 
+                  unsigned io_uring_depth = 0, Analysis_mode mode = Analysis_mode::fused, bool quantiles = false);
+
+    /// @brief Finish the work if finish() has not been called.
+    ~File_pipeline();
+
+    File_pipeline(File_pipeline const&)            = delete;
+    File_pipeline& operator=(File_pipeline const&) = delete;
+
+    /// @brief          Pass a recognized source file to the reading stage (may be called from several threads).
+    /// Waits if the reading stage is behind.
+    /// @param filename path to the file
+    /// @param type     the file type
+    void submit(std::filesystem::path filename, File_type type);
+
+    /// @brief Wait until all the submitted files are merged into the results of the target, stop the threads.
+    void finish();
+
+    /// @brief    Print usage counters of the queues between the stages.
+    /// @param os the destination output stream
+    void print_counters(std::ostream& os) const;
+
+  private:
+    struct Read_job
+    {
+      std::filesystem::path filename;
+      File_type             type;
+    };
+
+    struct Analysis_job
+    {
+      File_type type;
+      File_data file_data;
+    };
+
+    struct Merge_job
+    {
+      File_type     type;
+      File_analysis analysis;
+    };
+
+    File_type_dispatcher&            _target;
+    std::unique_ptr<Io_uring_reader> _io_uring; // null if the reader threads are used
+    size_t                           _readers;
+    Analysis_mode                    _analysis_mode;
+    bool                             _quantiles;
+    Bounded_queue<Read_job>          _to_read;
+    Bounded_queue<Analysis_job>      _to_analyze;
+    Bounded_queue<Merge_job>         _to_merge;
+    std::vector<std::jthread>        _threads;
+
+    void _read();
+    void _read_file(File_type type, std::filesystem::path const& filename);
+    void _read_io_uring();
+    void _stream(File_type type, std::filesystem::path const& filename);
+    void _analyze();
+    void _merge();
+  };
+
+}
+
+#endif//SRCSTATS_PIPELINE_HPP_INCLUDED
@@ -0,0 +1,238 @@
+/******************************************************************************
+MIT License
+
+Copyright (c) 2024 Dmitry R. Kuvshinov
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+******************************************************************************/
+
+/// @file   quantile_sketch.cpp
+/// @brief  Quantile sketch implementation details.
+/// @author D.R.Kuvshinov kuvshinovdr at yandex.ru
+
+#include "quantile_sketch.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+
+namespace srcstats
+{
+
+  namespace
+  {
+
+    /// @brief The capacities of the levels by their depths and the total capacities by the counts of levels.
+    constexpr auto level_capacities = []
+      {
+        std::array<size_t, Quantile_sketch::max_levels> result;
+        for (size_t depth = 0; depth < result.size(); ++depth)
+          result[depth] = Quantile_sketch::capacities.level(depth);
+        return result;
+      }();
+
+    constexpr auto total_capacities = []
+      {
+        std::array<size_t, Quantile_sketch::max_levels + 1> result { 0 };
+        for (size_t levels = 1; levels < result.size(); ++levels)
+          result[levels] = result[levels - 1] + level_capacities[levels - 1];
+        return result;
+      }();
+
+
+    /// @brief        Sort the items by their bytes from the lowest one (LSD radix sort), the bytes equal 
+    /// in all of them are skipped (e.g. the higher bytes of short line lengths).
+    /// @param items  the items to be sorted
+    /// @param count  how many items there are
+    /// @param buffer the working memory for count items
+    void radix_sort(Quantile_sketch::Item* items, size_t count, Quantile_sketch::Item* buffer) noexcept
+    {
+      constexpr int digits = sizeof(Quantile_sketch::Item);
+
+      std::array<std::array<size_t, 256>, digits> offsets {};
+      for (size_t i = 0; i < count; ++i)
+        for (int digit = 0; digit < digits; ++digit)
+          ++offsets[digit][(items[i] >> 8 * digit) & 0xFF];
+
+      auto const sorted = items;
+      for (int digit = 0; digit < digits; ++digit)
+      {
+        auto& digit_offsets = offsets[digit];
+        if (digit_offsets[(items[0] >> 8 * digit) & 0xFF] == count)
+          continue;
+
+        for (size_t sum = 0; auto& offset: digit_offsets)
+          sum += std::exchange(offset, sum);
+
+        for (size_t i = 0; i < count; ++i)
+          buffer[digit_offsets[(items[i] >> 8 * digit) & 0xFF]++] = items[i];
+
+        std::swap(items, buffer);
+      }
+
+      if (items != sorted)
+        std::copy_n(items, count, sorted);
+    }
+
+  }
+
+
+  uint64_t Quantile_sketch::count() const noexcept
+  {
+    uint64_t result = 0;
+    for (size_t level = 0; level < _level_count; ++level)
+      result += uint64_t(_levels[level + 1] - _levels[level]) << level;
+    return result;
+  }
+
+
+  size_t Quantile_sketch::percentile(double p) const
+  {
+    std::vector<std::pair<Item, uint64_t>> weighted;
+    weighted.reserve(_size());
+    for (size_t level = 0; level < _level_count; ++level)
+      for (auto i = _levels[level]; i < _levels[level + 1]; ++i)
+        weighted.emplace_back(_items[i], uint64_t(1) << level);
+
+    if (weighted.empty())
+      return 0;
+
+    std::ranges::sort(weighted, {}, &std::pair<Item, uint64_t>::first);
+
+    // The rank is computed as Statistics_accumulator::percentile does.
+    auto const exact = p / 100 * static_cast<double>(count());
+    auto       rank  = static_cast<uint64_t>(exact);
+    rank += rank < exact || rank == 0;
+
+    uint64_t counted = 0;
+    for (auto [item, weight]: weighted)
+      if ((counted += weight) >= rank)
+        return item;
+
+    return weighted.back().first;
+  }
+
+
+  Quantile_sketch& Quantile_sketch::operator()(Quantile_sketch const& other) noexcept
+  {
+    if (&other == this)
+      return (*this)(Quantile_sketch(other));
+
+    while (_level_count < other._level_count)
+      _levels[++_level_count] = capacity;
+
+    // The levels are taken by chunks fitting the free space, the sorted levels give sorted chunks.
+    for (size_t level = 0; level < other._level_count; ++level)
+    {
+      for (auto from = other._levels[level], to = other._levels[level + 1]; from < to;)
+      {
+        auto const count = srcstats::min(to - from, merge_chunk);
+        _insert(level, other._items.data() + from, count);
+        from += count;
+        if (_size() >= total_capacities[_level_count])
+          _compress();
+      }
+    }
+
+    _limit = _levels[0] - (total_capacities[_level_count] - _size());
+    return *this;
+  }
+
+
+  bool Quantile_sketch::_coin() noexcept
+  {
+    // A 64-bit linear congruential generator (Knuth's MMIX constants), its highest bit is the most random.
+    _random = _random * 6364136223846793005u + 1442695040888963407u;
+    return (_random >> 63) != 0;
+  }
+
+
+  void Quantile_sketch::_compress() noexcept
+  {
+    // Compact the levels reaching their capacities from the lowest one (there is one if the levels are full), 
+    // a new top level is added to compact the current top one. The levels are left about half full, 
+    // so the new values are taken by level 0 for long (a level compacted alone would be filled again 
+    // by a few values compacted into it).
+    while (_size() >= total_capacities[_level_count])
+    {
+      for (size_t level = 0; level < _level_count; ++level)
+      {
+        if (_levels[level + 1] - _levels[level] < level_capacities[_level_count - 1 - level])
+          continue;
+
+        if (level + 1 == _level_count)
+          _levels[++_level_count] = capacity;
+
+        _compact(level);
+      }
+    }
+
+    _limit = _levels[0] - (total_capacities[_level_count] - _size());
+  }
+
+
+  void Quantile_sketch::_compact(size_t level) noexcept
+  {
+    auto const items = _items.data();
+    auto const begin = _levels[level], end = _levels[level + 1], next_end = _levels[level + 2];
+    if (level == 0)
+    {
+      std::array<Item, capacity> buffer;
+      radix_sort(items + begin, end - begin, buffer.data());
+    }
+
+    // If the count is odd, the least value stays. The chosen values are moved to the end of the level 
+    // from the last one (a value is never written before it is read), and merged with the next level.
+    auto const odd    = (end - begin) & 1;
+    auto const half   = (end - begin) / 2;
+    auto const chosen = begin + odd + _coin();
+    for (auto i = half; i-- != 0;)
+      items[end - half + i] = items[chosen + 2 * i];
+
+    std::inplace_merge(items + end - half, items + end, items + next_end);
+    if (odd)
+      items[end - half - 1] = items[begin];
+
+    // The lower levels are moved up to the freed space.
+    auto const first = _levels[0];
+    std::memmove(items + first + half, items + first, (begin - first) * sizeof(Item));
+    for (size_t i = 0; i <= level; ++i)
+      _levels[i] += half;
+    _levels[level + 1] = end - half;
+  }
+
+
+  void Quantile_sketch::_insert(size_t level, Item const* from, size_t count) noexcept
+  {
+    // The lower levels are moved down to the free space, the values are appended to level 0 
+    // or merged with a sorted level.
+    auto const items = _items.data();
+    auto const first = _levels[0], begin = _levels[level];
+    std::memmove(items + first - count, items + first, (begin - first) * sizeof(Item));
+    for (size_t i = 0; i <= level; ++i)
+      _levels[i] -= count;
+
+    std::copy_n(from, count, items + begin - count);
+    if (level != 0)
+      std::inplace_merge(items + begin - count, items + begin, items + _levels[level + 1]);
+  }
+
+}
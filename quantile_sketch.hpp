@@ -0,0 +1,136 @@
+/******************************************************************************
+MIT License
+
+Copyright (c) 2024 Dmitry R. Kuvshinov
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+******************************************************************************/
+
+/// @file   quantile_sketch.hpp
+/// @brief  Mergeable quantile sketch of bounded size (KLL).
+/// @author D.R.Kuvshinov kuvshinovdr at yandex.ru
+#ifndef SRCSTATS_QUANTILE_SKETCH_HPP_INCLUDED
+#define SRCSTATS_QUANTILE_SKETCH_HPP_INCLUDED
+
+#include "basic.hpp"
+
+#include <array>
+#include <bit>
+#include <limits>
+
+
+namespace srcstats
+{
+
+  /// @brief The capacities of the levels of a KLL sketch: they decrease by the factor of 2/3 from the top level.
+  struct Kll_capacities
+  {
+    size_t top;
+    size_t minimal;
+
+    /// @brief Get the capacity of a level, depth is 0 for the top level.
+    [[nodiscard]] constexpr size_t level(size_t depth) const noexcept
+    {
+      auto capacity = static_cast<double>(top);
+      while (depth-- != 0)
+        capacity *= 2.0 / 3.0;
+      return srcstats::max(minimal, static_cast<size_t>(capacity + 0.5));
+    }
+
+    /// @brief Get the total capacity of the given count of levels.
+    [[nodiscard]] constexpr size_t total(size_t levels) const noexcept
+    {
+      size_t result = 0;
+      for (size_t depth = 0; depth < levels; ++depth)
+        result += level(depth);
+      return result;
+    }
+  };
+
+
+  /// @brief Estimate quantiles of size_t values in fixed memory (the KLL sketch by Karnin, Lang and Liberty).
+  /// The values are kept in levels: each value of level h stands for 2^h values. The new values are appended 
+  /// to level 0 without any other work until the levels are full, then the levels reaching their capacities 
+  /// are compacted: a level is sorted and every other value (the odd or the even ones, by a coin) is moved 
+  /// to the next level. The capacities of the levels decrease by the factor of 2/3 from the top one. 
+  /// The rank error is below 0.5% of the count (see the README), the sketches are merged level by level.
+  /// Values not less than 2^32 are taken as 2^32-1.
+  /// The coin is pseudo-random with a fixed seed, so the results are reproducible, yet they depend 
+  /// on the order of values and merges (within the error).
+  class Quantile_sketch
+  {
+  public:
+    using Item = uint32_t;
+
+    /// @brief The capacities of the levels: 640 values at the top, not less than 8 values.
+    static constexpr Kll_capacities capacities { 640, 8 };
+    /// @brief The top level (of values standing for 2^(max_levels-1) values) is never reached by 2^64 values.
+    static constexpr size_t         max_levels  = 66 - std::bit_width(capacities.top);
+    /// @brief How many values are merged at once (at least this much space is free after compression).
+    static constexpr size_t         merge_chunk = 256;
+    /// @brief The size of the storage of the levels.
+    static constexpr size_t         capacity    = capacities.total(max_levels) + merge_chunk;
+
+
+    // Getters
+
+    /// @brief Get how many values have been put.
+    [[nodiscard]] uint64_t count() const noexcept;
+
+    /// @brief   Estimate the value not exceeded by the given percentage of the values (0 if there are none).
+    /// It is one of the values put (the least one of the estimated rank).
+    /// @param p the percentage from 0 to 100
+    [[nodiscard]] size_t percentile(double p) const;
+
+
+    // Mutators
+
+    /// @brief Put the next value (it is stored, the levels are compressed once they are full).
+    Quantile_sketch& operator()(size_t value) noexcept
+    {
+      _items[--_levels[0]] = static_cast<Item>(srcstats::min(value, std::numeric_limits<Item>::max()));
+      if (_levels[0] == _limit)
+        _compress();
+      return *this;
+    }
+
+    /// @brief Put the values of another sketch.
+    Quantile_sketch& operator()(Quantile_sketch const& other) noexcept;
+
+  private:
+    std::array<Item, capacity>         _items;                             // level h is [_levels[h], _levels[h + 1])
+    std::array<size_t, max_levels + 1> _levels      { capacity, capacity }; // the free space precedes level 0
+    size_t                             _level_count = 1;
+    size_t                             _limit       = capacity - capacities.top; // level 0 start to compress at
+    uint64_t                           _random      = 0x5eed'5eed'5eed'5eed;     // the state of the coin
+
+    [[nodiscard]] size_t _size() const noexcept
+    {
+      return capacity - _levels[0];
+    }
+
+    [[nodiscard]] bool _coin() noexcept;
+    void               _compress() noexcept;
+    void               _compact(size_t level) noexcept;
+    void               _insert(size_t level, Item const* from, size_t count) noexcept;
+  };
+
+}
+
+#endif//SRCSTATS_QUANTILE_SKETCH_HPP_INCLUDED
@@ -0,0 +1,73 @@
+/******************************************************************************
+MIT License
+
+Copyright (c) 2024 Dmitry R. Kuvshinov
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+******************************************************************************/
+
+/// @file   report.hpp
+/// @brief  Error reporting helpers.
+/// @author D.R.Kuvshinov kuvshinovdr at yandex.ru
+#ifndef SRCSTATS_REPORT_HPP_INCLUDED
+#define SRCSTATS_REPORT_HPP_INCLUDED
+
+#include "file.hpp"
+
+#include <exception>
+#include <iostream>
+#include <syncstream>
+
+
+namespace srcstats
+{
+
+  /// @brief        Try to perform the action and deal with possible exceptions: std::exception or File_error.
+  /// The report is output as a whole, so it may be called from several threads.
+  /// @param action the functional object to be called in exception catching environment
+  /// @return       0 if no exceptions have been thrown, 1 otherwise (e.g. to serve as a return code from main)
+  int run_and_report_exception(auto action) noexcept
+  {
+    std::osyncstream log(std::clog);
+    try
+    {
+      action();
+      return 0;
+    }
+    catch (File_error const& fe)
+    {
+      log << "File error with " << fe.file_path() 
+          << ": " << fe.what()  << " (" << fe.file_data() << ')';
+    }
+    catch (std::exception const& e)
+    {
+      log << "Error: " << e.what();
+    }
+    catch (...)
+    {
+      log << "Unknown exception type.";
+    }
+
+    log << std::endl;
+    return 1;
+  }
+
+}
+
+#endif//SRCSTATS_REPORT_HPP_INCLUDED
@@ -0,0 +1,209 @@
+/******************************************************************************
+MIT License
+
+Copyright (c) 2024 Dmitry R. Kuvshinov
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+******************************************************************************/
+/// @file   sniff.cpp
+/// @brief  Source file sniffing implementation.
+/// @author D.R.Kuvshinov kuvshinovdr at yandex.ru
+
+#include "sniff.hpp"
+#include "file.hpp"
+#include "utf8.hpp"
+
+#include <algorithm>
+#include <fstream>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define SRCSTATS_HAS_PREAD 1
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#endif
+
+
+namespace srcstats
+{
+
+  using namespace characters;
+
+  namespace
+  {
+
+    /// @brief Check if the line is a comment line (C-like or script-like) having a generated code marker.
+    [[nodiscard]] bool is_generated_marker_line(String_view line) noexcept
+    {
+      line.remove_prefix(min(line.find_first_not_of(" \t"sv), line.size()));
+      if (!line.starts_with("//"sv) && !line.starts_with("/*"sv) 
+       && !line.starts_with("*"sv)  && !line.starts_with("#"sv))
+        return false;
+
+      return std::ranges::any_of(generated_markers, 
+               [line](std::string_view marker) { return line.find(marker) != NPOS; });
+    }
+
+  }
+
+
+  std::string_view file_kind_name(File_kind kind) noexcept
+  {
+    static constexpr std::string_view names[file_kind_count]
+    {
+      "source"sv,
+      "binary"sv,
+      "generated"sv,
+      "minified"sv,
+    };
+
+    return names[static_cast<size_t>(kind)];
+  }
+
+
+  File_kind sniff(String_view head) noexcept
+  {
+    std::array<Character, Utf16_transcoder::max_output_size(sniff_size)> text;
+    head = decode_head(head.substr(0, sniff_size), text.data());
+
+    auto const nuls = static_cast<size_t>(std::ranges::count(head, NUL));
+    if (nuls * binary_nul_ratio > head.size())
+      return File_kind::binary;
+
+    size_t lines = 0;
+    for (size_t from = 0; from < head.size(); ++lines)
+    {
+      auto const to = min(head.find(LF, from), head.size());
+      if (is_generated_marker_line(head.substr(from, to - from)))
+        return File_kind::generated;
+      from = to + 1;
+    }
+
+    if (head.size() >= size_t(1) << 10 && head.size() > minified_line_length * max(lines, 1))
+      return File_kind::minified;
+
+    return File_kind::source;
+  }
+
+
+  void Sniff_counters::print(std::ostream& os) const
+  {
+    os << "Skipped files:";
+    
+    bool first = true;
+    for (size_t i = 0; i < file_kind_count; ++i)
+    {
+      if (files[i] == 0)
+        continue;
+
+      os << (first ? " "sv : ", "sv) << files[i] << ' ' << file_kind_name(static_cast<File_kind>(i))
+         << " (" << (bytes[i] >> 10) << " KiB)";
+      first = false;
+    }
+
+    os << '\n';
+  }
+
+
+#if defined(SRCSTATS_HAS_PREAD)
+
+  File_head read_file_head(std::filesystem::path const& filename)
+  {
+    int const fd = ::open(filename.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+      throw File_error("failed to open", filename, errno);
+
+    try
+    {
+      auto const result = read_file_head(fd, filename);
+      ::close(fd);
+      return result;
+    }
+    catch (...)
+    {
+      ::close(fd);
+      throw;
+    }
+  }
+
+
+  File_head read_file_head(int fd, std::filesystem::path const& filename)
+  {
+    struct stat st;
+    if (::fstat(fd, &st) != 0)
+      throw File_error("failed to get file size", filename, errno);
+
+    File_head  head;
+    head.size = static_cast<uintmax_t>(st.st_size);
+    auto const want = static_cast<size_t>(std::min(head.size, static_cast<uintmax_t>(sniff_size)));
+    while (head.length < want)
+    {
+      auto const bytes = ::pread(fd, head.bytes.data() + head.length, want - head.length, 
+                                 static_cast<off_t>(head.length));
+      if (bytes < 0 && errno == EINTR)
+        continue;
+      if (bytes < 0)
+        throw File_error("failed to read", filename, errno);
+      if (bytes == 0)
+        break;
+      head.length += static_cast<size_t>(bytes);
+    }
+
+    return head;
+  }
+
+#else
+
+  File_head read_file_head(std::filesystem::path const& filename)
+  {
+    File_head head;
+    head.size = std::filesystem::file_size(filename);
+    std::ifstream file(filename, std::ios::binary);
+    if (!file.is_open())
+      throw File_error("failed to open", filename);
+
+    file.read(head.bytes.data(), sniff_size);
+    head.length = static_cast<size_t>(file.gcount());
+    return head;
+  }
+
+
+  File_head read_file_head(int, std::filesystem::path const& filename)
+  {
+    throw File_error("file descriptors are not supported on this platform", filename);
+  }
+
+#endif
+
+
+  Sniffed_file sniff_file(std::filesystem::path const& filename)
+  {
+    auto const head = read_file_head(filename);
+    return { sniff(head.view()), head.size };
+  }
+
+
+  Sniffed_file sniff_file(int fd, std::filesystem::path const& filename)
+  {
+    auto const head = read_file_head(fd, filename);
+    return { sniff(head.view()), head.size };
+  }
+
+}
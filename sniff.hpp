@@ -0,0 +1,173 @@
+/******************************************************************************
+MIT License
+
+Copyright (c) 2024 Dmitry R. Kuvshinov
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+******************************************************************************/
+/// @file   sniff.hpp
+/// @brief  Classification of source files by their first bytes (binary, generated and minified files are skipped).
+/// @author D.R.Kuvshinov kuvshinovdr at yandex.ru
+#ifndef SRCSTATS_SNIFF_HPP_INCLUDED
+#define SRCSTATS_SNIFF_HPP_INCLUDED
+
+#include "basic.hpp"
+
+#include <array>
+#include <filesystem>
+#include <ostream>
+
+
+namespace srcstats
+{
+
+  /// @brief What a file with a source extension turns out to be.
+  enum class File_kind : unsigned char
+  {
+    source,     // to be analyzed
+    binary,     // NUL bytes are frequent
+    generated,  // a comment line in the head has a generated code marker (see generated_markers)
+    minified,   // the lines are very long
+  };
+
+  /// @brief How many file kinds there are.
+  constexpr size_t file_kind_count = 4;
+
+  /// @brief Get the name of the file kind (as printed).
+  [[nodiscard]] std::string_view file_kind_name(File_kind kind) noexcept;
+
+
+  /// @brief How many first bytes of a file are examined.
+  constexpr size_t sniff_size = size_t(8) << 10;
+
+  /// @brief A file is binary if more than 1/binary_nul_ratio of its head are NUL bytes.
+  constexpr size_t binary_nul_ratio = 128;
+
+  /// @brief A file is minified if the average line length in its head is larger (the head should be at least 1KiB).
+  constexpr size_t minified_line_length = 256;
+
+  /// @brief The markers tools put to comments of the files they generate.
+  constexpr std::array<std::string_view, 3> generated_markers
+  {
+    "@generated"sv,
+    "DO NOT EDIT"sv,       // Go, protobuf and many others
+    "<auto-generated"sv,   // .NET tools
+  };
+
+
+  /// @brief      Classify a file by its head (transcoded to UTF-8 if it starts with a UTF-16 byte order mark).
+  /// @param head the first sniff_size bytes of the file (or the whole file if it is smaller)
+  /// @return     the file kind
+  [[nodiscard]] File_kind sniff(String_view head) noexcept;
+
+
+  /// @brief The first sniff_size bytes of a file (or the whole file if it is smaller).
+  struct File_head
+  {
+    std::array<Character, sniff_size> bytes;
+    size_t    length = 0;   // how many bytes have been read
+    uintmax_t size   = 0;   // the file size
+
+    /// @brief Get the bytes read.
+    [[nodiscard]] String_view view() const noexcept
+    {
+      return { bytes.data(), length };
+    }
+
+    /// @brief Check if the whole file has been read.
+    [[nodiscard]] bool is_whole() const noexcept
+    {
+      return length == size;
+    }
+  };
+
+  /// @brief          Read the head of a file (one pread on POSIX), throw File_error if the file can't be open or read.
+  /// @param filename the path to the file
+  /// @return         the head and the file size
+  [[nodiscard]] File_head read_file_head(std::filesystem::path const& filename);
+
+  /// @brief          Read the head of an open file (POSIX file descriptor, it is not closed).
+  /// @param fd       the file descriptor
+  /// @param filename the path to the file (for error messages)
+  /// @return         the head and the file size
+  [[nodiscard]] File_head read_file_head(int fd, std::filesystem::path const& filename);
+
+
+  /// @brief The result of sniffing a file.
+  struct Sniffed_file
+  {
+    File_kind kind = File_kind::source;
+    uintmax_t size = 0;     // the file size
+  };
+
+  /// @brief          Read the head of a file to a stack buffer (see read_file_head) and classify it.
+  /// Throws File_error if the file can't be open or read.
+  /// @param filename the path to the file
+  /// @return         the file kind and size
+  [[nodiscard]] Sniffed_file sniff_file(std::filesystem::path const& filename);
+
+  /// @brief          Read the head of an open file (POSIX file descriptor, it is not closed) and classify it.
+  /// @param fd       the file descriptor
+  /// @param filename the path to the file (for error messages)
+  /// @return         the file kind and size
+  [[nodiscard]] Sniffed_file sniff_file(int fd, std::filesystem::path const& filename);
+
+
+  /// @brief The files skipped after sniffing by kind.
+  struct Sniff_counters
+  {
+    std::array<size_t,    file_kind_count> files{}; // how many files have been skipped
+    std::array<uintmax_t, file_kind_count> bytes{}; // their total size
+
+    /// @brief Count a skipped file.
+    constexpr void count(Sniffed_file const& file) noexcept
+    {
+      auto const kind = static_cast<size_t>(file.kind);
+      ++files[kind];
+      bytes[kind] += file.size;
+    }
+
+    /// @brief Check if no files have been skipped.
+    [[nodiscard]] constexpr bool is_empty() const noexcept
+    {
+      for (auto const count: files)
+        if (count != 0)
+          return false;
+      return true;
+    }
+
+    /// @brief Add the counters of another dispatcher.
+    constexpr Sniff_counters& operator()(Sniff_counters const& other) noexcept
+    {
+      for (size_t i = 0; i < file_kind_count; ++i)
+      {
+        files[i] += other.files[i];
+        bytes[i] += other.bytes[i];
+      }
+      return *this;
+    }
+
+    /// @brief    Print the counts of the skipped kinds as one line.
+    /// @param os the destination output stream
+    void print(std::ostream& os) const;
+  };
+
+}
+
+#endif//SRCSTATS_SNIFF_HPP_INCLUDED
@@ -28,17 +28,25 @@ SOFTWARE.
 
 #include "file_type.hpp"
 #include "file.hpp"
-//#include "utf8.hpp" // WIP
+#include "work_stealing.hpp"
+#include "pipeline.hpp"
+#include "native_walk.hpp"
+#include "exclusion.hpp"
+#include "ignore_files.hpp"
+#include "report.hpp"
+#include "text_simd.hpp"
 
-#include "langs/cpp/cpp_stat.hpp"
-#include "langs/cs/cs_stat.hpp"
+#include "langs/languages.hpp"
 
 #include <iterator>
 #include <functional>
 #include <chrono>
 #include <ranges>
 #include <vector>
-#include <unordered_set>
+#include <charconv>
+#include <stdexcept>
+#include <thread>
+#include <memory>
 #include <iostream>
 
 using namespace std;
@@ -48,35 +56,6 @@ namespace fs = filesystem;
 namespace srcstats
 {
 
-  /// @brief        Try to perform the action and deal with possible exceptions: std::exception or File_error.
-  /// @param action the functional object to be called in exception catching environment
-  /// @return       0 if no exceptions have been thrown, 1 otherwise (e.g. to serve as a return code from main)
-  int run_and_report_exception(auto action) noexcept
-  {
-    try
-    {
-      action();
-      return 0;
-    }
-    catch (File_error const& fe)
-    {
-      clog << "File error with " << fe.file_path() 
-           << ": " << fe.what()  << " (" << fe.file_data() << ')';
-    }
-    catch (exception const& e)
-    {
-      clog << "Error: " << e.what();
-    }
-    catch (...)
-    {
-      clog << "Unknown exception type.";
-    }
-
-    clog << endl;
-    return 1;
-  }
-
-
   /// @brief SrcStats application logic.
   class Source_statistics_application
   {
@@ -84,12 +63,8 @@ namespace srcstats
 
     Source_statistics_application()
     {
-      // Add each supported language here.
-      _langs.emplace_back(new_cpp_statistics());
-      _langs.emplace_back(new_cs_statistics());
-
-      // Register file types.
-      for (auto& lang: _langs)
+      // Register file types (the supported languages are listed in langs/languages.hpp).
+      for (auto lang: _langs)
         lang->register_file_types(_file_type_dispatcher);
     }
 
@@ -109,19 +84,82 @@ namespace srcstats
             run_and_report_exception(
               bind(mem_fn(&Source_statistics_application::_process_argument), this, argv[i]));
 
-          auto const time_elapsed = chrono::steady_clock::now() - start_time;
+          if (_pipeline)
+            _pipeline->finish();
+
+          _flush_batches();
+
+          auto const time_elapsed    = chrono::steady_clock::now() - start_time;
+          auto const buffer_counters = _buffer_pool_counters();
+          auto const skipped         = _skipped_files();
+          _merge_worker_stats();
           _print_stats();
           cout << "Time elapsed: " << chrono::duration<double>(time_elapsed).count() << "s\n";
+
+          if (!skipped.is_empty())
+            skipped.print(cout);
+
+          if (_pipeline)
+            _pipeline->print_counters(cout);
+
+          if (buffer_counters.hits + buffer_counters.misses != 0)
+            cout << "Buffer pools: "  << buffer_counters.hits   << " hits, " 
+                 << buffer_counters.misses << " misses, "
+                 << buffer_counters.kept   << " buffers kept ("
+                 << (buffer_counters.kept_bytes >> 10) << " KiB)\n";
         });
     }
 
 
   private:
 
-    File_type_dispatcher             _file_type_dispatcher;
-    std::unordered_set<fs::path>     _excluded_folders;
-    std::vector<Lang_interface_uptr> _langs;
-    bool                             _exclude_next_path = false;
+    /// @brief Directory traversal task: a directory to be listed or a file to be processed.
+    struct Walk_task
+    {
+      fs::path                 path;
+      bool                     is_directory = false;
+      Exclusion_matcher::State exclusion;            // the directory state
+      Ignore_state             ignore;               // the directory state
+    };
+
+    /// @brief Native walker task: a directory to be listed or a file to be processed, named relative to its parent.
+    struct Native_task
+    {
+      Directory_handle_sptr parent;
+      String                name;                     // empty name means the parent itself (the root)
+      uintmax_t             size = unknown_file_size;
+      bool                  is_directory = false;
+      Exclusion_matcher::State exclusion;            // the directory state
+      Ignore_state             ignore;               // the directory state
+    };
+
+    /// @brief Directory entry kept by a walker until the ignore rules of the directory are loaded.
+    struct Listed_entry
+    {
+      String    name;
+      uintmax_t size         = unknown_file_size;
+      bool      is_directory = false;
+    };
+
+    File_type_dispatcher              _file_type_dispatcher;
+    Exclusion_matcher                 _exclusions;
+    std::span<Lang_interface const* const> _langs = Languages::analyzers(); // shared by all the workers
+    std::vector<File_type_dispatcher> _workers; // worker 0 uses _file_type_dispatcher, worker i uses _workers[i - 1]
+    std::unique_ptr<File_pipeline>    _pipeline;
+    size_t                            _jobs = 1;
+    bool                              _exclude_next_path = false;
+    bool                              _jobs_next = false;
+    bool                              _use_pipeline = false;
+    bool                              _use_io_uring = false;
+    bool                              _native_walk = false;
+    bool                              _use_ignore_files = true;
+    bool                              _memory_mapping = false;
+    bool                              _streaming = false;
+    bool                              _reference_analysis = false;
+    bool                              _sniffing = false;
+    bool                              _detecting = false;
+    bool                              _quantiles = false;
+    bool                              _batching = true;
 
 
     /// @brief      Check command line arguments for help markers and print help if requested.
@@ -148,13 +186,50 @@ namespace srcstats
           "Author: Kuvshinov D.R.\n"
           "Pass file or directory paths as command line parameters in order to calculate\n"
           "source files statistics.\n\n"
-          "Pass -Xpath or --exclude path in order to exclude a path from the statistics.\n"
+          "Pass -Xpattern or --exclude pattern in order to exclude paths from the statistics.\n"
+          "Patterns may contain *, ?, [set] and ** (any count of directories).\n"
+          "A pattern without / matches names at any depth (e.g. *.pb.h or build-*),\n"
+          "relative ones are anchored at the roots (e.g. ./build or **/third_party/**).\n"
           "The excluded paths shall precede the paths of the accumulated source files.\n\n"
-          "Currently only ASCII encoding is correctly handled.\n\n"
+          "Pass -jN or --jobs N in order to process directories in N threads\n"
+          "(0 means the hardware concurrency). The default is one thread.\n\n"
+          "Pass --pipeline in order to read, decomment and merge files in separate\n"
+          "pipeline stages (each stage uses the --jobs count of threads).\n\n"
+          "Pass --io-uring in order to use the pipeline with one reading thread keeping\n"
+          "up to 128 files being opened and read at once with Linux io_uring\n"
+          "(falls back to the reader threads if io_uring is not available).\n\n"
+          "Pass --native-walk in order to use the Linux directory descriptor based\n"
+          "walker (openat, getdents64) instead of std::filesystem.\n\n"
+          "Pass --mmap in order to map the files to memory instead of reading them\n"
+          "(not used by the pipeline reading stage).\n\n"
+          "Files larger than 10MiB are read and processed by 64KiB chunks.\n"
+          "Pass --stream in order to process all files this way (in constant memory,\n"
+          "not used by the pipeline reading stage).\n\n"
+          "Pass --reference in order to compute the statistics by the multi-pass\n"
+          "algorithm writing the decommented text to check the results (they are\n"
+          "the same).\n\n"
+          "Pass --sniff in order to read the first 8KiB of each source file before\n"
+          "reading it: binary files (NUL bytes), generated files (marker comments)\n"
+          "and minified files (long lines) are skipped and counted apart.\n\n"
+          "Pass --detect in order to detect the languages of files without extensions\n"
+          "by their first 8KiB: the shebang, Emacs and Vim modelines and the frequent\n"
+          "keywords (e.g. the extension-less C++ standard library headers).\n\n"
+          "Files up to 16KiB are read to batches of about 256KiB per language and file\n"
+          "subtype analyzed by one call each. Pass --no-batch in order to analyze them\n"
+          "one by one (the results are the same).\n\n"
+          "Pass --quantiles in order to keep a sketch of the line lengths (about 10KiB\n"
+          "per statistics) and print its percentiles q50-q99.9 after the histogram\n"
+          "ones p50-p99.9: they are not rounded to the buckets, their ranks are within\n"
+          "about 0.5% of the line count (so q99.9 is rough).\n\n"
+          "Paths matching .gitignore, .git/info/exclude, .ignore and .srcstatsignore\n"
+          "rules are skipped (.gitignore syntax). Pass --no-ignore to disable this.\n\n"
+          "Files are read as UTF-8 (line lengths count characters, ill-formed bytes\n"
+          "of legacy 8-bit encodings count one by one), UTF-16 files with a byte\n"
+          "order mark are transcoded to UTF-8.\n\n"
           "Supported input languages: ";
 
         bool first = true;
-        for (auto& lang: _langs)
+        for (auto lang: _langs)
         {
           if (!first)
             cout << ", ";
@@ -163,7 +238,8 @@ namespace srcstats
           cout << lang->language_name();
         }
 
-        cout << ".\n\n";
+        cout << ".\n\n"
+                "Vector instructions used: " << simd_level_name(simd_level()) << ".\n\n";
         return true;
       }
 
@@ -171,12 +247,94 @@ namespace srcstats
     }
 
 
+    /// @brief Get the file type dispatcher of the worker.
+    [[nodiscard]] File_type_dispatcher& _dispatcher(size_t worker) noexcept
+    {
+      return worker == 0 ? _file_type_dispatcher : _workers[worker - 1];
+    }
+
+
+    /// @brief      Set the count of worker threads, create the file type dispatchers for the new workers.
+    /// @param jobs the count as a decimal number, 0 means std::thread::hardware_concurrency()
+    void _set_jobs(std::string_view jobs)
+    {
+      size_t count = 0;
+      if (auto const [ptr, ec] = from_chars(jobs.data(), jobs.data() + jobs.size(), count);
+          ec != errc{} || ptr != jobs.data() + jobs.size())
+        throw invalid_argument("--jobs expects a non-negative number");
+
+      if (count == 0)
+        count = max(thread::hardware_concurrency(), 1u);
+
+      while (_workers.size() + 1 < count)
+      {
+        auto& dispatcher = _workers.emplace_back();
+        for (auto lang: _langs)
+          lang->register_file_types(dispatcher);
+
+        dispatcher.use_memory_mapping(_memory_mapping);
+        dispatcher.use_streaming(_streaming);
+        dispatcher.use_reference_analysis(_reference_analysis);
+        dispatcher.use_sniffing(_sniffing);
+        dispatcher.use_detection(_detecting);
+        dispatcher.use_quantiles(_quantiles);
+        dispatcher.use_batching(_batching);
+      }
+
+      _jobs = count;
+    }
+
+
+    /// @brief Sum the buffer pool counters of all the workers.
+    [[nodiscard]] Buffer_pool_counters _buffer_pool_counters()
+    {
+      auto result = _file_type_dispatcher.buffers().counters();
+      for (auto& worker: _workers)
+        result(worker.buffers().counters());
+
+      return result;
+    }
+
+
+    /// @brief Sum the counters of the files skipped after sniffing by all the workers.
+    [[nodiscard]] Sniff_counters _skipped_files()
+    {
+      auto result = _file_type_dispatcher.skipped();
+      for (auto& worker: _workers)
+        result(worker.skipped());
+
+      return result;
+    }
+
+
+    /// @brief Analyze the small files left in the batches of all the workers.
+    void _flush_batches()
+    {
+      for (size_t worker = 0; worker <= _workers.size(); ++worker)
+        _dispatcher(worker).flush();
+    }
+
+
+    /// @brief Add all statistics accumulated by the additional workers to the main language results.
+    /// The workers are merged pairwise in rounds (1 to 0, 3 to 2, ..., then 2 to 0, 6 to 4, ...), 
+    /// so the order of merges depends only on the count of workers.
+    void _merge_worker_stats()
+    {
+      auto const count = _workers.size() + 1;
+      for (size_t stride = 1; stride < count; stride *= 2)
+        for (size_t to = 0; to + stride < count; to += 2 * stride)
+          _dispatcher(to).merge(_dispatcher(to + stride));
+
+      _workers.clear();
+    }
+
+
     void _print_stats()
     {
       File_statistics total_raw, total_decommented;
 
       int active_langs = 0;
-      for (auto& lang : _langs)
+      for (auto& lang : _file_type_dispatcher.results())
       {
         auto cur_raw = lang->total_with_comments();
         if (cur_raw.is_empty())
@@ -224,59 +382,363 @@ namespace srcstats
       {
         _exclude_next_path = true;
       }
+      else if (sv == "--jobs"sv)
+      {
+        _jobs_next = true;
+      }
+      else if (sv == "--pipeline"sv)
+      {
+        _use_pipeline = true;
+      }
+      else if (sv == "--io-uring"sv)
+      {
+        _use_pipeline = true;
+        _use_io_uring = true;
+      }
+      else if (sv == "--mmap"sv)
+      {
+        _memory_mapping = true;
+        _file_type_dispatcher.use_memory_mapping(true);
+        for (auto& worker: _workers)
+          worker.use_memory_mapping(true);
+      }
+      else if (sv == "--stream"sv)
+      {
+        _streaming = true;
+        _file_type_dispatcher.use_streaming(true);
+        for (auto& worker: _workers)
+          worker.use_streaming(true);
+      }
+      else if (sv == "--reference"sv)
+      {
+        _reference_analysis = true;
+        _file_type_dispatcher.use_reference_analysis(true);
+        for (auto& worker: _workers)
+          worker.use_reference_analysis(true);
+      }
+      else if (sv == "--sniff"sv)
+      {
+        _sniffing = true;
+        _file_type_dispatcher.use_sniffing(true);
+        for (auto& worker: _workers)
+          worker.use_sniffing(true);
+      }
+      else if (sv == "--detect"sv)
+      {
+        _detecting = true;
+        _file_type_dispatcher.use_detection(true);
+        for (auto& worker: _workers)
+          worker.use_detection(true);
+      }
+      else if (sv == "--quantiles"sv)
+      {
+        _quantiles = true;
+        _file_type_dispatcher.use_quantiles(true);
+        for (auto& worker: _workers)
+          worker.use_quantiles(true);
+      }
+      else if (sv == "--no-batch"sv)
+      {
+        _batching = false;
+        _file_type_dispatcher.use_batching(false);
+        for (auto& worker: _workers)
+          worker.use_batching(false);
+      }
+      else if (sv == "--no-ignore"sv)
+      {
+        _use_ignore_files = false;
+      }
+      else if (sv == "--native-walk"sv)
+      {
+        if (!native_walk_supported())
+          throw runtime_error("--native-walk is not supported on this platform");
+        _native_walk = true;
+      }
       else if (sv.starts_with("-X"sv))
       {
-        _excluded_folders.emplace(sv.substr(2));
+        _exclusions.add(sv.substr(2));
         _exclude_next_path = false;
       }
+      else if (sv.starts_with("-j"sv))
+      {
+        _set_jobs(sv.substr(2));
+        _jobs_next = false;
+      }
       else if (_exclude_next_path)
       {
-        _excluded_folders.emplace(sv);
+        _exclusions.add(sv);
         _exclude_next_path = false;
       }
+      else if (_jobs_next)
+      {
+        _jobs_next = false;
+        _set_jobs(sv);
+      }
       else if (fs::path path = arg; fs::is_directory(path))
       {
-        // Count for relative excluded paths.
-        std::vector<fs::path> accumulated;
-        for (auto& excl_path: _excluded_folders)
-          if (!excl_path.is_absolute())
-            accumulated.emplace_back(path / excl_path);
-
-        _excluded_folders.insert(
-            std::move_iterator(accumulated.begin()),
-            std::move_iterator(accumulated.end()));
-
-        // Depth-first search for accumulated files.
-        std::vector<fs::path> stack{path};
-        do
-        {
-          fs::path cur_path = std::move(stack.back());
-          stack.pop_back();
-          if (_excluded_folders.contains(cur_path))
-            continue;
+        auto root = _exclusions.root(path);
+        if (root.excluded)
+          return;
+
+        _start_pipeline();
+
+        // Depth-first search for accumulated files: each worker goes depth-first
+        // on its own deque, idle workers steal the oldest (the largest) tasks.
+        if (_native_walk)
+          _run_walk<Native_task>({ make_shared<Directory_handle const>(std::move(path)), {},
+                                   unknown_file_size, true, std::move(root.state), {} });
+        else
+          _run_walk<Walk_task>({ std::move(path), true, std::move(root.state), {} });
+      }
+      else if (!_exclusions.excludes(path))
+      {
+        _start_pipeline();
+        if (!_process_file(0, path))
+          throw File_error("file type was not recognized successfully, the file was ignored", path);
+      }
+    }
+
+
+    /// @brief Start the pipeline if it was requested and has not been started yet.
+    void _start_pipeline()
+    {
+      // How many files are read at once by io_uring.
+      constexpr unsigned io_uring_depth = 128;
 
-          run_and_report_exception([this, &cur_path, &stack]
+      if (_use_pipeline && !_pipeline)
+        _pipeline = make_unique<File_pipeline>(_file_type_dispatcher, _jobs, _jobs, 256, _use_io_uring ? io_uring_depth : 0,
+            _reference_analysis ? Analysis_mode::reference : Analysis_mode::fused, _quantiles);
+    }
+
+
+    /// @brief        Process a source file directly or pass it to the pipeline.
+    /// @param worker the index of the worker
+    /// @param path   path to the file
+    /// @return       true if the file type was found, false otherwise
+    bool _process_file(size_t worker, fs::path const& path)
+    {
+      if (!_pipeline)
+        return _dispatcher(worker)(path);
+
+      // Sniffing and detection are done by the walkers, so the skipped files do not reach the reading stage.
+      auto& dispatcher = _dispatcher(worker);
+      auto  type       = dispatcher.find(path);
+      if (!type)
+        type = dispatcher.detect(path);
+      if (type && !(_sniffing && dispatcher.skip(sniff_file(path))))
+        _pipeline->submit(path, type);
+      return static_cast<bool>(type);
+    }
+
+
+    /// @brief      Run the directory traversal on the pool of _jobs workers.
+    /// @tparam     Task Walk_task or Native_task
+    /// @param root the task listing the root directory
+    template <typename Task>
+    void _run_walk(Task root)
+    {
+      Work_stealing_pool<Task> pool(_jobs);
+      pool.push(0, std::move(root));
+      pool.run([this, &pool](size_t worker, Task& task)
+        {
+          run_and_report_exception([this, &pool, worker, &task]
             {
-              for (fs::directory_iterator it(cur_path), end; it != end; ++it)
-              {
-                run_and_report_exception([this, &entry = *it, &stack]
-                {
-                  fs::path entry_path = entry.path();
-                  if (_excluded_folders.contains(entry_path))
-                    return;
-                  if (entry.is_regular_file())
-                    _file_type_dispatcher(entry.path());
-                  else if (entry.is_directory())
-                    stack.emplace_back(std::move(entry_path));
-                });
-              }
+              _walk(pool, worker, task);
             });
-        } while (!stack.empty());
+        });
+    }
+
+
+    /// @brief        Process a file or list a directory pushing its entries as new tasks.
+    /// @param pool   the pool running the task
+    /// @param worker the index of the worker running the task
+    /// @param task   the task to be done
+    void _walk(Work_stealing_pool<Walk_task>& pool, size_t worker, Walk_task& task)
+    {
+      if (!task.is_directory)
+      {
+        _process_file(worker, task.path);
+        return;
       }
-      else if (!_excluded_folders.contains(path))
+
+      std::vector<Listed_entry> entries;
+      unsigned                  rule_sources = 0;
+      for (fs::directory_iterator it(task.path), end; it != end; ++it)
       {
-        if (!_file_type_dispatcher(path))
-          throw File_error("file type was not recognized successfully, the file was ignored", path);
+        run_and_report_exception([this, &entry = *it, &entries, &rule_sources]
+          {
+            auto name = entry.path().filename().string();
+            if (entry.is_regular_file())
+            {
+              if (_list_file(name, rule_sources))
+                entries.push_back({ std::move(name) });
+            }
+            else if (entry.is_directory())
+            {
+              _list_directory(name, rule_sources);
+              entries.push_back({ std::move(name), unknown_file_size, true });
+            }
+          });
+      }
+
+      _push_entries(task, entries, rule_sources,
+          [&task](String const& name)
+          {
+            return read_file_to_memory(task.path / name);
+          },
+          [&pool, worker, &task](Listed_entry& entry, Exclusion_matcher::State exclusion, Ignore_state ignore)
+          {
+            pool.push(worker, { task.path / entry.name, entry.is_directory, std::move(exclusion), std::move(ignore) });
+          });
+    }
+
+
+    /// @brief        Process a file or list a directory pushing its entries as new tasks (native walker).
+    /// Paths are built only for the directories and the pipeline.
+    /// @param pool   the pool running the task
+    /// @param worker the index of the worker running the task
+    /// @param task   the task to be done
+    void _walk(Work_stealing_pool<Native_task>& pool, size_t worker, Native_task& task)
+    {
+      if (!task.is_directory)
+      {
+        if (_pipeline)
+        {
+          _process_file(worker, task.parent->path() / task.name);
+          return;
+        }
+
+        auto&      dispatcher = _dispatcher(worker);
+        auto const type       = dispatcher.find(String_view{ task.name });
+        if (!type)
+        {
+          // Only the detection candidates are listed without the type.
+          dispatcher(task.parent->path() / task.name);
+          return;
+        }
+
+        if (_sniffing && dispatcher.skip(sniff_file_at(*task.parent, task.name)))
+          return;
+
+        auto const stream     = [&task, &dispatcher, type]
+          {
+            dispatcher.accumulate(type, File_type_dispatcher::analyze_stream(type, 
+                task.parent->path() / task.name, dispatcher.analysis_mode(), dispatcher.quantiles()));
+          };
+
+        if (_streaming)
+          return stream();
+
+        try
+        {
+          if (_memory_mapping)
+          {
+            dispatcher.process(type, map_file_at(*task.parent, task.name,
+                File_type_dispatcher::padding_bytes, File_type_dispatcher::maximal_file_size));
+          }
+          else if (!dispatcher.batching() || !dispatcher.add_to_batch(type, [&task](File_batch& batch)
+                     { return read_file_to_batch_at(*task.parent, task.name, batch, task.size); }))
+          {
+            auto buffer = read_file_at(*task.parent, task.name, dispatcher.buffers(), task.size,
+                File_type_dispatcher::padding_bytes, File_type_dispatcher::maximal_file_size);
+            dispatcher.process(type, *buffer);
+          }
+        }
+        catch (File_too_big const&)
+        {
+          stream();
+        }
+        return;
+      }
+
+      auto const dir = task.name.empty() ? std::move(task.parent)
+                     : make_shared<Directory_handle const>(std::move(task.parent), task.name);
+
+      std::vector<Listed_entry> entries;
+      unsigned                  rule_sources = 0;
+      list_directory(*dir, {
+          .on_file = [&](String_view name, uintmax_t size)
+            {
+              if (_list_file(name, rule_sources))
+                entries.push_back({ String{ name }, size });
+            },
+          .on_directory = [&](String_view name)
+            {
+              _list_directory(name, rule_sources);
+              entries.push_back({ String{ name }, unknown_file_size, true });
+            },
+        });
+
+      _push_entries(task, entries, rule_sources,
+          [this, worker, &dir](String const& name)
+          {
+            return File_data{ *read_file_at(*dir, name, _dispatcher(worker).buffers()) };
+          },
+          [&pool, worker, &dir](Listed_entry& entry, Exclusion_matcher::State exclusion, Ignore_state ignore)
+          {
+            pool.push(worker, { dir, std::move(entry.name), entry.size, entry.is_directory, 
+                                std::move(exclusion), std::move(ignore) });
+          });
+    }
+
+
+    /// @brief              Check if a listed file is to be kept as a directory entry, note the ignore files.
+    /// @param name         the file name
+    /// @param rule_sources the ignore rule sources of the directory
+    /// @return             true if the file is a recognized source file (or its type may be detected)
+    bool _list_file(String_view name, unsigned& rule_sources) const
+    {
+      if (_use_ignore_files)
+        rule_sources |= Ignore_state::rule_source_bit(name);
+
+      return _file_type_dispatcher.find(name)
+          || (_detecting && File_type_dispatcher::is_detection_candidate(name));
+    }
+
+
+    /// @brief              Note the .git directory which may contain ignore rules.
+    /// @param name         the directory name
+    /// @param rule_sources the ignore rule sources of the directory
+    void _list_directory(String_view name, unsigned& rule_sources) const
+    {
+      if (_use_ignore_files && name == ".git"sv)
+        rule_sources |= Ignore_state::rule_source_bit(name);
+    }
+
+
+    /// @brief              Load the ignore rules of a directory, push its entries which are not excluded or ignored.
+    /// @param task         the directory task
+    /// @param entries      the directory entries (recognized source files and subdirectories)
+    /// @param rule_sources the ignore rule sources found in the directory
+    /// @param read_file    function reading a file of the directory: read_file(String const& name) -> File_data
+    /// @param push         function pushing a new task: push(entry, exclusion state, ignore state)
+    void _push_entries(
+        auto const&                task,
+        std::vector<Listed_entry>& entries,
+        unsigned                   rule_sources,
+        auto                       read_file,
+        auto                       push
+      )
+    {
+      auto ignore = task.ignore;
+      ignore.load(rule_sources, read_file);
+
+      for (auto& entry: entries)
+      {
+        if (_use_ignore_files && entry.is_directory && entry.name == ".git"sv)
+          continue;
+        if (ignore.ignores(entry.name, entry.is_directory))
+          continue;
+
+        if (!entry.is_directory)
+        {
+          if (!_exclusions.excludes(task.exclusion, entry.name))
+            push(entry, Exclusion_matcher::State{}, Ignore_state{});
+        }
+        else if (auto step = _exclusions.step(task.exclusion, entry.name); !step.excluded)
+        {
+          push(entry, std::move(step.state), ignore.enter(entry.name));
+        }
       }
     }
   };
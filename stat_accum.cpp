@@ -37,20 +37,31 @@ namespace srcstats
   void Statistics_accumulator::print(
       std::ostream& os, 
       std::string_view object, 
-      std::string_view value
+      std::string_view value,
+      Quantile_sketch const* quantiles
     ) const
   {
-    std::string output[5]
+    static constexpr double percentiles[] { 50, 90, 99, 99.9 };
+
+    std::string output[13]
     {
       "total ",
       "total ",
       "max ",
       "min ",
-      "average "
+      "average ",
+      "p50 ",
+      "p90 ",
+      "p99 ",
+      "p99.9 ",
+      "q50 ",
+      "q90 ",
+      "q99 ",
+      "q99.9 "
     };
 
     output[0] += object;
-    for (int i = 1; i < 5; ++i)
+    for (int i = 1; i < 13; ++i)
       output[i] += value;
 
     auto const width = srcstats::max(output[0].size(), output[4].size()) + 1;
@@ -62,6 +73,13 @@ namespace srcstats
     os << output[2] << "= " << max()     << '\n';
     os << output[3] << "= " << min()     << '\n';
     os << output[4] << "= " << average() << '\n';
+    for (int i = 0; i < 4; ++i)
+      os << output[5 + i] << "= " << percentile(percentiles[i]) << '\n';
+
+    // The sketch percentiles are not rounded up to histogram buckets, their ranks are estimated.
+    if (quantiles != nullptr)
+      for (int i = 0; i < 4; ++i)
+        os << output[9 + i] << "= " << quantiles->percentile(percentiles[i]) << '\n';
   }
 
 }
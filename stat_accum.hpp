@@ -28,15 +28,94 @@ SOFTWARE.
 #ifndef SRCSTATS_STAT_ACCUM_HPP_INCLUDED
 #define SRCSTATS_STAT_ACCUM_HPP_INCLUDED
 
-#include "basic.hpp"
+#include "quantile_sketch.hpp"
 
+#include <array>
+#include <bit>
+#include <limits>
 #include <ostream>
 
 
 namespace srcstats
 {
 
-  /// @brief Accumulate basic statistics of size_t values (total sum, minimal and maximal values).
+  /// @brief Count size_t values in log-linear buckets (the HDR histogram way): values below 32 have buckets 
+  /// of their own, each next range of a power of two is split into 16 equal buckets, so a bucket is narrower 
+  /// than 1/16 of its values. Values not less than 2^32 are counted in the last bucket. 
+  /// The memory is fixed, histograms are merged by adding their bucket counts.
+  class Log_histogram
+  {
+  public:
+    static constexpr int    sub_bucket_bits = 4;
+    static constexpr int    value_bits      = 32;
+    static constexpr size_t bucket_count    = size_t(value_bits - sub_bucket_bits + 1) << sub_bucket_bits;
+
+    /// @brief Get the index of the bucket counting the value.
+    [[nodiscard]] static constexpr size_t bucket(size_t value) noexcept
+    {
+      // The low bits are set, so the highest bit is found without checking for zero.
+      constexpr auto exact = (size_t(1) << (sub_bucket_bits + 1)) - 1;
+      value = srcstats::min(value, (size_t(1) << value_bits) - 1);
+      auto const shift = (std::numeric_limits<size_t>::digits - 1 - std::countl_zero(value | exact)) - sub_bucket_bits;
+      return (size_t(shift) << sub_bucket_bits) + (value >> shift);
+    }
+
+    /// @brief Get the least value of the bucket.
+    [[nodiscard]] static constexpr size_t bucket_low(size_t index) noexcept
+    {
+      auto const shift = srcstats::max(index >> sub_bucket_bits, size_t(1)) - 1;
+      return (index - (shift << sub_bucket_bits)) << shift;
+    }
+
+    /// @brief Get the greatest value of the bucket.
+    [[nodiscard]] static constexpr size_t bucket_high(size_t index) noexcept
+    {
+      return bucket_low(index + 1) - 1;
+    }
+
+
+    /// @brief Get how many values the bucket has counted.
+    [[nodiscard]] constexpr size_t count(size_t index) const noexcept
+    {
+      return _counts[index];
+    }
+
+    /// @brief      Find the bucket of the value of the given rank among the counted values sorted ascending.
+    /// @param rank the rank, 1 for the least value (the last bucket is taken if it exceeds the count of values)
+    /// @return     the greatest value of the bucket
+    [[nodiscard]] constexpr size_t value_at_rank(size_t rank) const noexcept
+    {
+      size_t index = 0;
+      for (size_t counted = 0; index + 1 < bucket_count; ++index)
+        if ((counted += _counts[index]) >= rank)
+          break;
+
+      return bucket_high(index);
+    }
+
+
+    /// @brief Count the next value.
+    constexpr Log_histogram& operator()(size_t value) noexcept
+    {
+      ++_counts[bucket(value)];
+      return *this;
+    }
+
+    /// @brief Add the counts of another histogram.
+    constexpr Log_histogram& operator()(Log_histogram const& other) noexcept
+    {
+      for (size_t i = 0; i < bucket_count; ++i)
+        _counts[i] += other._counts[i];
+      return *this;
+    }
+
+  private:
+    std::array<size_t, bucket_count> _counts {};
+  };
+
+
+  /// @brief Accumulate basic statistics of size_t values (total sum, minimal and maximal values) 
+  /// and their histogram for percentiles.
   class Statistics_accumulator
   {
   public:
@@ -72,12 +151,32 @@ namespace srcstats
       return static_cast<double>(total()) / count();
     }
 
+    /// @brief   Get the value not exceeded by the given percentage of the accumulated values (0 if there are none).
+    /// It is the greatest value of its histogram bucket (so it is exact below 32 and within 1/16 above), 
+    /// clamped to the minimal and maximal values.
+    /// @param p the percentage from 0 to 100
+    [[nodiscard]] constexpr size_t percentile(double p) const noexcept
+    {
+      auto const exact = p / 100 * static_cast<double>(count());
+      auto       rank  = static_cast<size_t>(exact);
+      rank += rank < exact || rank == 0;
+      return srcstats::max(min(), srcstats::min(_histogram.value_at_rank(rank), max()));
+    }
+
+    /// @brief Get the histogram of the accumulated values.
+    [[nodiscard]] constexpr Log_histogram const& histogram() const noexcept
+    {
+      return _histogram;
+    }
+
 
-    /// @brief        Output statistics to an output stream.
-    /// @param os     the destination output stream
-    /// @param object what objects were being counted
-    /// @param value  what are the values accumulated
-    void print(std::ostream& os, std::string_view object, std::string_view value) const;
+    /// @brief           Output statistics to an output stream.
+    /// @param os        the destination output stream
+    /// @param object    what objects were being counted
+    /// @param value     what are the values accumulated
+    /// @param quantiles the sketch of the same values, if not null its percentiles are output too
+    void print(std::ostream& os, std::string_view object, std::string_view value, 
+               Quantile_sketch const* quantiles = nullptr) const;
 
 
     // Mutators
@@ -89,6 +188,7 @@ namespace srcstats
       _min_v = srcstats::min(_min_v, value);
       _max_v = srcstats::max(_max_v, value);
       _total += value;
+      _histogram(value);
       return *this;
     }
 
@@ -96,17 +196,19 @@ namespace srcstats
     constexpr Statistics_accumulator& operator()(Statistics_accumulator const& stats) noexcept
     {
       _count += stats.count();
-      _min_v = srcstats::min(_min_v, stats.min());
+      _min_v = srcstats::min(_min_v, stats._min_v); // stats.min() is 0 if stats is empty
       _max_v = srcstats::max(_max_v, stats.max());
       _total += stats.total();
+      _histogram(stats._histogram);
       return *this;
     }
 
   private:
-    size_t    _count = 0;
-    size_t    _min_v = ~size_t(0);
-    size_t    _max_v = 0;
-    uintmax_t _total = 0;
+    size_t        _count = 0;
+    size_t        _min_v = ~size_t(0);
+    size_t        _max_v = 0;
+    uintmax_t     _total = 0;
+    Log_histogram _histogram;
   };
 
 }
@@ -0,0 +1,143 @@
+/******************************************************************************
+MIT License
+
+Copyright (c) 2024 Dmitry R. Kuvshinov
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+******************************************************************************/
+
+/// @file   decomment_test.cpp
+/// @brief  Differential test of the decommenters: the whole text lexers at every instruction set level and
+/// the resumable streams given random chunks are compared with the frozen hand-written decommenters 
+/// (see reference_decomment.hpp) on random sources.
+/// @author D.R.Kuvshinov kuvshinovdr at yandex.ru
+#include "../langs/cpp/cpp_decomment.hpp"
+#include "../langs/cs/cs_decomment.hpp"
+#include "reference_decomment.hpp"
+
+#include <iostream>
+#include <random>
+
+
+namespace srcstats
+{
+
+  /// @brief Random sources built of the characters and tokens the lexers care about.
+  class Source_generator
+  {
+  public:
+    explicit Source_generator(unsigned seed)
+      : _random(seed) {}
+
+    [[nodiscard]] String operator()(size_t max_size)
+    {
+      static constexpr String_view tokens[]
+      {
+        "/"sv, "*"sv, "//"sv, "/*"sv, "*/"sv, "\""sv, "'"sv, "\\"sv, "\n"sv, "R"sv, "R\""sv, "("sv, ")"sv, 
+        "\"\"\""sv, "\"\""sv, "x"sv, "d"sv, " "sv, "\t"sv, "R\"d("sv, ")d\""sv, "R\"(", ")\""sv, "code;"sv,
+      };
+
+      String text;
+      for (auto size = _random() % (max_size + 1); text.size() < size;)
+        text += tokens[_random() % std::size(tokens)];
+      return text;
+    }
+
+    /// @brief Split a size into random chunk sizes (from one to all the characters).
+    [[nodiscard]] std::vector<size_t> chunks(size_t size)
+    {
+      std::vector<size_t> result;
+      auto const max_chunk = size_t(1) << (_random() % 8);
+      while (size != 0)
+      {
+        auto const chunk = std::min(size, 1 + _random() % max_chunk);
+        result.push_back(chunk);
+        size -= chunk;
+      }
+      return result;
+    }
+
+  private:
+    std::mt19937 _random;
+  };
+
+
+  template <class Decommenter, class... Options>
+  [[nodiscard]] String decomment(String_view text, Options... options)
+  {
+    String padded(text);
+    padded.append(2, characters::NUL);
+    String out(text.size(), characters::NUL);
+    out.resize(static_cast<size_t>(Decommenter(padded.data(), text.size(), options...).to(out.data()) - out.data()));
+    return out;
+  }
+
+
+  template <Lexer_rules const& rules>
+  [[nodiscard]] String decomment_by_chunks(String_view text, std::vector<size_t> const& chunks, Simd_level level)
+  {
+    Decomment_lexer_stream<rules> stream(level);
+    String out(text.size() + chunks.size() + 1, characters::NUL);
+    auto   end = out.data();
+    for (size_t at = 0; auto const size: chunks)
+    {
+      end = stream(text.substr(at, size), end);
+      at += size;
+    }
+
+    out.resize(static_cast<size_t>(stream.finish(end) - out.data()));
+    return out;
+  }
+
+
+  template <Lexer_rules const& rules, class Reference>
+  [[nodiscard]] bool test_language(std::string_view name, size_t count)
+  {
+    Source_generator generate(12345);
+    for (size_t i = 0; i < count; ++i)
+    {
+      auto const text     = generate(i % 2 == 0 ? 64 : 1024);
+      auto const chunks   = generate.chunks(text.size());
+      auto const expected = decomment<Reference>(text);
+      for (auto level = 0; level <= static_cast<int>(simd_level()); ++level)
+      {
+        auto const simd = static_cast<Simd_level>(level);
+        if (decomment<Decomment_lexer<rules>>(text, simd) != expected 
+         || decomment_by_chunks<rules>(text, chunks, simd) != expected)
+        {
+          std::cerr << name << " decommenting differs (" << simd_level_name(simd) << ") on:\n" << text << '\n';
+          return false;
+        }
+      }
+    }
+
+    std::cout << name << ": " << count << " sources passed\n";
+    return true;
+  }
+
+}
+
+
+int main()
+{
+  using namespace srcstats;
+  bool const passed = test_language<cpp_lexer_rules, reference::Cpp_decomment>("C++"sv, 200'000) 
+                    & test_language<cs_lexer_rules, reference::Cs_decomment>("C#"sv, 200'000);
+  return passed ? 0 : 1;
+}
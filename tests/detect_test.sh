@@ -0,0 +1,41 @@
+#!/bin/sh
+# Checks that --detect gives the same statistics whatever the thread count and the processing mode are:
+# weakly detected files are accepted by the confident detections of their directories, which may be 
+# processed before or after them by any thread.
+# Usage: tests/detect_test.sh path/to/srcstats
+
+set -e
+
+SRCSTATS=$1
+TREE=$(mktemp -d)
+trap 'rm -rf "$TREE"' EXIT
+
+for d in $(seq 1 40); do
+  dir="$TREE/d$d"
+  mkdir -p "$dir"
+  for f in $(seq 1 8); do
+    printf '#include <vector>\n#define SIZE %d\nint f%d() { return SIZE; }\ntemplate <class T> T g%d();\n' \
+      "$f" "$f" "$f" > "$dir/weak$f"
+  done
+  # Every other directory has a confidently detected file, sorted before or after the weak ones.
+  if [ $((d % 2)) -eq 0 ]; then
+    name=$([ $((d % 4)) -eq 0 ] && echo aaa || echo zzz)
+    printf '// -*- C++ -*-\nint main() {}\n' > "$dir/$name"
+  fi
+done
+
+run() {
+  "$SRCSTATS" --detect "$@" "$TREE" | sed '/^Time elapsed/,$d'
+}
+
+EXPECTED=$(run -j1)
+for args in "-j2" "-j4" "-j8" "--pipeline -j4" "--native-walk -j3"; do
+  for repeat in 1 2 3; do
+    if [ "$(run $args)" != "$EXPECTED" ]; then
+      echo "--detect $args differs from -j1"
+      exit 1
+    fi
+  done
+done
+
+echo "--detect: the same statistics at every thread count"
@@ -0,0 +1,36 @@
+#!/bin/sh
+# Checks that the statistics do not depend on the thread count and the walking mode: 
+# the repository sources and a generated tree are processed with -j1 and several -jN.
+# Usage: tests/jobs_test.sh path/to/srcstats
+
+set -e
+
+SRCSTATS=$1
+TREE=$(mktemp -d)
+trap 'rm -rf "$TREE"' EXIT
+
+# Small and large files, CR LF line endings, a generated file and files without extensions.
+for d in $(seq 1 20); do
+  mkdir -p "$TREE/d$d/sub"
+  for f in $(seq 1 30); do
+    printf '// file %d\nint f%d() { return %d; } /* end */\n' "$f" "$f" "$d" > "$TREE/d$d/f$f.cpp"
+    printf 'namespace n%d {\r\n  int g();  \r\n\r\n}\r\n' "$f" > "$TREE/d$d/sub/h$f.hpp"
+  done
+  seq 1 20000 | sed 's/^/int v/; s/$/;/' > "$TREE/d$d/large.cpp"
+  printf '// @generated\nint x;\n' > "$TREE/d$d/gen.cpp"
+  printf '#!/usr/bin/env csharp\nusing System;\n' > "$TREE/d$d/script"
+done
+
+run() {
+  "$SRCSTATS" --sniff --detect "$@" "$TREE" . | grep -v '^Time elapsed' | sed '/^Buffer pools\|^Reading stage/,$d'
+}
+
+EXPECTED=$(run -j1)
+for args in "-j2" "-j4" "-j8" "--native-walk -j4" "--pipeline -j3" "--io-uring -j2" "--mmap -j4" "--stream -j4"; do
+  if [ "$(run $args)" != "$EXPECTED" ]; then
+    echo "$args differs from -j1"
+    exit 1
+  fi
+done
+
+echo "-jN: the same statistics as -j1"
@@ -0,0 +1,73 @@
+/******************************************************************************
+MIT License
+
+Copyright (c) 2024 Dmitry R. Kuvshinov
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+******************************************************************************/
+
+/// @file   reference_trim.hpp
+/// @brief  Frozen copy of the original remove_empty_lines_and_whitespace_endings replaced by copy_trimmed_lines, 
+/// the oracle of trim_test.cpp. The only correction follows is_whitespace: the original compared chars, 
+/// so the bytes of UTF-8 sequences were whitespace too.
+/// @author D.R.Kuvshinov kuvshinovdr at yandex.ru
+#ifndef SRCSTATS_REFERENCE_TRIM_HPP_INCLUDED
+#define SRCSTATS_REFERENCE_TRIM_HPP_INCLUDED
+
+#include "../file.hpp"
+
+#include <algorithm>
+
+
+namespace srcstats::reference
+{
+
+  inline void remove_empty_lines_and_whitespace_endings(File_data& file_data) noexcept
+  {
+    using namespace characters;
+
+    // Corrected: ASCII codes up to SPACE only (the original tested ch <= space and ch > space).
+    auto const is_space = [](char ch) { return static_cast<unsigned char>(ch) <= static_cast<unsigned char>(space); };
+    auto write_pos = file_data.begin(), end = file_data.end();
+    for (auto read_pos = write_pos; read_pos != end;)
+    {
+      // Select next line.
+      auto line_begin = read_pos, lf_pos = std::find(read_pos, end, LF), line_end = lf_pos;
+      // Remove final spaces.
+      while (line_end != line_begin && is_space(*(line_end - 1)))
+        --line_end;
+      // Copy if the line is non-empty.
+      if (line_begin != line_end)
+        write_pos = std::copy(line_begin, line_end, write_pos);
+      // Finish?
+      if (lf_pos == end)
+        break;
+
+      // Find the beginning of the next line.
+      read_pos = std::find_if_not(lf_pos, end, is_space);
+      if (read_pos != end)
+        *write_pos++ = LF;
+    }
+
+    file_data.erase(write_pos, end);
+  }
+
+}
+
+#endif//SRCSTATS_REFERENCE_TRIM_HPP_INCLUDED
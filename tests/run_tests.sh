@@ -0,0 +1,39 @@
+#!/bin/sh
+# Builds every tests/*_test.cpp against the library sources and runs it, then builds srcstats
+# and runs every tests/*_test.sh passing it the program path.
+# Usage: tests/run_tests.sh [extra compiler flags]
+# CXX defaults to g++; the sources need C++23.
+
+set -e
+cd "$(dirname "$0")/.."
+
+CXX=${CXX:-g++}
+OUT=${TMPDIR:-/tmp}/srcstats_tests
+mkdir -p "$OUT"
+
+SOURCES=$(ls *.cpp langs/*/*.cpp | grep -v '^srcstats\.cpp$')
+FAILED=0
+
+for test in tests/*_test.cpp; do
+  name=$(basename "$test" .cpp)
+  $CXX -std=c++23 -O2 -pthread "$@" -o "$OUT/$name" "$test" $SOURCES
+  if "$OUT/$name"; then
+    echo "$name: passed"
+  else
+    echo "$name: FAILED"
+    FAILED=1
+  fi
+done
+
+$CXX -std=c++23 -O2 -pthread "$@" -o "$OUT/srcstats" $(ls *.cpp langs/*/*.cpp)
+for test in tests/*_test.sh; do
+  name=$(basename "$test" .sh)
+  if sh "$test" "$OUT/srcstats"; then
+    echo "$name: passed"
+  else
+    echo "$name: FAILED"
+    FAILED=1
+  fi
+done
+
+exit $FAILED
@@ -0,0 +1,153 @@
+/******************************************************************************
+MIT License
+
+Copyright (c) 2024 Dmitry R. Kuvshinov
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+******************************************************************************/
+
+/// @file   trim_test.cpp
+/// @brief  Differential test of line trimming: the copy_trimmed_lines kernels are compared with the original 
+/// line by line trimming (see reference_trim.hpp), and the trimmed File_statistics_stream given random chunks 
+/// is compared with the statistics of the whole trimmed text on random whitespace-heavy texts.
+/// @author D.R.Kuvshinov kuvshinovdr at yandex.ru
+#include "../file_stat.hpp"
+#include "../text_simd.hpp"
+#include "reference_trim.hpp"
+
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <vector>
+
+
+namespace srcstats
+{
+
+  /// @brief Random texts of whitespace, line feeds and ASCII or UTF-8 characters.
+  class Text_generator
+  {
+  public:
+    explicit Text_generator(unsigned seed)
+      : _random(seed) {}
+
+    [[nodiscard]] String operator()(size_t max_size)
+    {
+      static constexpr String_view tokens[]
+      {
+        " "sv, "  "sv, "\t"sv, "\r"sv, "\n"sv, "\n\n"sv, "\r\n"sv, "\v"sv, "x"sv, "code;"sv, 
+        "\xC3\xA9"sv, "\xE2\x82\xAC"sv, "\xF0\x9F\x98\x80"sv, "\x80"sv, "        "sv,
+      };
+
+      String text;
+      for (auto size = _random() % (max_size + 1); text.size() < size;)
+        text += tokens[_random() % std::size(tokens)];
+      return text;
+    }
+
+    /// @brief Split a size into random chunk sizes (from one to all the characters).
+    [[nodiscard]] std::vector<size_t> chunks(size_t size)
+    {
+      std::vector<size_t> result;
+      auto const max_chunk = size_t(1) << (_random() % 9);
+      while (size != 0)
+      {
+        auto const chunk = std::min(size, 1 + _random() % max_chunk);
+        result.push_back(chunk);
+        size -= chunk;
+      }
+      return result;
+    }
+
+  private:
+    std::mt19937 _random;
+  };
+
+
+  [[nodiscard]] String trim(String_view text, Simd_level level)
+  {
+    String out(text.size(), characters::NUL);
+    out.resize(static_cast<size_t>(copy_trimmed_lines(text, out.data(), level) - out.data()));
+    return out;
+  }
+
+
+  [[nodiscard]] std::string to_string(File_statistics const& stats)
+  {
+    std::ostringstream os;
+    stats.print(os);
+    return os.str();
+  }
+
+
+  [[nodiscard]] std::string trimmed_statistics_by_chunks(String_view text, std::vector<size_t> const& chunks)
+  {
+    File_statistics stats;
+    File_statistics_stream stream(stats, true);
+    for (size_t at = 0; auto const size: chunks)
+    {
+      stream(text.substr(at, size));
+      at += size;
+    }
+
+    stream.finish();
+    return to_string(stats);
+  }
+
+
+  [[nodiscard]] bool test_trimming(size_t count)
+  {
+    Text_generator generate(54321);
+    for (size_t i = 0; i < count; ++i)
+    {
+      auto const text = generate(i % 2 == 0 ? 64 : 1024);
+      auto expected   = File_data(text);
+      reference::remove_empty_lines_and_whitespace_endings(expected);
+      for (auto level = 0; level <= static_cast<int>(simd_level()); ++level)
+      {
+        auto const simd = static_cast<Simd_level>(level);
+        auto in_place = text;
+        in_place.resize(static_cast<size_t>(copy_trimmed_lines(in_place, in_place.data(), simd) - in_place.data()));
+        if (trim(text, simd) != expected || in_place != expected)
+        {
+          std::cerr << "Trimming differs (" << simd_level_name(simd) << ") on:\n" << text << '\n';
+          return false;
+        }
+      }
+
+      File_statistics whole;
+      whole(expected);
+      if (trimmed_statistics_by_chunks(text, generate.chunks(text.size())) != to_string(whole))
+      {
+        std::cerr << "Trimmed statistics by chunks differ on:\n" << text << '\n';
+        return false;
+      }
+    }
+
+    std::cout << "Trimming: " << count << " texts passed\n";
+    return true;
+  }
+
+}
+
+
+int main()
+{
+  return srcstats::test_trimming(200'000) ? 0 : 1;
+}
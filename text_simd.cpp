@@ -0,0 +1,1406 @@
+/******************************************************************************
+MIT License
+
+Copyright (c) 2024 Dmitry R. Kuvshinov
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+******************************************************************************/
+/// @file   text_simd.cpp
+/// @brief  Vectorized text scanning and transforms, text_simd.hpp implementation.
+/// @author D.R.Kuvshinov kuvshinovdr at yandex.ru
+
+#include "text_simd.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstring>
+
+#if (defined(__GNUC__) || defined(__clang__)) && defined(__x86_64__)
+#define SRCSTATS_HAS_X86_SIMD 1
+#include <immintrin.h>
+#endif
+
+
+namespace srcstats
+{
+
+  using namespace characters;
+
+  namespace
+  {
+
+    /// @brief The scalar version of find_control.
+    [[nodiscard]] size_t find_control_scalar(Character const* text, size_t size) noexcept
+    {
+      auto const pos = std::find_if(text, text + size, [](Character ch) { return is_control(ch); });
+      return pos == text + size ? NPOS : static_cast<size_t>(pos - text);
+    }
+
+    /// @brief The scalar version of copy_without_control (out may be equal to text).
+    Character* copy_without_control_scalar(Character const* text, size_t size, Character* out) noexcept
+    {
+      for (auto const end = text + size; text != end; ++text)
+        if (!is_control(*text))
+          *out++ = *text;
+      return out;
+    }
+
+
+    /// @brief The scalar version of find_any_of.
+    [[nodiscard]] size_t find_any_of_scalar(Character const* text, size_t size, Four_characters const& chars) noexcept
+    {
+      for (size_t i = 0; i < size; ++i)
+        if (auto const ch = text[i]; ch == chars[0] || ch == chars[1] || ch == chars[2] || ch == chars[3])
+          return i;
+      return NPOS;
+    }
+
+    /// @brief Find the first unescaped term character, escaped tells if the first character is escaped.
+    [[nodiscard]] size_t find_unescaped_from(Character const* text, size_t size, Character term, bool escaped) noexcept
+    {
+      for (size_t i = escaped; i < size; ++i)
+      {
+        if (text[i] == term)
+          return i;
+        i += text[i] == backslash;
+      }
+      return NPOS;
+    }
+
+    /// @brief The scalar version of find_unescaped.
+    [[nodiscard]] size_t find_unescaped_scalar(Character const* text, size_t size, Character term) noexcept
+    {
+      return find_unescaped_from(text, size, term, false);
+    }
+
+    /// @brief Shift a position found in the rest of the text starting at from.
+    [[nodiscard]] constexpr size_t found_after(size_t from, size_t pos) noexcept
+    {
+      return pos == NPOS ? NPOS : from + pos;
+    }
+
+    /// @brief        Get the mask of the characters escaped by odd runs of backslashes (the simdjson way).
+    /// @param bs     the mask of the backslashes of a 64 byte block
+    /// @param carry  1 if the first character of the block is escaped, it is set for the next block
+    [[nodiscard]] constexpr uint64_t escaped_characters(uint64_t bs, uint64_t& carry) noexcept
+    {
+      constexpr uint64_t odd_bits = 0xAAAA'AAAA'AAAA'AAAA;
+
+      // Subtracting the run starts from the odd bits flips the parity of each run at its end.
+      auto const potential_escape    = bs & ~carry;
+      auto const series_codes        = (potential_escape << 1 | odd_bits) - potential_escape;
+      auto const escape_and_terminal = series_codes ^ odd_bits;
+      auto const escaped             = escape_and_terminal ^ (bs | carry);
+      carry = (escape_and_terminal & bs) >> 63;
+      return escaped;
+    }
+
+
+    /// @brief Bit masks of the UTF-8 byte classes of a 64 byte block: the bytes not less than the thresholds
+    /// (as unsigned) and the lead bytes restricting the range of their second bytes.
+    struct Utf8_classes
+    {
+      uint64_t ge80, ge90, geA0, geC0, geC2, geE0, geF0, geF5;
+      uint64_t e0, ed, f0, f4;
+    };
+
+
+    /// @brief Finds the bytes continuing UTF-8 characters in 64 byte blocks given by their class masks 
+    /// (the same bytes Utf8_decoder finds one by one). The masks of the previous block are kept, 
+    /// so the sequences crossing the block boundary are continued.
+    class Utf8_continuations
+    {
+    public:
+      /// @brief Continue the sequence the decoder has started.
+      explicit constexpr Utf8_continuations(Utf8_decoder const& decoder) noexcept
+      {
+        // A byte of the previous block starting the same expectation is put to its last position.
+        constexpr auto last = uint64_t(1) << 63;
+        switch (decoder.expected)
+        {
+        case 1: 
+          _lead2 = last; 
+          break;
+        case 2: 
+          (decoder.low == 0xA0 ? _e0 : decoder.high == 0x9F ? _ed : _lead3) = last;
+          break;
+        case 3: 
+          (decoder.low == 0x90 ? _f0 : decoder.high == 0x8F ? _f4 : _lead4) = last;
+          break;
+        default:
+          break;
+        }
+      }
+
+      /// @brief Get the decoder state after the last block.
+      [[nodiscard]] constexpr Utf8_decoder decoder() const noexcept
+      {
+        Utf8_decoder result;
+        if (((_lead2 | _second3 | _third4) >> 63) != 0)
+          result.expected = 1;
+        else if (((_e0 | _ed | _lead3 | _second4) >> 63) != 0)
+          result.start(_e0 >> 63 ? 0xE0 : _ed >> 63 ? 0xED : 0xE1);
+        else if (((_f0 | _f4 | _lead4) >> 63) != 0)
+          result.start(_f0 >> 63 ? 0xF0 : _f4 >> 63 ? 0xF4 : 0xF1);
+        return result;
+      }
+
+      /// @brief Take a block without non-ASCII bytes, it has no continuation bytes.
+      constexpr uint64_t ascii() noexcept
+      {
+        *this = Utf8_continuations(Utf8_decoder{});
+        return 0;
+      }
+
+      /// @brief   Take the next block.
+      /// @param c the class masks of the block
+      /// @return  the mask of the bytes continuing characters
+      [[gnu::always_inline]] constexpr uint64_t operator()(Utf8_classes const& c) noexcept
+      {
+        auto const cont   = c.ge80 & ~c.geC0;
+        auto const lead2  = c.geC2 & ~c.geE0;
+        auto const lead3  = c.geE0 & ~c.geF0 & ~c.e0 & ~c.ed;
+        auto const lead4  = c.geF0 & ~c.geF5 & ~c.f0 & ~c.f4;
+
+        auto const second2 = cont & _after(lead2, _lead2);
+        auto const second3 = (cont & _after(lead3, _lead3))
+                           | (c.geA0 & ~c.geC0 & _after(c.e0, _e0))
+                           | (cont & ~c.geA0 & _after(c.ed, _ed));
+        auto const second4 = (cont & _after(lead4, _lead4))
+                           | (c.ge90 & ~c.geC0 & _after(c.f0, _f0))
+                           | (cont & ~c.ge90 & _after(c.f4, _f4));
+        auto const third3  = cont & _after(second3, _second3);
+        auto const third4  = cont & _after(second4, _second4);
+        auto const fourth  = cont & _after(third4, _third4);
+
+        _lead2   = lead2;
+        _lead3   = lead3;
+        _e0      = c.e0;
+        _ed      = c.ed;
+        _lead4   = lead4;
+        _f0      = c.f0;
+        _f4      = c.f4;
+        _second3 = second3;
+        _second4 = second4;
+        _third4  = third4;
+        return second2 | second3 | second4 | third3 | third4 | fourth;
+      }
+
+    private:
+      // The masks of the previous block.
+      uint64_t _lead2 = 0, _lead3 = 0, _e0 = 0, _ed = 0, _lead4 = 0, _f0 = 0, _f4 = 0;
+      uint64_t _second3 = 0, _second4 = 0, _third4 = 0;
+
+      /// @brief The mask of the bytes following the bytes of the mask (the last byte of the previous block included).
+      [[nodiscard]] static constexpr uint64_t _after(uint64_t mask, uint64_t previous) noexcept
+      {
+        return mask << 1 | previous >> 63;
+      }
+    };
+
+
+    /// @brief Find the first byte above 0x7F in text[from, size) (8 bytes at a time), size if there is none.
+    [[nodiscard]] inline size_t find_non_ascii(Character const* text, size_t from, size_t size) noexcept
+    {
+      for (; from + 8 <= size; from += 8)
+      {
+        uint64_t word;
+        std::memcpy(&word, text + from, 8);
+        if ((word & 0x8080'8080'8080'8080) != 0)
+          break;
+      }
+
+      while (from < size && static_cast<unsigned char>(text[from]) < 0x80)
+        ++from;
+      return from;
+    }
+
+
+    /// @brief The line lengths met (in characters, see Utf8_decoder) and the character position 
+    /// of the current line start (it wraps around if the line started before the text).
+    struct Line_splitter
+    {
+      Statistics_accumulator lengths;
+      size_t                 start     = 0;
+      size_t                 skipped   = 0;       // the count of the bytes continuing characters before the current position
+      Utf8_decoder           decoder;             // the state before the current position
+      Quantile_sketch*       quantiles = nullptr; // the lengths are put here too if it is not null
+
+      /// @brief Take the length of the next line.
+      [[gnu::always_inline]] void line(size_t length) noexcept
+      {
+        lengths(length);
+        if (quantiles != nullptr)
+          (*quantiles)(length);
+      }
+
+      /// @brief Take the LF positions and the bytes continuing characters of a block given by the bit masks.
+      [[gnu::always_inline]] void operator()(uint64_t lf_mask, size_t block, uint64_t continued) noexcept
+      {
+        // The line start is kept in a local: the histogram counts stored may alias the members.
+        auto line_start = start;
+        block -= skipped;
+        if (continued == 0)
+        {
+          for (; lf_mask != 0; lf_mask &= lf_mask - 1)
+          {
+            auto const pos = block + std::countr_zero(lf_mask);
+            line(pos - line_start);
+            line_start = pos + 1;
+          }
+        }
+        else
+        {
+          for (; lf_mask != 0; lf_mask &= lf_mask - 1)
+          {
+            auto const bit = std::countr_zero(lf_mask);
+            auto const pos = block + bit - std::popcount(continued & ((uint64_t(1) << bit) - 1));
+            line(pos - line_start);
+            line_start = pos + 1;
+          }
+
+          skipped += std::popcount(continued);
+        }
+
+        start = line_start;
+      }
+
+      /// @brief Take the LF positions of text[from, size) found one by one, the bytes between them are decoded.
+      void operator()(Character const* text, size_t from, size_t size) noexcept
+      {
+        // The state is kept in locals: the stores to the text type may alias the members.
+        // The lines before the next non-ASCII byte are not decoded.
+        String_view const rest { text, size };
+        auto state     = decoder;
+        auto count     = skipped;
+        auto non_ascii = find_non_ascii(text, from, size);
+        for (size_t to; from < size; from = to + 1)
+        {
+          to = min(rest.find(LF, from), size);
+          if (to <= non_ascii)
+          {
+            state = {};
+          }
+          else
+          {
+            for (auto i = from; i < to; ++i)
+              count += state.continues(text[i]);
+            non_ascii = find_non_ascii(text, to, size);
+          }
+
+          if (to == size)
+            break;
+
+          state = {};
+          line(to - count - start);
+          start = to - count + 1;
+        }
+
+        decoder = state;
+        skipped = count;
+      }
+    };
+
+    /// @brief The scalar version of accumulate_lines.
+    [[nodiscard]] Line_splitter split_lines_scalar(Character const* text, size_t size, size_t first,
+                                                   Utf8_decoder decoder, Quantile_sketch* quantiles) noexcept
+    {
+      Line_splitter splitter { {}, size_t(0) - first, 0, decoder, quantiles };
+      splitter(text, 0, size);
+      return splitter;
+    }
+
+
+    /// @brief The scalar version of copy_trimmed_lines (out may be equal to text).
+    Character* copy_trimmed_lines_scalar(Character const* text, size_t size, Character* out) noexcept
+    {
+      auto const end = text + size;
+      for (auto read_pos = text; read_pos != end;)
+      {
+        // Select next line.
+        auto line_begin = read_pos, lf_pos = std::find(read_pos, end, LF), line_end = lf_pos;
+        // Remove final spaces.
+        while (line_end != line_begin && is_whitespace(*(line_end - 1)))
+          --line_end;
+        // Copy if the line is non-empty.
+        if (line_begin != line_end)
+        {
+          std::memmove(out, line_begin, static_cast<size_t>(line_end - line_begin));
+          out += line_end - line_begin;
+        }
+        // Finish?
+        if (lf_pos == end)
+          break;
+
+        // Find the beginning of the next line.
+        read_pos = std::find_if_not(lf_pos, end, is_whitespace);
+        if (read_pos != end)
+          *out++ = LF;
+      }
+
+      return out;
+    }
+
+
+    /// @brief Spread the bits of g to the higher bits while they are in p (Kogge-Stone).
+    [[nodiscard]] constexpr uint64_t smear_up(uint64_t g, uint64_t p) noexcept
+    {
+      for (unsigned shift = 1; shift < 64; shift *= 2)
+      {
+        g |= p & (g << shift);
+        p &= p << shift;
+      }
+      return g;
+    }
+
+    /// @brief Spread the bits of g to the lower bits while they are in p (Kogge-Stone).
+    [[nodiscard]] constexpr uint64_t smear_down(uint64_t g, uint64_t p) noexcept
+    {
+      for (unsigned shift = 1; shift < 64; shift *= 2)
+      {
+        g |= p & (g >> shift);
+        p &= p >> shift;
+      }
+      return g;
+    }
+
+
+    /// @brief Selects the bytes copy_trimmed_lines keeps, 64 byte block by block.
+    /// Whitespace is ASCII not greater than space (see is_whitespace). A whitespace run followed by 
+    /// a non-whitespace character is kept if it has no LF, otherwise only its first LF is kept. 
+    /// Runs at the end of the text are removed. A run reaching the end of a block is pending 
+    /// until a non-whitespace character is met. Its part in the next blocks is still in the input 
+    /// (the output never overtakes it), but its first part may be overwritten by the stores of its block, so it is saved.
+    struct Line_trimmer
+    {
+      size_t    pending_start = 0;     // the pending run position in the text
+      size_t    pending_saved = 0;     // how many first characters of the pending run are saved
+      bool      pending       = false;
+      bool      pending_lf    = false; // the pending run has an LF
+      Character saved[64];
+
+      /// @brief           Take the next block given by bit masks, write the pending run if it ends in the block.
+      /// @param text      the text (the pending run is taken from it)
+      /// @param block     the position of the block in the text
+      /// @param data      the block characters (the padded copy of the last block)
+      /// @param nonwhite  the mask of the non-whitespace characters of the block
+      /// @param lf        the mask of LF characters of the block
+      /// @param out       the output position, it is advanced by the pending run written
+      /// @return          the mask of the block characters to be kept
+      [[nodiscard]] uint64_t operator()(Character const* text, size_t block, Character const* data,
+                                        uint64_t nonwhite, uint64_t lf, Character*& out) noexcept
+      {
+        auto const white     = ~nonwhite;
+        auto const carry     = static_cast<uint64_t>(pending_lf);
+        auto const after_lf  = smear_up(lf | (carry & white), white);        // whitespace at or after an LF of its run
+        auto const with_lf   = after_lf | smear_down(lf, white);             // whitespace of the runs having an LF
+        auto const first_lf  = lf & ~(after_lf << 1 | carry);
+        auto const trailing  = nonwhite == 0 ? ~uint64_t(0) 
+                             : ~uint64_t(0) << (63 - std::countl_zero(nonwhite)) << 1;
+
+        if (pending && nonwhite != 0)
+        {
+          if (pending_lf)
+            *out++ = LF;
+          else if ((with_lf & 1) == 0)
+          {
+            out = std::copy_n(saved, pending_saved, out);
+            auto const rest = pending_start + pending_saved;
+            std::memmove(out, text + rest, block - rest);
+            out += block - rest;
+          }
+          pending = false;
+        }
+
+        if (trailing != 0 && !pending)
+        {
+          auto const offset = static_cast<size_t>(std::countr_zero(trailing));
+          pending       = true;
+          pending_start = block + offset;
+          pending_saved = 64 - offset;
+          std::copy_n(data + offset, pending_saved, saved);
+        }
+
+        pending_lf = pending && (after_lf >> 63) != 0;
+        return (nonwhite | (white & ~with_lf) | first_lf) & ~trailing;
+      }
+    };
+
+
+    /// @brief Write the UTF-8 bytes of the code point.
+    [[nodiscard]] constexpr Character* put_code_point(char32_t code, Character* out) noexcept
+    {
+      auto const put = [&out](char32_t byte) { *out++ = static_cast<Character>(byte); };
+      if (code < 0x80)
+      {
+        put(code);
+      }
+      else if (code < 0x800)
+      {
+        put(0xC0 | code >> 6);
+        put(0x80 | (code & 0x3F));
+      }
+      else if (code < 0x10000)
+      {
+        put(0xE0 | code >> 12);
+        put(0x80 | (code >> 6 & 0x3F));
+        put(0x80 | (code & 0x3F));
+      }
+      else
+      {
+        put(0xF0 | code >> 18);
+        put(0x80 | (code >> 12 & 0x3F));
+        put(0x80 | (code >> 6 & 0x3F));
+        put(0x80 | (code & 0x3F));
+      }
+      return out;
+    }
+
+    /// @brief Write the UTF-8 bytes of the UTF-16 code unit, a surrogate pair is written after its low surrogate.
+    /// @param high the preceding high surrogate (0 if none), it is set if the unit is a high surrogate
+    [[nodiscard]] constexpr Character* put_code_unit(char16_t unit, char16_t& high, Character* out) noexcept
+    {
+      bool const is_high = 0xD800 <= unit && unit < 0xDC00, is_low = 0xDC00 <= unit && unit < 0xE000;
+      if (high != 0)
+      {
+        if (is_low)
+        {
+          auto const code = 0x10000 + ((char32_t(high) - 0xD800) << 10) + (char32_t(unit) - 0xDC00);
+          high = 0;
+          return put_code_point(code, out);
+        }
+
+        high = 0;
+        out  = std::copy(utf8_replacement.begin(), utf8_replacement.end(), out);
+      }
+
+      if (is_high)
+        high = unit;
+      else if (is_low)
+        out = std::copy(utf8_replacement.begin(), utf8_replacement.end(), out);
+      else
+        out = put_code_point(unit, out);
+      return out;
+    }
+
+    /// @brief The scalar version of utf16_to_utf8 (size is even).
+    Character* utf16_to_utf8_scalar(Character const* text, size_t size, bool big_endian, 
+                                    Character* out, char16_t& high) noexcept
+    {
+      for (size_t i = 0; i < size; i += 2)
+      {
+        auto const first = static_cast<unsigned char>(text[i]), second = static_cast<unsigned char>(text[i + 1]);
+        out = put_code_unit(static_cast<char16_t>(big_endian ? first << 8 | second : second << 8 | first), high, out);
+      }
+      return out;
+    }
+
+
+#if defined(SRCSTATS_HAS_X86_SIMD)
+
+    /// @brief Shuffle indices moving the bytes of an 8 byte group selected by the bit mask to its beginning.
+    constexpr auto compaction_table = []
+      {
+        std::array<std::array<unsigned char, 8>, 256> table {};
+        for (unsigned mask = 0; mask < 256; ++mask)
+        {
+          unsigned char count = 0;
+          for (unsigned char i = 0; i < 8; ++i)
+            if (mask & (1u << i))
+              table[mask][count++] = i;
+        }
+        return table;
+      }();
+
+
+    /// @brief Select the control characters: all bytes below space except for TAB and LF.
+    [[gnu::target("sse4.2,popcnt")]] inline __m128i control_bytes(__m128i x) noexcept
+    {
+      auto const below   = _mm_cmpeq_epi8(_mm_min_epu8(x, _mm_set1_epi8(space - 1)), x);
+      auto const allowed = _mm_or_si128(_mm_cmpeq_epi8(x, _mm_set1_epi8(TAB)), _mm_cmpeq_epi8(x, _mm_set1_epi8(LF)));
+      return _mm_andnot_si128(allowed, below);
+    }
+
+    /// @brief Write the bytes of x selected by the 16 bit mask consecutively to out (16 bytes may be written).
+    [[gnu::target("sse4.2,popcnt")]] inline Character* compact(__m128i x, unsigned keep, Character* out) noexcept
+    {
+      auto const low  = keep & 0xFF;
+      auto const high = keep >> 8;
+
+      auto const low_indices  = _mm_loadl_epi64(reinterpret_cast<__m128i const*>(compaction_table[low].data()));
+      auto const high_indices = _mm_add_epi8(_mm_set1_epi8(8),
+          _mm_loadl_epi64(reinterpret_cast<__m128i const*>(compaction_table[high].data())));
+
+      _mm_storel_epi64(reinterpret_cast<__m128i*>(out), _mm_shuffle_epi8(x, low_indices));
+      out += _mm_popcnt_u32(low);
+      _mm_storel_epi64(reinterpret_cast<__m128i*>(out), _mm_shuffle_epi8(x, high_indices));
+      return out + _mm_popcnt_u32(high);
+    }
+
+
+    [[gnu::target("sse4.2,popcnt")]] size_t find_control_sse42(Character const* text, size_t size) noexcept
+    {
+      size_t i = 0;
+      for (; i + 16 <= size; i += 16)
+      {
+        auto const x = _mm_loadu_si128(reinterpret_cast<__m128i const*>(text + i));
+        if (auto const mask = static_cast<unsigned>(_mm_movemask_epi8(control_bytes(x))); mask != 0)
+          return i + std::countr_zero(mask);
+      }
+
+      auto const pos = find_control_scalar(text + i, size - i);
+      return pos == NPOS ? NPOS : i + pos;
+    }
+
+    // A block is loaded before anything is stored, and the output never overtakes the input,
+    // so the stores (as wide as the block) overwrite only the bytes already loaded when the copy is in place.
+    [[gnu::target("sse4.2,popcnt")]] 
+    Character* copy_without_control_sse42(Character const* text, size_t size, Character* out) noexcept
+    {
+      size_t i = 0;
+      for (; i + 16 <= size; i += 16)
+      {
+        auto const x    = _mm_loadu_si128(reinterpret_cast<__m128i const*>(text + i));
+        auto const mask = static_cast<unsigned>(_mm_movemask_epi8(control_bytes(x)));
+        if (mask == 0)
+        {
+          if (out != text + i)
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out), x);
+          out += 16;
+        }
+        else
+        {
+          out = compact(x, ~mask & 0xFFFF, out);
+        }
+      }
+
+      return copy_without_control_scalar(text + i, size - i, out);
+    }
+
+
+    /// @brief Get the bit mask of LF characters of the 16 byte block.
+    [[gnu::target("sse4.2,popcnt")]] inline uint64_t lf_mask_sse42(Character const* block) noexcept
+    {
+      return static_cast<unsigned>(_mm_movemask_epi8(
+          _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<__m128i const*>(block)), _mm_set1_epi8(LF))));
+    }
+
+    /// @brief Get the bit mask of the non-ASCII bytes of the 16 byte block.
+    [[gnu::target("sse4.2,popcnt")]] inline uint64_t non_ascii_mask_sse42(Character const* block) noexcept
+    {
+      return static_cast<unsigned>(_mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<__m128i const*>(block))));
+    }
+
+    /// @brief Get the bit mask of the bytes of the 16 byte block not less than the threshold (above 0x80).
+    /// @param biased the bytes with the sign bit flipped (so the signed comparison compares them as unsigned)
+    [[gnu::target("sse4.2,popcnt")]] inline uint64_t ge_mask_sse42(__m128i biased, unsigned threshold) noexcept
+    {
+      return static_cast<unsigned>(_mm_movemask_epi8(
+          _mm_cmpgt_epi8(biased, _mm_set1_epi8(static_cast<char>((threshold - 1) ^ 0x80)))));
+    }
+
+    /// @brief Get the bit mask of the bytes of the 16 byte block equal to the given one.
+    [[gnu::target("sse4.2,popcnt")]] inline uint64_t byte_mask_sse42(__m128i x, unsigned byte) noexcept
+    {
+      return static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(x, _mm_set1_epi8(static_cast<char>(byte)))));
+    }
+
+    /// @brief Get the UTF-8 class masks of the 64 byte block.
+    [[gnu::target("sse4.2,popcnt")]] inline Utf8_classes utf8_classes_sse42(Character const* block) noexcept
+    {
+      Utf8_classes c {};
+      for (unsigned i = 0; i < 64; i += 16)
+      {
+        auto const x      = _mm_loadu_si128(reinterpret_cast<__m128i const*>(block + i));
+        auto const biased = _mm_xor_si128(x, _mm_set1_epi8(static_cast<char>(0x80)));
+        c.ge80 |= uint64_t(static_cast<unsigned>(_mm_movemask_epi8(x))) << i;
+        c.ge90 |= ge_mask_sse42(biased, 0x90) << i;
+        c.geA0 |= ge_mask_sse42(biased, 0xA0) << i;
+        c.geC0 |= ge_mask_sse42(biased, 0xC0) << i;
+        c.geC2 |= ge_mask_sse42(biased, 0xC2) << i;
+        c.geE0 |= ge_mask_sse42(biased, 0xE0) << i;
+        c.geF0 |= ge_mask_sse42(biased, 0xF0) << i;
+        c.geF5 |= ge_mask_sse42(biased, 0xF5) << i;
+        c.e0   |= byte_mask_sse42(x, 0xE0) << i;
+        c.ed   |= byte_mask_sse42(x, 0xED) << i;
+        c.f0   |= byte_mask_sse42(x, 0xF0) << i;
+        c.f4   |= byte_mask_sse42(x, 0xF4) << i;
+      }
+      return c;
+    }
+
+    [[gnu::target("sse4.2,popcnt")]] 
+    [[nodiscard]] Line_splitter split_lines_sse42(Character const* text, size_t size, size_t first,
+                                                  Utf8_decoder decoder, Quantile_sketch* quantiles) noexcept
+    {
+      Line_splitter      splitter { {}, size_t(0) - first, 0, decoder, quantiles };
+      Utf8_continuations continuations(decoder);
+      size_t i = 0;
+      for (; i + 64 <= size; i += 64)
+      {
+        auto const non_ascii = non_ascii_mask_sse42(text + i)       | non_ascii_mask_sse42(text + i + 16) << 16
+                             | non_ascii_mask_sse42(text + i + 32) << 32 | non_ascii_mask_sse42(text + i + 48) << 48;
+        splitter(lf_mask_sse42(text + i)       | lf_mask_sse42(text + i + 16) << 16
+               | lf_mask_sse42(text + i + 32) << 32 | lf_mask_sse42(text + i + 48) << 48, i,
+                 non_ascii == 0 ? continuations.ascii() : continuations(utf8_classes_sse42(text + i)));
+      }
+
+      splitter.decoder = continuations.decoder();
+      splitter(text, i, size);
+      return splitter;
+    }
+
+
+    /// @brief Write the bytes of the 64 byte block selected by the mask consecutively to out (64 bytes may be written).
+    [[gnu::target("sse4.2,popcnt")]] inline Character* compact_block_sse42(Character const* block, uint64_t keep, Character* out) noexcept
+    {
+      for (unsigned i = 0; i < 64; i += 16, keep >>= 16)
+        out = compact(_mm_loadu_si128(reinterpret_cast<__m128i const*>(block + i)), keep & 0xFFFF, out);
+      return out;
+    }
+
+    /// @brief Get the bit masks of the non-whitespace characters (see is_whitespace) and of LF characters of the 64 byte block.
+    [[gnu::target("sse4.2,popcnt")]] 
+    inline void line_masks_sse42(Character const* block, uint64_t& nonwhite, uint64_t& lf) noexcept
+    {
+      nonwhite = lf = 0;
+      for (unsigned i = 0; i < 64; i += 16)
+      {
+        auto const x = _mm_loadu_si128(reinterpret_cast<__m128i const*>(block + i));
+        nonwhite |= uint64_t(static_cast<unsigned>(_mm_movemask_epi8(
+                        _mm_or_si128(_mm_cmpgt_epi8(x, _mm_set1_epi8(space)), x)))) << i;
+        lf       |= uint64_t(static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(x, _mm_set1_epi8(LF))))) << i;
+      }
+    }
+
+    [[gnu::target("sse4.2,popcnt")]] 
+    Character* copy_trimmed_lines_sse42(Character const* text, size_t size, Character* out) noexcept
+    {
+      Line_trimmer trimmer;
+      uint64_t nonwhite, lf;
+      size_t i = 0;
+      for (; i + 64 <= size; i += 64)
+      {
+        line_masks_sse42(text + i, nonwhite, lf);
+        auto const keep = trimmer(text, i, text + i, nonwhite, lf, out);
+        if (keep == ~uint64_t(0) && out == text + i)
+          out += 64;
+        else if (keep != 0) // nothing is stored over a pending run
+          out = compact_block_sse42(text + i, keep, out);
+      }
+
+      // The last block is padded with spaces (they are trailing whitespace to be removed).
+      alignas(64) Character tail[64], kept[64];
+      std::fill(std::copy(text + i, text + size, tail), tail + 64, space);
+      line_masks_sse42(tail, nonwhite, lf);
+      auto const keep = trimmer(text, i, tail, nonwhite, lf, out);
+      return std::copy(kept, compact_block_sse42(tail, keep, kept), out);
+    }
+
+
+    [[gnu::target("avx2,popcnt")]] inline unsigned control_mask_avx2(__m256i x) noexcept
+    {
+      auto const below   = _mm256_cmpeq_epi8(_mm256_min_epu8(x, _mm256_set1_epi8(space - 1)), x);
+      auto const allowed = _mm256_or_si256(_mm256_cmpeq_epi8(x, _mm256_set1_epi8(TAB)), 
+                                           _mm256_cmpeq_epi8(x, _mm256_set1_epi8(LF)));
+      return static_cast<unsigned>(_mm256_movemask_epi8(_mm256_andnot_si256(allowed, below)));
+    }
+
+    [[gnu::target("avx2,popcnt")]] size_t find_control_avx2(Character const* text, size_t size) noexcept
+    {
+      size_t i = 0;
+      for (; i + 32 <= size; i += 32)
+      {
+        auto const x = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(text + i));
+        if (auto const mask = control_mask_avx2(x); mask != 0)
+          return i + std::countr_zero(mask);
+      }
+
+      auto const pos = find_control_sse42(text + i, size - i);
+      return pos == NPOS ? NPOS : i + pos;
+    }
+
+    [[gnu::target("avx2,popcnt")]] 
+    Character* copy_without_control_avx2(Character const* text, size_t size, Character* out) noexcept
+    {
+      size_t i = 0;
+      for (; i + 32 <= size; i += 32)
+      {
+        auto const x    = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(text + i));
+        auto const mask = control_mask_avx2(x);
+        if (mask == 0)
+        {
+          if (out != text + i)
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(out), x);
+          out += 32;
+        }
+        else
+        {
+          out = compact(_mm256_castsi256_si128(x),      ~mask & 0xFFFF, out);
+          out = compact(_mm256_extracti128_si256(x, 1), ~mask >> 16,    out);
+        }
+      }
+
+      return copy_without_control_sse42(text + i, size - i, out);
+    }
+
+
+    /// @brief Get the bit mask of LF characters of the 32 byte block.
+    [[gnu::target("avx2,popcnt")]] inline uint64_t lf_mask_avx2(Character const* block) noexcept
+    {
+      return static_cast<unsigned>(_mm256_movemask_epi8(
+          _mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<__m256i const*>(block)), _mm256_set1_epi8(LF))));
+    }
+
+    /// @brief Get the bit mask of the non-ASCII bytes of the 32 byte block.
+    [[gnu::target("avx2,popcnt")]] inline uint64_t non_ascii_mask_avx2(Character const* block) noexcept
+    {
+      return static_cast<unsigned>(_mm256_movemask_epi8(_mm256_loadu_si256(reinterpret_cast<__m256i const*>(block))));
+    }
+
+    /// @brief Get the bit mask of the bytes of the 32 byte block not less than the threshold (above 0x80).
+    /// @param biased the bytes with the sign bit flipped (so the signed comparison compares them as unsigned)
+    [[gnu::target("avx2,popcnt")]] inline uint64_t ge_mask_avx2(__m256i biased, unsigned threshold) noexcept
+    {
+      return static_cast<unsigned>(_mm256_movemask_epi8(
+          _mm256_cmpgt_epi8(biased, _mm256_set1_epi8(static_cast<char>((threshold - 1) ^ 0x80)))));
+    }
+
+    /// @brief Get the bit mask of the bytes of the 32 byte block equal to the given one.
+    [[gnu::target("avx2,popcnt")]] inline uint64_t byte_mask_avx2(__m256i x, unsigned byte) noexcept
+    {
+      return static_cast<unsigned>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(x, _mm256_set1_epi8(static_cast<char>(byte)))));
+    }
+
+    /// @brief Get the UTF-8 class masks of the 64 byte block.
+    [[gnu::target("avx2,popcnt")]] inline Utf8_classes utf8_classes_avx2(Character const* block) noexcept
+    {
+      Utf8_classes c {};
+      for (unsigned i = 0; i < 64; i += 32)
+      {
+        auto const x      = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(block + i));
+        auto const biased = _mm256_xor_si256(x, _mm256_set1_epi8(static_cast<char>(0x80)));
+        c.ge80 |= uint64_t(static_cast<unsigned>(_mm256_movemask_epi8(x))) << i;
+        c.ge90 |= ge_mask_avx2(biased, 0x90) << i;
+        c.geA0 |= ge_mask_avx2(biased, 0xA0) << i;
+        c.geC0 |= ge_mask_avx2(biased, 0xC0) << i;
+        c.geC2 |= ge_mask_avx2(biased, 0xC2) << i;
+        c.geE0 |= ge_mask_avx2(biased, 0xE0) << i;
+        c.geF0 |= ge_mask_avx2(biased, 0xF0) << i;
+        c.geF5 |= ge_mask_avx2(biased, 0xF5) << i;
+        c.e0   |= byte_mask_avx2(x, 0xE0) << i;
+        c.ed   |= byte_mask_avx2(x, 0xED) << i;
+        c.f0   |= byte_mask_avx2(x, 0xF0) << i;
+        c.f4   |= byte_mask_avx2(x, 0xF4) << i;
+      }
+      return c;
+    }
+
+    [[gnu::target("avx2,popcnt")]] 
+    [[nodiscard]] Line_splitter split_lines_avx2(Character const* text, size_t size, size_t first,
+                                                 Utf8_decoder decoder, Quantile_sketch* quantiles) noexcept
+    {
+      Line_splitter      splitter { {}, size_t(0) - first, 0, decoder, quantiles };
+      Utf8_continuations continuations(decoder);
+      size_t i = 0;
+      for (; i + 64 <= size; i += 64)
+      {
+        auto const non_ascii = non_ascii_mask_avx2(text + i) | non_ascii_mask_avx2(text + i + 32) << 32;
+        splitter(lf_mask_avx2(text + i) | lf_mask_avx2(text + i + 32) << 32, i,
+                 non_ascii == 0 ? continuations.ascii() : continuations(utf8_classes_avx2(text + i)));
+      }
+
+      splitter.decoder = continuations.decoder();
+      splitter(text, i, size);
+      return splitter;
+    }
+
+
+    [[gnu::target("avx2,popcnt")]] 
+    inline void line_masks_avx2(Character const* block, uint64_t& nonwhite, uint64_t& lf) noexcept
+    {
+      nonwhite = lf = 0;
+      for (unsigned i = 0; i < 64; i += 32)
+      {
+        auto const x = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(block + i));
+        nonwhite |= uint64_t(static_cast<unsigned>(_mm256_movemask_epi8(
+                        _mm256_or_si256(_mm256_cmpgt_epi8(x, _mm256_set1_epi8(space)), x)))) << i;
+        lf       |= uint64_t(static_cast<unsigned>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(x, _mm256_set1_epi8(LF))))) << i;
+      }
+    }
+
+    [[gnu::target("avx2,popcnt")]] 
+    Character* copy_trimmed_lines_avx2(Character const* text, size_t size, Character* out) noexcept
+    {
+      Line_trimmer trimmer;
+      uint64_t nonwhite, lf;
+      size_t i = 0;
+      for (; i + 64 <= size; i += 64)
+      {
+        line_masks_avx2(text + i, nonwhite, lf);
+        auto const keep = trimmer(text, i, text + i, nonwhite, lf, out);
+        if (keep == ~uint64_t(0) && out == text + i)
+          out += 64;
+        else if (keep != 0) // nothing is stored over a pending run
+          out = compact_block_sse42(text + i, keep, out);
+      }
+
+      alignas(64) Character tail[64], kept[64];
+      std::fill(std::copy(text + i, text + size, tail), tail + 64, space);
+      line_masks_avx2(tail, nonwhite, lf);
+      auto const keep = trimmer(text, i, tail, nonwhite, lf, out);
+      return std::copy(kept, compact_block_sse42(tail, keep, kept), out);
+    }
+
+
+    [[gnu::target("avx512f,avx512bw,avx512vbmi2,popcnt")]] inline __mmask64 control_mask_avx512(__m512i x) noexcept
+    {
+      auto const below   = _mm512_cmple_epu8_mask(x, _mm512_set1_epi8(space - 1));
+      auto const allowed = _mm512_cmpeq_epi8_mask(x, _mm512_set1_epi8(TAB)) 
+                         | _mm512_cmpeq_epi8_mask(x, _mm512_set1_epi8(LF));
+      return below & ~allowed;
+    }
+
+    [[gnu::target("avx512f,avx512bw,avx512vbmi2,popcnt")]] 
+    size_t find_control_avx512(Character const* text, size_t size) noexcept
+    {
+      size_t i = 0;
+      for (; i + 64 <= size; i += 64)
+      {
+        auto const x = _mm512_loadu_si512(text + i);
+        if (auto const mask = control_mask_avx512(x); mask != 0)
+          return i + std::countr_zero(mask);
+      }
+
+      auto const pos = find_control_avx2(text + i, size - i);
+      return pos == NPOS ? NPOS : i + pos;
+    }
+
+    [[gnu::target("avx512f,avx512bw,avx512vbmi2,popcnt")]] 
+    Character* copy_without_control_avx512(Character const* text, size_t size, Character* out) noexcept
+    {
+      size_t i = 0;
+      for (; i + 64 <= size; i += 64)
+      {
+        auto const x    = _mm512_loadu_si512(text + i);
+        auto const mask = control_mask_avx512(x);
+        if (mask == 0)
+        {
+          if (out != text + i)
+            _mm512_storeu_si512(out, x);
+          out += 64;
+        }
+        else
+        {
+          _mm512_storeu_si512(out, _mm512_maskz_compress_epi8(~mask, x));
+          out += _mm_popcnt_u64(~mask);
+        }
+      }
+
+      return copy_without_control_avx2(text + i, size - i, out);
+    }
+
+
+    /// @brief Get the UTF-8 class masks of the 64 byte block.
+    [[gnu::target("avx512f,avx512bw,avx512vbmi2,popcnt")]] inline Utf8_classes utf8_classes_avx512(__m512i x) noexcept
+    {
+      return {
+          _mm512_movepi8_mask(x),
+          _mm512_cmpge_epu8_mask(x, _mm512_set1_epi8(static_cast<char>(0x90))),
+          _mm512_cmpge_epu8_mask(x, _mm512_set1_epi8(static_cast<char>(0xA0))),
+          _mm512_cmpge_epu8_mask(x, _mm512_set1_epi8(static_cast<char>(0xC0))),
+          _mm512_cmpge_epu8_mask(x, _mm512_set1_epi8(static_cast<char>(0xC2))),
+          _mm512_cmpge_epu8_mask(x, _mm512_set1_epi8(static_cast<char>(0xE0))),
+          _mm512_cmpge_epu8_mask(x, _mm512_set1_epi8(static_cast<char>(0xF0))),
+          _mm512_cmpge_epu8_mask(x, _mm512_set1_epi8(static_cast<char>(0xF5))),
+          _mm512_cmpeq_epi8_mask(x, _mm512_set1_epi8(static_cast<char>(0xE0))),
+          _mm512_cmpeq_epi8_mask(x, _mm512_set1_epi8(static_cast<char>(0xED))),
+          _mm512_cmpeq_epi8_mask(x, _mm512_set1_epi8(static_cast<char>(0xF0))),
+          _mm512_cmpeq_epi8_mask(x, _mm512_set1_epi8(static_cast<char>(0xF4))),
+        };
+    }
+
+    [[gnu::target("avx512f,avx512bw,avx512vbmi2,popcnt")]] 
+    [[nodiscard]] Line_splitter split_lines_avx512(Character const* text, size_t size, size_t first,
+                                                   Utf8_decoder decoder, Quantile_sketch* quantiles) noexcept
+    {
+      Line_splitter      splitter { {}, size_t(0) - first, 0, decoder, quantiles };
+      Utf8_continuations continuations(decoder);
+      size_t i = 0;
+      for (; i + 64 <= size; i += 64)
+      {
+        auto const x = _mm512_loadu_si512(text + i);
+        splitter(_mm512_cmpeq_epi8_mask(x, _mm512_set1_epi8(LF)), i,
+                 _mm512_movepi8_mask(x) == 0 ? continuations.ascii() : continuations(utf8_classes_avx512(x)));
+      }
+
+      splitter.decoder = continuations.decoder();
+      splitter(text, i, size);
+      return splitter;
+    }
+
+
+    /// @brief Write the bytes of the block selected by the mask consecutively to out (64 bytes may be written).
+    [[gnu::target("avx512f,avx512bw,avx512vbmi2,popcnt")]] 
+    inline Character* compact_block_avx512(__m512i x, uint64_t keep, Character* out) noexcept
+    {
+      _mm512_storeu_si512(out, _mm512_maskz_compress_epi8(keep, x));
+      return out + _mm_popcnt_u64(keep);
+    }
+
+    [[gnu::target("avx512f,avx512bw,avx512vbmi2,popcnt")]] 
+    Character* copy_trimmed_lines_avx512(Character const* text, size_t size, Character* out) noexcept
+    {
+      auto const spaces = _mm512_set1_epi8(space), lfs = _mm512_set1_epi8(LF);
+
+      Line_trimmer trimmer;
+      size_t i = 0;
+      for (; i + 64 <= size; i += 64)
+      {
+        auto const x    = _mm512_loadu_si512(text + i);
+        auto const keep = trimmer(text, i, text + i, 
+                                  _mm512_cmpgt_epu8_mask(x, spaces), _mm512_cmpeq_epi8_mask(x, lfs), out);
+        if (keep == ~uint64_t(0) && out == text + i)
+          out += 64;
+        else if (keep != 0) // nothing is stored over a pending run
+          out = compact_block_avx512(x, keep, out);
+      }
+
+      // The last block is padded with spaces (they are trailing whitespace to be removed).
+      alignas(64) Character tail[64], kept[64];
+      auto const rest = i == size ? uint64_t(0) : ~uint64_t(0) >> (64 - (size - i));
+      auto const x    = _mm512_mask_loadu_epi8(spaces, rest, text + i);
+      _mm512_store_si512(tail, x);
+      auto const keep = trimmer(text, i, tail, 
+                                _mm512_cmpgt_epu8_mask(x, spaces), _mm512_cmpeq_epi8_mask(x, lfs), out);
+      return std::copy(kept, compact_block_avx512(x, keep, kept), out);
+    }
+
+
+    /// @brief Get the bit mask of the given character in the 64 byte block.
+    [[gnu::target("sse4.2,popcnt")]] inline uint64_t eq_mask_sse42(Character const* block, Character ch) noexcept
+    {
+      uint64_t mask = 0;
+      for (unsigned i = 0; i < 64; i += 16)
+      {
+        auto const x = _mm_loadu_si128(reinterpret_cast<__m128i const*>(block + i));
+        mask |= uint64_t(static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(x, _mm_set1_epi8(ch))))) << i;
+      }
+      return mask;
+    }
+
+    /// @brief Get the bit mask of any of the characters in the 64 byte block.
+    [[gnu::target("sse4.2,popcnt")]] 
+    inline uint64_t any_of_mask_sse42(Character const* block, Four_characters const& chars) noexcept
+    {
+      uint64_t mask = 0;
+      for (unsigned i = 0; i < 64; i += 16)
+      {
+        auto const x  = _mm_loadu_si128(reinterpret_cast<__m128i const*>(block + i));
+        auto const eq = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(x, _mm_set1_epi8(chars[0])), _mm_cmpeq_epi8(x, _mm_set1_epi8(chars[1]))),
+            _mm_or_si128(_mm_cmpeq_epi8(x, _mm_set1_epi8(chars[2])), _mm_cmpeq_epi8(x, _mm_set1_epi8(chars[3]))));
+        mask |= uint64_t(static_cast<unsigned>(_mm_movemask_epi8(eq))) << i;
+      }
+      return mask;
+    }
+
+    [[gnu::target("sse4.2,popcnt")]] 
+    size_t find_any_of_sse42(Character const* text, size_t size, Four_characters const& chars) noexcept
+    {
+      size_t i = 0;
+      for (; i + 64 <= size; i += 64)
+        if (auto const mask = any_of_mask_sse42(text + i, chars); mask != 0)
+          return i + std::countr_zero(mask);
+
+      return found_after(i, find_any_of_scalar(text + i, size - i, chars));
+    }
+
+    [[gnu::target("sse4.2,popcnt")]] 
+    size_t find_unescaped_sse42(Character const* text, size_t size, Character term) noexcept
+    {
+      uint64_t carry = 0;
+      size_t i = 0;
+      for (; i + 64 <= size; i += 64)
+      {
+        auto const escaped = escaped_characters(eq_mask_sse42(text + i, backslash), carry);
+        if (auto const mask = eq_mask_sse42(text + i, term) & ~escaped; mask != 0)
+          return i + std::countr_zero(mask);
+      }
+
+      return found_after(i, find_unescaped_from(text + i, size - i, term, carry != 0));
+    }
+
+
+    [[gnu::target("avx2,popcnt")]] inline uint64_t eq_mask_avx2(Character const* block, Character ch) noexcept
+    {
+      uint64_t mask = 0;
+      for (unsigned i = 0; i < 64; i += 32)
+      {
+        auto const x = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(block + i));
+        mask |= uint64_t(static_cast<unsigned>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(x, _mm256_set1_epi8(ch))))) << i;
+      }
+      return mask;
+    }
+
+    [[gnu::target("avx2,popcnt")]] 
+    inline uint64_t any_of_mask_avx2(Character const* block, Four_characters const& chars) noexcept
+    {
+      uint64_t mask = 0;
+      for (unsigned i = 0; i < 64; i += 32)
+      {
+        auto const x  = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(block + i));
+        auto const eq = _mm256_or_si256(
+            _mm256_or_si256(_mm256_cmpeq_epi8(x, _mm256_set1_epi8(chars[0])), 
+                            _mm256_cmpeq_epi8(x, _mm256_set1_epi8(chars[1]))),
+            _mm256_or_si256(_mm256_cmpeq_epi8(x, _mm256_set1_epi8(chars[2])), 
+                            _mm256_cmpeq_epi8(x, _mm256_set1_epi8(chars[3]))));
+        mask |= uint64_t(static_cast<unsigned>(_mm256_movemask_epi8(eq))) << i;
+      }
+      return mask;
+    }
+
+    [[gnu::target("avx2,popcnt")]] 
+    size_t find_any_of_avx2(Character const* text, size_t size, Four_characters const& chars) noexcept
+    {
+      size_t i = 0;
+      for (; i + 64 <= size; i += 64)
+        if (auto const mask = any_of_mask_avx2(text + i, chars); mask != 0)
+          return i + std::countr_zero(mask);
+
+      return found_after(i, find_any_of_scalar(text + i, size - i, chars));
+    }
+
+    [[gnu::target("avx2,popcnt")]] 
+    size_t find_unescaped_avx2(Character const* text, size_t size, Character term) noexcept
+    {
+      uint64_t carry = 0;
+      size_t i = 0;
+      for (; i + 64 <= size; i += 64)
+      {
+        auto const escaped = escaped_characters(eq_mask_avx2(text + i, backslash), carry);
+        if (auto const mask = eq_mask_avx2(text + i, term) & ~escaped; mask != 0)
+          return i + std::countr_zero(mask);
+      }
+
+      return found_after(i, find_unescaped_from(text + i, size - i, term, carry != 0));
+    }
+
+
+    [[gnu::target("avx512f,avx512bw,avx512vbmi2,popcnt")]] 
+    size_t find_any_of_avx512(Character const* text, size_t size, Four_characters const& chars) noexcept
+    {
+      auto const c0 = _mm512_set1_epi8(chars[0]), c1 = _mm512_set1_epi8(chars[1]), 
+                 c2 = _mm512_set1_epi8(chars[2]), c3 = _mm512_set1_epi8(chars[3]);
+      size_t i = 0;
+      for (; i + 64 <= size; i += 64)
+      {
+        auto const x    = _mm512_loadu_si512(text + i);
+        auto const mask = _mm512_cmpeq_epi8_mask(x, c0) | _mm512_cmpeq_epi8_mask(x, c1) 
+                        | _mm512_cmpeq_epi8_mask(x, c2) | _mm512_cmpeq_epi8_mask(x, c3);
+        if (mask != 0)
+          return i + std::countr_zero(mask);
+      }
+
+      return found_after(i, find_any_of_scalar(text + i, size - i, chars));
+    }
+
+    [[gnu::target("avx512f,avx512bw,avx512vbmi2,popcnt")]] 
+    size_t find_unescaped_avx512(Character const* text, size_t size, Character term) noexcept
+    {
+      auto const backslashes = _mm512_set1_epi8(backslash), terms = _mm512_set1_epi8(term);
+      uint64_t carry = 0;
+      size_t i = 0;
+      for (; i + 64 <= size; i += 64)
+      {
+        auto const x       = _mm512_loadu_si512(text + i);
+        auto const escaped = escaped_characters(_mm512_cmpeq_epi8_mask(x, backslashes), carry);
+        if (auto const mask = _mm512_cmpeq_epi8_mask(x, terms) & ~escaped; mask != 0)
+          return i + std::countr_zero(mask);
+      }
+
+      return found_after(i, find_unescaped_from(text + i, size - i, term, carry != 0));
+    }
+
+
+    /// @brief Shuffle indices swapping the bytes of 16 bit code units.
+    constexpr char byte_swap_indices[16] { 1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14 };
+
+    [[gnu::target("sse4.2,popcnt")]] 
+    Character* utf16_to_utf8_sse42(Character const* text, size_t size, bool big_endian, 
+                                   Character* out, char16_t& high) noexcept
+    {
+      auto const swap      = _mm_loadu_si128(reinterpret_cast<__m128i const*>(byte_swap_indices));
+      auto const non_ascii = _mm_set1_epi16(static_cast<short>(0xFF80));
+
+      size_t i = 0;
+      for (; i + 32 <= size; i += 32)
+      {
+        auto a = _mm_loadu_si128(reinterpret_cast<__m128i const*>(text + i));
+        auto b = _mm_loadu_si128(reinterpret_cast<__m128i const*>(text + i + 16));
+        if (big_endian)
+        {
+          a = _mm_shuffle_epi8(a, swap);
+          b = _mm_shuffle_epi8(b, swap);
+        }
+
+        if (high == 0 && _mm_testz_si128(_mm_or_si128(a, b), non_ascii))
+        {
+          _mm_storeu_si128(reinterpret_cast<__m128i*>(out), _mm_packus_epi16(a, b));
+          out += 16;
+        }
+        else
+        {
+          out = utf16_to_utf8_scalar(text + i, 32, big_endian, out, high);
+        }
+      }
+
+      return utf16_to_utf8_scalar(text + i, size - i, big_endian, out, high);
+    }
+
+    [[gnu::target("avx2,popcnt")]] 
+    Character* utf16_to_utf8_avx2(Character const* text, size_t size, bool big_endian, 
+                                  Character* out, char16_t& high) noexcept
+    {
+      auto const swap      = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<__m128i const*>(byte_swap_indices)));
+      auto const non_ascii = _mm256_set1_epi16(static_cast<short>(0xFF80));
+
+      size_t i = 0;
+      for (; i + 64 <= size; i += 64)
+      {
+        auto a = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(text + i));
+        auto b = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(text + i + 32));
+        if (big_endian)
+        {
+          a = _mm256_shuffle_epi8(a, swap);
+          b = _mm256_shuffle_epi8(b, swap);
+        }
+
+        if (high == 0 && _mm256_testz_si256(_mm256_or_si256(a, b), non_ascii))
+        {
+          // The packing interleaves the 128 bit lanes of a and b.
+          _mm256_storeu_si256(reinterpret_cast<__m256i*>(out), 
+                              _mm256_permute4x64_epi64(_mm256_packus_epi16(a, b), 0xD8));
+          out += 32;
+        }
+        else
+        {
+          out = utf16_to_utf8_scalar(text + i, 64, big_endian, out, high);
+        }
+      }
+
+      return utf16_to_utf8_scalar(text + i, size - i, big_endian, out, high);
+    }
+
+    [[gnu::target("avx512f,avx512bw,avx512vbmi2,popcnt")]] 
+    Character* utf16_to_utf8_avx512(Character const* text, size_t size, bool big_endian, 
+                                    Character* out, char16_t& high) noexcept
+    {
+      auto const non_ascii = _mm512_set1_epi16(static_cast<short>(0xFF80));
+
+      size_t i = 0;
+      for (; i + 64 <= size; i += 64)
+      {
+        auto x = _mm512_loadu_si512(text + i);
+        if (big_endian)
+          x = _mm512_or_si512(_mm512_slli_epi16(x, 8), _mm512_srli_epi16(x, 8));
+
+        if (high == 0 && _mm512_test_epi16_mask(x, non_ascii) == 0)
+        {
+          _mm256_storeu_si256(reinterpret_cast<__m256i*>(out), _mm512_maskz_cvtepi16_epi8(~__mmask32(0), x));
+          out += 32;
+        }
+        else
+        {
+          out = utf16_to_utf8_scalar(text + i, 64, big_endian, out, high);
+        }
+      }
+
+      return utf16_to_utf8_scalar(text + i, size - i, big_endian, out, high);
+    }
+
+
+    /// @brief Detect the best supported level.
+    [[nodiscard]] Simd_level detect_simd_level() noexcept
+    {
+      __builtin_cpu_init();
+      if (__builtin_cpu_supports("avx512bw") && __builtin_cpu_supports("avx512vbmi2"))
+        return Simd_level::avx512;
+      if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("popcnt"))
+        return Simd_level::avx2;
+      if (__builtin_cpu_supports("sse4.2") && __builtin_cpu_supports("popcnt"))
+        return Simd_level::sse42;
+      return Simd_level::scalar;
+    }
+
+#else
+
+    [[nodiscard]] constexpr Simd_level detect_simd_level() noexcept
+    {
+      return Simd_level::scalar;
+    }
+
+#endif
+
+
+    /// @brief Kernels indexed by Simd_level.
+    template <class Kernel>
+    using Kernels = std::array<Kernel*, 4>;
+
+#if defined(SRCSTATS_HAS_X86_SIMD)
+    constexpr Kernels<size_t (Character const*, size_t) noexcept> find_control_kernels
+      { find_control_scalar, find_control_sse42, find_control_avx2, find_control_avx512 };
+
+    constexpr Kernels<Character* (Character const*, size_t, Character*) noexcept> copy_without_control_kernels
+      { copy_without_control_scalar, copy_without_control_sse42, 
+        copy_without_control_avx2,   copy_without_control_avx512 };
+
+    constexpr Kernels<Line_splitter (Character const*, size_t, size_t, Utf8_decoder, Quantile_sketch*) noexcept> split_lines_kernels
+      { split_lines_scalar, split_lines_sse42, split_lines_avx2, split_lines_avx512 };
+
+    constexpr Kernels<Character* (Character const*, size_t, Character*) noexcept> copy_trimmed_lines_kernels
+      { copy_trimmed_lines_scalar, copy_trimmed_lines_sse42, 
+        copy_trimmed_lines_avx2,   copy_trimmed_lines_avx512 };
+
+    constexpr Kernels<size_t (Character const*, size_t, Four_characters const&) noexcept> find_any_of_kernels
+      { find_any_of_scalar, find_any_of_sse42, find_any_of_avx2, find_any_of_avx512 };
+
+    constexpr Kernels<size_t (Character const*, size_t, Character) noexcept> find_unescaped_kernels
+      { find_unescaped_scalar, find_unescaped_sse42, find_unescaped_avx2, find_unescaped_avx512 };
+
+    constexpr Kernels<Character* (Character const*, size_t, bool, Character*, char16_t&) noexcept> utf16_to_utf8_kernels
+      { utf16_to_utf8_scalar, utf16_to_utf8_sse42, utf16_to_utf8_avx2, utf16_to_utf8_avx512 };
+#else
+    constexpr Kernels<size_t (Character const*, size_t) noexcept> find_control_kernels
+      { find_control_scalar, find_control_scalar, find_control_scalar, find_control_scalar };
+
+    constexpr Kernels<Character* (Character const*, size_t, Character*) noexcept> copy_without_control_kernels
+      { copy_without_control_scalar, copy_without_control_scalar, 
+        copy_without_control_scalar, copy_without_control_scalar };
+
+    constexpr Kernels<Line_splitter (Character const*, size_t, size_t, Utf8_decoder, Quantile_sketch*) noexcept> split_lines_kernels
+      { split_lines_scalar, split_lines_scalar, split_lines_scalar, split_lines_scalar };
+
+    constexpr Kernels<Character* (Character const*, size_t, Character*) noexcept> copy_trimmed_lines_kernels
+      { copy_trimmed_lines_scalar, copy_trimmed_lines_scalar, 
+        copy_trimmed_lines_scalar, copy_trimmed_lines_scalar };
+
+    constexpr Kernels<size_t (Character const*, size_t, Four_characters const&) noexcept> find_any_of_kernels
+      { find_any_of_scalar, find_any_of_scalar, find_any_of_scalar, find_any_of_scalar };
+
+    constexpr Kernels<size_t (Character const*, size_t, Character) noexcept> find_unescaped_kernels
+      { find_unescaped_scalar, find_unescaped_scalar, find_unescaped_scalar, find_unescaped_scalar };
+
+    constexpr Kernels<Character* (Character const*, size_t, bool, Character*, char16_t&) noexcept> utf16_to_utf8_kernels
+      { utf16_to_utf8_scalar, utf16_to_utf8_scalar, utf16_to_utf8_scalar, utf16_to_utf8_scalar };
+#endif
+
+    /// @brief Cap the requested level by the supported one.
+    [[nodiscard]] size_t kernel_index(Simd_level level) noexcept
+    {
+      return static_cast<size_t>(std::min(level, simd_level()));
+    }
+
+  }
+
+
+  Simd_level simd_level() noexcept
+  {
+    static Simd_level const level = detect_simd_level();
+    return level;
+  }
+
+
+  std::string_view simd_level_name(Simd_level level) noexcept
+  {
+    switch (level)
+    {
+    case Simd_level::sse42:  return "SSE4.2"sv;
+    case Simd_level::avx2:   return "AVX2"sv;
+    case Simd_level::avx512: return "AVX-512"sv;
+    default:                 return "scalar"sv;
+    }
+  }
+
+
+  size_t find_control(String_view text, Simd_level level) noexcept
+  {
+    return find_control_kernels[kernel_index(level)](text.data(), text.size());
+  }
+
+
+  size_t find_any_of(String_view text, Four_characters const& chars, Simd_level level) noexcept
+  {
+    return find_any_of_kernels[kernel_index(level)](text.data(), text.size(), chars);
+  }
+
+
+  size_t find_unescaped(String_view text, Character term, Simd_level level) noexcept
+  {
+    return find_unescaped_kernels[kernel_index(level)](text.data(), text.size(), term);
+  }
+
+
+  Character* copy_without_control(String_view text, Character* out, Simd_level level) noexcept
+  {
+    // The clean prefix is skipped (in place) or copied as is.
+    auto const pos = find_control(text, level);
+    if (pos == NPOS)
+      return out == text.data() ? out + text.size() : std::copy(text.begin(), text.end(), out);
+
+    if (out != text.data())
+      std::copy_n(text.data(), pos, out);
+
+    return copy_without_control_kernels[kernel_index(level)](text.data() + pos, text.size() - pos, out + pos);
+  }
+
+
+  size_t accumulate_lines(String_view text, Statistics_accumulator& lines, Quantile_sketch* quantiles, size_t first, 
+                          Simd_level level) noexcept
+  {
+    Utf8_decoder decoder;
+    return accumulate_lines(text, lines, quantiles, first, decoder, level);
+  }
+
+
+  size_t accumulate_lines(String_view text, Statistics_accumulator& lines, Quantile_sketch* quantiles, size_t first, 
+                          Utf8_decoder& decoder, Simd_level level) noexcept
+  {
+    auto const splitter = split_lines_kernels[kernel_index(level)](text.data(), text.size(), first, decoder, 
+                                                                   quantiles);
+    lines(splitter.lengths);
+    decoder = splitter.decoder;
+    return text.size() - splitter.skipped - splitter.start;
+  }
+
+
+
+  Character* copy_trimmed_lines(String_view text, Character* out, Simd_level level) noexcept
+  {
+    return copy_trimmed_lines_kernels[kernel_index(level)](text.data(), text.size(), out);
+  }
+
+
+  Character* utf16_to_utf8(String_view text, bool big_endian, Character* out, char16_t& high, Simd_level level) noexcept
+  {
+    return utf16_to_utf8_kernels[kernel_index(level)](text.data(), text.size() & ~size_t(1), big_endian, out, high);
+  }
+
+}
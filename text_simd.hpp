@@ -0,0 +1,135 @@
+/******************************************************************************
+MIT License
+
+Copyright (c) 2024 Dmitry R. Kuvshinov
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+******************************************************************************/
+/// @file   text_simd.hpp
+/// @brief  Vectorized text scanning and transforms with the instruction set chosen at run time.
+/// @author D.R.Kuvshinov kuvshinovdr at yandex.ru
+#ifndef SRCSTATS_TEXT_SIMD_HPP_INCLUDED
+#define SRCSTATS_TEXT_SIMD_HPP_INCLUDED
+
+#include "basic.hpp"
+#include "stat_accum.hpp"
+#include "utf8.hpp"
+
+#include <array>
+
+
+namespace srcstats
+{
+
+  /// @brief Instruction set levels of the vectorized kernels (x86-64 only, other platforms use the scalar ones).
+  enum class Simd_level : unsigned char
+  {
+    scalar,
+    sse42,  // SSE4.2 and POPCNT: 16 bytes per step
+    avx2,   // AVX2: 32 bytes per step
+    avx512, // AVX-512 BW and VBMI2: 64 bytes per step (compress instructions)
+  };
+
+  /// @brief Get the best level supported by the CPU (it is detected once).
+  [[nodiscard]] Simd_level simd_level() noexcept;
+
+  /// @brief Get the level name as it is shown to the user.
+  [[nodiscard]] std::string_view simd_level_name(Simd_level level) noexcept;
+
+
+  /// @brief       Find the first character removed by normalization (see is_control).
+  /// @param text  the text to be searched
+  /// @param level the instruction set to be used (capped by simd_level())
+  /// @return      the position of the character or NPOS if there is none
+  [[nodiscard]] size_t find_control(String_view text, Simd_level level = simd_level()) noexcept;
+
+  /// @brief Up to four characters searched at once (repeat one of them to search for fewer).
+  using Four_characters = std::array<Character, 4>;
+
+  /// @brief       Find the first of the given characters.
+  /// @param text  the text to be searched
+  /// @param chars the characters to be found
+  /// @param level the instruction set to be used (capped by simd_level())
+  /// @return      the position of the character or NPOS if there is none
+  [[nodiscard]] size_t find_any_of(String_view text, Four_characters const& chars, 
+                                   Simd_level level = simd_level()) noexcept;
+
+  /// @brief       Find the first term character not escaped by a backslash (the text starts unescaped).
+  /// A character is escaped if it follows an odd run of backslashes, the runs are found in bit masks of 64 byte blocks.
+  /// @param text  the text to be searched (e.g. the rest of a string literal)
+  /// @param term  the character to be found (not a backslash)
+  /// @param level the instruction set to be used (capped by simd_level())
+  /// @return      the position of the character or NPOS if there is none
+  [[nodiscard]] size_t find_unescaped(String_view text, Character term, Simd_level level = simd_level()) noexcept;
+
+  /// @brief       Copy the text removing the characters removed by normalization (see is_control).
+  /// Blocks without such characters are copied as they are, the others are compacted by shuffles.
+  /// @param text  the source text
+  /// @param out   the destination of at least text.size() bytes, it may be equal to text.data() (in place)
+  /// @param level the instruction set to be used (capped by simd_level())
+  /// @return      pointer to the end of the written data
+  Character* copy_without_control(String_view text, Character* out, Simd_level level = simd_level()) noexcept;
+
+  /// @brief           Accumulate the lengths of the lines of the text terminated by LF.
+  /// The lengths are in UTF-8 characters (see Utf8_decoder). LF positions are taken from bit masks 
+  /// of 64 byte blocks, the bytes continuing characters are found in bit masks of the blocks having 
+  /// non-ASCII bytes. The statistics are kept in registers and written to the accumulator once.
+  /// @param text      the text
+  /// @param lines     the destination accumulator
+  /// @param quantiles if not null, the lengths of the terminated lines are put to this sketch too
+  /// @param first     the length of the beginning of the first line preceding the text (e.g. in the previous chunk)
+  /// @param level     the instruction set to be used (capped by simd_level())
+  /// @return          the length of the last (unterminated) line, it includes first if the text has no LF
+  size_t accumulate_lines(String_view text, Statistics_accumulator& lines, Quantile_sketch* quantiles = nullptr,
+                          size_t first = 0, Simd_level level = simd_level()) noexcept;
+
+  /// @brief           Accumulate the lengths of the lines of a text given by chunks (see accumulate_lines above).
+  /// @param text      the next chunk of the text
+  /// @param lines     the destination accumulator
+  /// @param quantiles if not null, the lengths of the terminated lines are put to this sketch too
+  /// @param first     the length of the beginning of the first line preceding the chunk
+  /// @param decoder   the state of the UTF-8 sequence the previous chunk ends with, it is updated
+  /// @param level     the instruction set to be used (capped by simd_level())
+  /// @return          the length of the last (unterminated) line, it includes first if the chunk has no LF
+  size_t accumulate_lines(String_view text, Statistics_accumulator& lines, Quantile_sketch* quantiles, size_t first, 
+                          Utf8_decoder& decoder, Simd_level level = simd_level()) noexcept;
+
+  /// @brief       Copy the text removing whitespace line endings, empty lines and leading whitespace of all lines
+  /// except for the first one (see remove_empty_lines_and_whitespace_endings).
+  /// Whitespace runs are found in bit masks of 64 byte blocks, the kept bytes are compacted by shuffles.
+  /// @param text  the source text
+  /// @param out   the destination of at least text.size() bytes, it may be equal to text.data() (in place)
+  /// @param level the instruction set to be used (capped by simd_level())
+  /// @return      pointer to the end of the written data
+  Character* copy_trimmed_lines(String_view text, Character* out, Simd_level level = simd_level()) noexcept;
+
+  /// @brief            Transcode UTF-16 code units to UTF-8, unpaired surrogates are replaced with U+FFFD.
+  /// Blocks of ASCII code units are packed to bytes, the others are transcoded one by one.
+  /// @param text       the code units (a trailing odd byte is ignored)
+  /// @param big_endian the byte order of the code units
+  /// @param out        the destination of at least text.size() / 2 * 3 + 3 bytes (may not overlap text)
+  /// @param high       the high surrogate preceding the text (0 if none), it is set to the trailing unpaired one
+  /// @param level      the instruction set to be used (capped by simd_level())
+  /// @return           pointer to the end of the written data
+  Character* utf16_to_utf8(String_view text, bool big_endian, Character* out, char16_t& high,
+                           Simd_level level = simd_level()) noexcept;
+
+}
+
+#endif//SRCSTATS_TEXT_SIMD_HPP_INCLUDED
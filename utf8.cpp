@@ -0,0 +1,109 @@
+/******************************************************************************
+MIT License
+
+Copyright (c) 2024 Dmitry R. Kuvshinov
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+******************************************************************************/
+
+/// @file   utf8.cpp
+/// @brief  Text encodings, utf8.hpp implementation.
+/// @author D.R.Kuvshinov kuvshinovdr at yandex.ru
+
+#include "utf8.hpp"
+#include "text_simd.hpp"
+
+#include <algorithm>
+
+
+namespace srcstats
+{
+
+  using namespace characters;
+
+
+  Character* Utf16_transcoder::operator()(String_view chunk, Character* out) noexcept
+  {
+    if (_odd && !chunk.empty())
+    {
+      Character const unit[2] { _byte, chunk.front() };
+      out  = utf16_to_utf8({ unit, 2 }, _big_endian, out, _high);
+      _odd = false;
+      chunk.remove_prefix(1);
+    }
+
+    out = utf16_to_utf8(chunk, _big_endian, out, _high);
+    if (chunk.size() % 2 != 0)
+    {
+      _odd  = true;
+      _byte = chunk.back();
+    }
+
+    return out;
+  }
+
+
+  Character* Utf16_transcoder::finish(Character* out) noexcept
+  {
+    if (_high != 0)
+      out = std::copy(utf8_replacement.begin(), utf8_replacement.end(), out);
+    if (_odd)
+      out = std::copy(utf8_replacement.begin(), utf8_replacement.end(), out);
+
+    _high = 0;
+    _odd  = false;
+    return out;
+  }
+
+
+  String_view decode_text(String_view input, String& buffer, size_t padding_bytes)
+  {
+    auto const bom = byte_order_mark(input);
+    input.remove_prefix(bom.size);
+    if (bom.encoding == Text_encoding::utf8)
+      return input;
+
+    Utf16_transcoder transcoder(bom.encoding == Text_encoding::utf16be);
+    size_t size = 0;
+    buffer.resize_and_overwrite(Utf16_transcoder::max_output_size(input.size()) + padding_bytes,
+        [&transcoder, input, padding_bytes, &size](Character* out, size_t)
+        {
+          auto const end = transcoder.finish(transcoder(input, out));
+          std::fill_n(end, padding_bytes, NUL);
+          size = static_cast<size_t>(end - out);
+          return size + padding_bytes;
+        });
+
+    buffer.resize(size);
+    return buffer;
+  }
+
+
+  String_view decode_head(String_view head, Character* buffer) noexcept
+  {
+    auto const bom = byte_order_mark(head);
+    head.remove_prefix(bom.size);
+    if (bom.encoding == Text_encoding::utf8)
+      return head;
+
+    Utf16_transcoder transcoder(bom.encoding == Text_encoding::utf16be);
+    return { buffer, transcoder(head, buffer) };
+  }
+
+}
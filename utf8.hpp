@@ -0,0 +1,168 @@
+/******************************************************************************
+MIT License
+
+Copyright (c) 2024 Dmitry R. Kuvshinov
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+******************************************************************************/
+
+/// @file   utf8.hpp
+/// @brief  Text encodings: byte order marks, counting UTF-8 characters, transcoding UTF-16 to UTF-8.
+/// @author D.R.Kuvshinov kuvshinovdr at yandex.ru
+#ifndef SRCSTATS_UTF8_HPP_INCLUDED
+#define SRCSTATS_UTF8_HPP_INCLUDED
+
+#include "basic.hpp"
+
+
+namespace srcstats
+{
+
+  /// @brief Source file encodings (told by the byte order mark, UTF-8 is assumed without it).
+  enum class Text_encoding : unsigned char
+  {
+    utf8,
+    utf16le,
+    utf16be,
+  };
+
+
+  /// @brief The encoding told by a byte order mark and the mark size.
+  struct Byte_order_mark
+  {
+    Text_encoding encoding = Text_encoding::utf8;
+    size_t        size     = 0;   // 0 if there is no mark
+  };
+
+  /// @brief      Detect the byte order mark at the beginning of the text.
+  /// @param text the text (e.g. the head of a file)
+  /// @return     the encoding and the size of the mark (UTF-8 and 0 if there is no mark)
+  [[nodiscard]] constexpr Byte_order_mark byte_order_mark(String_view text) noexcept
+  {
+    if (text.starts_with("\xEF\xBB\xBF"sv))
+      return { Text_encoding::utf8, 3 };
+    if (text.starts_with("\xFF\xFE"sv))
+      return { Text_encoding::utf16le, 2 };
+    if (text.starts_with("\xFE\xFF"sv))
+      return { Text_encoding::utf16be, 2 };
+    return {};
+  }
+
+
+  /// @brief The UTF-8 bytes of U+FFFD REPLACEMENT CHARACTER.
+  constexpr auto utf8_replacement = "\xEF\xBF\xBD"sv;
+
+
+  /// @brief Tells the bytes continuing UTF-8 characters, byte by byte (a character is counted by its other bytes).
+  /// A continuation byte (0x80-0xBF) continues a character if the bytes before it since a lead byte form
+  /// a prefix of a well-formed sequence (Unicode Table 3-7). So a valid text has as many characters as code points, 
+  /// and an invalid one has as many as U+FFFD replacement of maximal subparts gives: each ill-formed byte 
+  /// (e.g. of a legacy 8-bit encoding) and each truncated sequence is one character.
+  struct Utf8_decoder
+  {
+    unsigned char expected = 0;     // how many continuation bytes are expected
+    unsigned char low      = 0x80;  // the range of the next expected byte
+    unsigned char high     = 0xBF;
+
+    /// @brief    Take the next byte.
+    /// @param ch the byte
+    /// @return   true if it continues the current character
+    constexpr bool continues(Character ch) noexcept
+    {
+      auto const byte = static_cast<unsigned char>(ch);
+      if (byte < 0x80)
+      {
+        expected = 0;
+        return false;
+      }
+
+      if (expected != 0 && low <= byte && byte <= high)
+      {
+        --expected;
+        low  = 0x80;
+        high = 0xBF;
+        return true;
+      }
+
+      start(byte);
+      return false;
+    }
+
+    /// @brief      Start a new character with the byte (expect its continuation bytes if it is a lead byte).
+    /// @param byte the byte
+    constexpr void start(unsigned char byte) noexcept
+    {
+      low  = byte == 0xE0 ? 0xA0 : byte == 0xF0 ? 0x90 : 0x80;
+      high = byte == 0xED ? 0x9F : byte == 0xF4 ? 0x8F : 0xBF;
+      expected = byte < 0xC2 ? 0 : byte < 0xE0 ? 1 : byte < 0xF0 ? 2 : byte < 0xF5 ? 3 : 0;
+    }
+  };
+
+
+  /// @brief Transcodes UTF-16 given by chunks of any size to UTF-8 (see utf16_to_utf8).
+  /// A code unit or a surrogate pair split between the chunks is carried to the next chunk.
+  class Utf16_transcoder
+  {
+  public:
+    /// @brief Get the output buffer size sufficient for a chunk of the given size.
+    [[nodiscard]] static constexpr size_t max_output_size(size_t chunk_size) noexcept
+    {
+      return (chunk_size + 3) / 2 * 3 + 3;
+    }
+
+    /// @brief            Start a text.
+    /// @param big_endian the byte order of the code units
+    explicit constexpr Utf16_transcoder(bool big_endian) noexcept
+      : _big_endian(big_endian) {}
+
+    /// @brief       Transcode the next chunk.
+    /// @param chunk the next part of the UTF-16 text
+    /// @param out   the output buffer of at least max_output_size(chunk.size()) bytes (may not overlap chunk)
+    /// @return      pointer to the end of the written data
+    Character* operator()(String_view chunk, Character* out) noexcept;
+
+    /// @brief     Finish the text, an unpaired high surrogate and an odd byte are replaced with U+FFFD each.
+    /// @param out the output buffer of at least 6 bytes
+    /// @return    pointer to the end of the written data
+    Character* finish(Character* out) noexcept;
+
+  private:
+    bool      _big_endian;
+    bool      _odd  = false;  // a byte of a code unit is carried
+    Character _byte = {};     // the carried byte
+    char16_t  _high = 0;      // the unpaired high surrogate (0 if there is none)
+  };
+
+
+  /// @brief               Get the UTF-8 text of a source file: the byte order mark is skipped, UTF-16 is transcoded.
+  /// @param input         the file contents
+  /// @param buffer        receives the transcoded text followed by padding_bytes zeros if the file is UTF-16
+  /// @param padding_bytes how many zero bytes should follow the transcoded text
+  /// @return              the text: the buffer contents if the file has been transcoded, otherwise a part of input
+  [[nodiscard]] String_view decode_text(String_view input, String& buffer, size_t padding_bytes = 0);
+
+  /// @brief        Get the UTF-8 text of the head of a file like decode_text (a truncated character is dropped).
+  /// @param head   the first bytes of the file
+  /// @param buffer the output buffer of at least Utf16_transcoder::max_output_size(head.size()) bytes
+  /// @return       the text: a part of the buffer if the head has been transcoded, otherwise a part of head
+  [[nodiscard]] String_view decode_head(String_view head, Character* buffer) noexcept;
+
+}
+
+#endif//SRCSTATS_UTF8_HPP_INCLUDED
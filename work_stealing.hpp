@@ -0,0 +1,248 @@
+/******************************************************************************
+MIT License
+
+Copyright (c) 2024 Dmitry R. Kuvshinov
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+******************************************************************************/
+
+/// @file   work_stealing.hpp
+/// @brief  A simple work-stealing thread pool: per-worker task deques, idle workers steal from others.
+/// @author D.R.Kuvshinov kuvshinovdr at yandex.ru
+#ifndef SRCSTATS_WORK_STEALING_HPP_INCLUDED
+#define SRCSTATS_WORK_STEALING_HPP_INCLUDED
+
+#include "basic.hpp"
+
+#include <cstddef>
+#include <atomic>
+#include <mutex>
+#include <deque>
+#include <vector>
+#include <memory>
+#include <optional>
+#include <thread>
+
+
+namespace srcstats
+{
+
+  /// @brief        A task deque owned by a worker: the owner works at the back (LIFO), thieves take from the front.
+  /// @tparam Task  task type
+  template <typename Task>
+  class Work_deque
+  {
+  public:
+    /// @brief Put a new task to the back of the deque.
+    void push(Task task)
+    {
+      std::scoped_lock lock(_mutex);
+      _tasks.push_back(std::move(task));
+    }
+
+    /// @brief Take the most recently pushed task (used by the owner).
+    [[nodiscard]] std::optional<Task> pop()
+    {
+      std::scoped_lock lock(_mutex);
+      if (_tasks.empty())
+        return std::nullopt;
+
+      std::optional<Task> result(std::move(_tasks.back()));
+      _tasks.pop_back();
+      return result;
+    }
+
+    /// @brief Take the oldest task (used by the thieves).
+    [[nodiscard]] std::optional<Task> steal()
+    {
+      std::scoped_lock lock(_mutex);
+      if (_tasks.empty())
+        return std::nullopt;
+
+      std::optional<Task> result(std::move(_tasks.front()));
+      _tasks.pop_front();
+      return result;
+    }
+
+    /// @brief Check if there are no tasks.
+    [[nodiscard]] bool is_empty()
+    {
+      std::scoped_lock lock(_mutex);
+      return _tasks.empty();
+    }
+
+  private:
+    std::mutex       _mutex;
+    std::deque<Task> _tasks;
+  };
+
+
+  /// @brief        Run tasks on a fixed count of workers, each worker having its own deque.
+  /// Tasks may spawn new tasks (e.g. a directory task spawns its subdirectories and files).
+  /// The pool finishes when there are no pending tasks left. Each worker counts the tasks it has pushed 
+  /// and finished in its own cache line, the counters of all the workers are summed only by idle workers.
+  /// Workers finding no task to take sleep until a task is pushed or the pool finishes.
+  /// @tparam Task  task type
+  template <typename Task>
+  class Work_stealing_pool
+  {
+  public:
+    /// @brief         Create a pool.
+    /// @param workers how many workers are to be used (at least one)
+    explicit Work_stealing_pool(size_t workers)
+      : _shards(workers != 0 ? workers : 1) {}
+
+    /// @brief Get the count of the workers.
+    [[nodiscard]] size_t size() const noexcept
+    {
+      return _shards.size();
+    }
+
+    /// @brief        Add a task to the given worker's deque.
+    /// @param worker the index of the worker (pass the current worker index from inside a task, 
+    ///               other workers' deques may be used only before run)
+    /// @param task   the task object
+    void push(size_t worker, Task task)
+    {
+      auto& shard = _shards[worker];
+      shard.pushed.fetch_add(1);
+      shard.deque.push(std::move(task));
+
+      // Pairs with the fence in _sleep: either the sleeping worker finds the task or it is counted here.
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+      if (_sleeping.load(std::memory_order_relaxed) != 0)
+        _wake(false);
+    }
+
+    /// @brief         Process all tasks until none are left.
+    /// Worker 0 runs on the calling thread, so a single worker pool does not start any threads.
+    /// @param process functional object called as process(worker_index, task), it should not throw
+    template <typename Process>
+    void run(Process process)
+    {
+      std::vector<std::jthread> threads;
+      threads.reserve(size() - 1);
+      for (size_t worker = 1; worker < size(); ++worker)
+        threads.emplace_back([this, worker, &process] { _work(worker, process); });
+
+      _work(0, process);
+    }
+
+  private:
+    /// @brief The deque of a worker and its counters written by the worker only.
+    struct alignas(cache_line_size) Shard
+    {
+      Work_deque<Task>    deque;
+      std::atomic<size_t> pushed   = 0;
+      std::atomic<size_t> finished = 0;
+    };
+
+    std::vector<Shard> _shards;
+
+    /// @brief Idle workers' count and the counter they wait on (changed to wake them).
+    alignas(cache_line_size)
+    std::atomic<size_t>   _sleeping = 0;
+    std::atomic<unsigned> _wakeups  = 0;
+
+    /// @brief Get the next task: own one first, then try to steal from the others.
+    [[nodiscard]] std::optional<Task> _next(size_t worker)
+    {
+      if (auto task = _shards[worker].deque.pop())
+        return task;
+
+      for (size_t i = 1; i < size(); ++i)
+        if (auto task = _shards[(worker + i) % size()].deque.steal())
+          return task;
+
+      return std::nullopt;
+    }
+
+    /// @brief Check if all the pushed tasks have been finished.
+    /// The finished counters are read before the pushed ones: a task is pushed before it is finished, 
+    /// so it is never counted finished and not pushed. A task pending when the finished counters 
+    /// have been read is counted pushed, or it is pushed later by a pending task counted pushed, 
+    /// so the sums are equal only if there are no pending tasks.
+    [[nodiscard]] bool _is_finished() const noexcept
+    {
+      size_t finished = 0, pushed = 0;
+      for (auto& shard: _shards)
+        finished += shard.finished.load();
+      for (auto& shard: _shards)
+        pushed += shard.pushed.load();
+      return finished == pushed;
+    }
+
+    /// @brief Wake one sleeping worker (a task has been pushed) or all of them (the pool has finished).
+    void _wake(bool all) noexcept
+    {
+      _wakeups.fetch_add(1);
+      if (all)
+        _wakeups.notify_all();
+      else
+        _wakeups.notify_one();
+    }
+
+    /// @brief Check if any deque has a task.
+    [[nodiscard]] bool _has_tasks()
+    {
+      for (auto& shard: _shards)
+        if (!shard.deque.is_empty())
+          return true;
+      return false;
+    }
+
+    /// @brief Sleep until a task is pushed or the pool finishes unless it has happened already.
+    void _sleep()
+    {
+      _sleeping.fetch_add(1);
+      std::atomic_thread_fence(std::memory_order_seq_cst);
+
+      auto const wakeups = _wakeups.load();
+      if (!_has_tasks() && !_is_finished())
+        _wakeups.wait(wakeups);
+
+      _sleeping.fetch_sub(1);
+    }
+
+    template <typename Process>
+    void _work(size_t worker, Process& process)
+    {
+      for (auto& shard = _shards[worker];;)
+      {
+        if (auto task = _next(worker))
+        {
+          process(worker, *task);
+          shard.finished.fetch_add(1);
+        }
+        else if (_is_finished())
+        {
+          _wake(true);
+          break;
+        }
+        else
+        {
+          _sleep();
+        }
+      }
+    }
+  };
+
+}
+
+#endif//SRCSTATS_WORK_STEALING_HPP_INCLUDED